@@ -0,0 +1,172 @@
+//Cost of bringing in a large layer and bandwidth of parallel passes over it depending on how its pages were
+//allocated. The serial case is what a plain std::vector<float>::resize does, every page is faulted in and
+//zeroed by one thread, the first touch cases fault them in from all the pool workers.
+#include "worldgen/utils/layerAllocator.h"
+#include "worldgen/utils/threadPool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+
+namespace chrono=std::chrono;
+
+using worldgen::HugePages;
+using worldgen::LayerBuffer;
+using worldgen::LayerMemoryPolicy;
+
+struct Scenario
+{
+    const char *name;
+    LayerMemoryPolicy policy;
+};
+
+struct Result
+{
+    std::string name;
+    double initMs;
+    double readGBs;
+    double writeGBs;
+};
+
+//floats per parallelFor chunk, same order as the generator bands
+constexpr size_t Grain=64*4096;
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, std::milli>(chrono::steady_clock::now()-start).count();
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size()/2];
+}
+
+Result run(const Scenario &scenario, size_t count, int repeats)
+{
+    worldgen::ThreadPool &pool=worldgen::ThreadPool::global();
+    Result result;
+
+    result.name=scenario.name;
+    worldgen::setLayerMemoryPolicy(scenario.policy);
+
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+    LayerBuffer layer(count);
+
+    if(!scenario.policy.parallelFirstTouch)
+        std::fill(layer.begin(), layer.end(), 0.0f);
+    result.initMs=elapsedMs(start);
+
+    double bytes=(double)count*sizeof(float);
+    std::vector<double> readMs;
+    std::vector<double> writeMs;
+    std::atomic<double> sink(0.0);
+
+    for(int i=0; i<repeats; ++i)
+    {
+        start=chrono::steady_clock::now();
+        pool.parallelFor(0, count, Grain, [&layer, i](size_t begin, size_t end)
+            {
+                for(size_t j=begin; j<end; ++j)
+                    layer[j]=(float)(i+j);
+            });
+        writeMs.push_back(elapsedMs(start));
+
+        start=chrono::steady_clock::now();
+        pool.parallelFor(0, count, Grain, [&layer, &sink](size_t begin, size_t end)
+            {
+                float sum=0.0f;
+
+                for(size_t j=begin; j<end; ++j)
+                    sum+=layer[j];
+
+                double expected=sink.load();
+                while(!sink.compare_exchange_weak(expected, expected+sum));
+            });
+        readMs.push_back(elapsedMs(start));
+    }
+
+    result.readGBs=bytes/(median(readMs)*1e6);
+    result.writeGBs=bytes/(median(writeMs)*1e6);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    size_t sizeMiB=1024;
+    int repeats=10;
+    size_t threads=0;
+    std::string jsonFile;
+
+    for(int i=1; i<argc; ++i)
+    {
+        std::string arg=argv[i];
+        bool hasValue=(i+1<argc);
+
+        if((arg=="--size")&&hasValue)
+            sizeMiB=(size_t)std::max(atoi(argv[++i]), 1);
+        else if((arg=="--repeats")&&hasValue)
+            repeats=std::max(atoi(argv[++i]), 1);
+        else if((arg=="--threads")&&hasValue)
+            threads=(size_t)std::max(atoi(argv[++i]), 0);
+        else if((arg=="--json")&&hasValue)
+            jsonFile=argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--size <MiB>] [--repeats <count>] [--threads <count>] [--json <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    worldgen::ThreadPool::setGlobalThreads(threads);
+
+    std::vector<Scenario> scenarios=
+    {
+        {"serial", {HugePages::Off, false}},
+        {"firstTouch", {HugePages::Off, true}},
+        {"firstTouchTransparent", {HugePages::Transparent, true}},
+        {"firstTouchExplicit", {HugePages::Explicit, true}}
+    };
+
+    size_t count=sizeMiB*1024*1024/sizeof(float);
+    std::vector<Result> results;
+
+    printf("%zu MiB layer, %zu threads, median of %d\n", sizeMiB, worldgen::ThreadPool::global().size(), repeats);
+    printf("%-24s %10s %12s %12s\n", "scenario", "init ms", "read GB/s", "write GB/s");
+
+    for(const Scenario &scenario:scenarios)
+    {
+        results.push_back(run(scenario, count, repeats));
+
+        const Result &result=results.back();
+
+        printf("%-24s %10.1f %12.2f %12.2f\n", result.name.c_str(), result.initMs, result.readGBs, result.writeGBs);
+    }
+
+    if(!jsonFile.empty())
+    {
+        FILE *file=fopen(jsonFile.c_str(), "w");
+
+        if(!file)
+        {
+            fprintf(stderr, "failed to write %s\n", jsonFile.c_str());
+            return 1;
+        }
+
+        fprintf(file, "{\n    \"sizeMiB\": %zu,\n    \"threads\": %zu,\n    \"repeats\": %d,\n    \"scenarios\": [\n", sizeMiB, worldgen::ThreadPool::global().size(), repeats);
+        for(size_t i=0; i<results.size(); ++i)
+        {
+            const Result &result=results[i];
+
+            fprintf(file, "        {\"name\": \"%s\", \"initMs\": %.3f, \"readGBs\": %.3f, \"writeGBs\": %.3f}%s\n", result.name.c_str(),
+                result.initMs, result.readGBs, result.writeGBs, (i+1<results.size())?",":"");
+        }
+        fprintf(file, "    ]\n}\n");
+        fclose(file);
+    }
+    return 0;
+}
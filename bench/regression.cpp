@@ -0,0 +1,705 @@
+//End to end regression runner. Each scenario is a fixed world (size and seed) taken through create, save,
+//load and bulk chunk generation. Every step records wall and cpu time, peak rss and allocation counts,
+//--record stores the run as a baseline and --compare fails (exit 2) when a step got slower or bigger than
+//the baseline by more than the tolerance.
+#include "worldgen/generators/equiRectWorldGenerator.h"
+#include "worldgen/io/stdFileIO.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/layerAllocator.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/prettywriter.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <filesystem>
+#include <new>
+#ifdef __linux__
+#include <fstream>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace chrono=std::chrono;
+
+typedef generic::io::fs<worldgen::StdFileIO> fs;
+
+enum ExitCode
+{
+    Success=0,
+    UsageError=1,
+    Regression=2,
+    RunError=3
+};
+
+//every operator new of the process, the library included since it is linked statically
+std::atomic<size_t> g_allocations(0);
+
+void *operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void *data=std::malloc(size?size:1);
+
+    if(!data)
+        throw std::bad_alloc();
+    return data;
+}
+
+void operator delete(void *data) noexcept
+{
+    std::free(data);
+}
+
+void operator delete(void *data, size_t) noexcept
+{
+    std::free(data);
+}
+
+struct Scenario
+{
+    const char *name;
+    int influenceWidth;
+    int seed;
+    size_t chunkCount;
+};
+
+const std::vector<Scenario> g_scenarios=
+{
+    {"small", 256, 1, 4096},
+    {"medium", 512, 2, 8192},
+    {"large", 1024, 3, 16384}
+};
+
+struct Metrics
+{
+    double wallMs=0.0;
+    double cpuMs=0.0;
+    size_t peakRssKiB=0;
+    size_t allocations=0;
+    size_t layerAllocations=0;
+};
+
+struct StageResult
+{
+    std::string name;
+    double wallMs;
+};
+
+struct StepResult
+{
+    std::string name;
+    Metrics metrics;
+    //generator stages of the step, only create has them
+    std::vector<StageResult> stages;
+};
+
+struct ScenarioResult
+{
+    std::string name;
+    std::vector<StepResult> steps;
+};
+
+struct Options
+{
+    std::vector<std::string> scenarios={"small", "medium"};
+    int repeats=3;
+    size_t threads=0;
+    double tolerance=0.10;
+    double memoryTolerance=0.10;
+    //differences below these are noise whatever the ratio
+    double minMs=5.0;
+    size_t minAllocations=64;
+    std::string recordFile;
+    std::string compareFile;
+    std::string workDirectory;
+};
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, std::milli>(chrono::steady_clock::now()-start).count();
+}
+
+//process time of all threads
+double cpuMs()
+{
+    return 1000.0*(double)std::clock()/CLOCKS_PER_SEC;
+}
+
+//so the peak read after a step is the peak of that step, the process peak otherwise
+void resetPeakRss()
+{
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+
+    if(clearRefs)
+        clearRefs<<"5";
+#endif
+}
+
+size_t peakRssKiB()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+
+    while(std::getline(status, line))
+    {
+        if(line.compare(0, 6, "VmHWM:")==0)
+            return (size_t)strtoull(line.c_str()+6, nullptr, 10);
+    }
+#endif
+#ifndef _WIN32
+    rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage)==0)
+    {
+#ifdef __APPLE__
+        return (size_t)usage.ru_maxrss/1024;
+#else
+        return (size_t)usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+bool measure(const std::function<bool()> &step, Metrics &metrics)
+{
+    resetPeakRss();
+
+    size_t allocations=g_allocations.load(std::memory_order_relaxed);
+    size_t layerAllocations=worldgen::getLayerAllocationCount();
+    double cpuStart=cpuMs();
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+
+    bool result=step();
+
+    metrics.wallMs=elapsedMs(start);
+    metrics.cpuMs=cpuMs()-cpuStart;
+    metrics.peakRssKiB=peakRssKiB();
+    metrics.allocations=g_allocations.load(std::memory_order_relaxed)-allocations;
+    metrics.layerAllocations=worldgen::getLayerAllocationCount()-layerAllocations;
+    return result;
+}
+
+worldgen::WorldDescriptors makeDescriptors(const Scenario &scenario)
+{
+    worldgen::WorldDescriptors descriptors;
+    int gridSize=4096;
+
+    descriptors.setSize(glm::ivec3(scenario.influenceWidth*gridSize, scenario.influenceWidth/2*gridSize, 2560));
+    descriptors.setRegionSize(glm::ivec3(16, 16, 16));
+    descriptors.setChunkSize(glm::ivec3(64, 64, 16));
+    //everything else is derived from the size, as for a new world in the cli
+    descriptors.getGeneratorArgs()="{\"seed\": "+std::to_string(scenario.seed)+"}";
+    return descriptors;
+}
+
+//keeps the chunk heights alive so the lookups are not optimized out
+volatile size_t g_heightSink;
+
+//chunks spread over the whole world from a fixed seed, each gets its column heights and generateChunk
+bool generateChunks(worldgen::EquiRectWorldGenerator &generator, const worldgen::WorldDescriptors &descriptors, const Scenario &scenario)
+{
+    glm::ivec3 worldSize=descriptors.getSize();
+    glm::ivec3 chunkSize=descriptors.getChunkSize();
+    glm::ivec2 chunks(worldSize.x/chunkSize.x, worldSize.y/chunkSize.y);
+    std::mt19937 random(scenario.seed);
+    std::uniform_int_distribution<int> xDistribution(0, chunks.x-1);
+    std::uniform_int_distribution<int> yDistribution(0, chunks.y-1);
+    std::vector<glm::vec3> starts(scenario.chunkCount);
+
+    for(glm::vec3 &start:starts)
+        start=glm::vec3(xDistribution(random)*chunkSize.x, yDistribution(random)*chunkSize.y, 0.0f);
+
+    size_t columns=(size_t)chunkSize.x*chunkSize.y;
+    size_t bufferSize=columns*chunkSize.z*sizeof(uint32_t);
+    std::atomic<size_t> heightSum(0);
+
+    worldgen::ThreadPool::global().parallelFor(0, starts.size(), 16, [&](size_t begin, size_t end)
+        {
+            std::vector<glm::vec2> positions(columns);
+            std::vector<int> heights(columns);
+            std::vector<uint8_t> buffer(bufferSize);
+            size_t sum=0;
+
+            for(size_t i=begin; i<end; ++i)
+            {
+                const glm::vec3 &start=starts[i];
+
+                for(int y=0; y<chunkSize.y; ++y)
+                {
+                    for(int x=0; x<chunkSize.x; ++x)
+                        positions[y*chunkSize.x+x]=glm::vec2(start.x+x, start.y+y);
+                }
+
+                generator.getBaseHeights(positions.data(), heights.data(), columns);
+                generator.generateChunk(start, chunkSize, buffer.data(), buffer.size(), 0);
+
+                for(int height:heights)
+                    sum+=(size_t)std::max(height, 0);
+            }
+            heightSum.fetch_add(sum, std::memory_order_relaxed);
+        });
+
+    g_heightSink=heightSum.load();
+    return true;
+}
+
+bool runScenario(const Scenario &scenario, const std::string &directory, std::vector<StepResult> &steps)
+{
+    worldgen::WorldDescriptors descriptors=makeDescriptors(scenario);
+    worldgen::Progress createProgress;
+    worldgen::Progress loadProgress;
+    StepResult create, save, load, chunks;
+
+    create.name="create";
+    save.name="save";
+    load.name="load";
+    chunks.name="chunks";
+
+    {
+        worldgen::EquiRectWorldGenerator generator;
+
+        //same as the cli, only the overview survives create
+        generator.setLayerRetention(worldgen::LayerRetention::None);
+
+        if(!measure([&]() { return generator.create(&descriptors, createProgress); }, create.metrics))
+            return false;
+
+        for(const worldgen::StageTiming &timing:generator.getStageTimings())
+            create.stages.push_back({timing.name, timing.ms});
+
+        if(!measure([&]() { return generator.save<worldgen::StdFileIO>(directory); }, save.metrics))
+            return false;
+    }
+
+    worldgen::EquiRectWorldGenerator generator;
+
+    if(!measure([&]() { return generator.load<worldgen::StdFileIO>(&descriptors, directory, loadProgress); }, load.metrics))
+        return false;
+
+    if(!measure([&]() { return generateChunks(generator, descriptors, scenario); }, chunks.metrics))
+        return false;
+
+    steps={create, save, load, chunks};
+    return true;
+}
+
+template<typename _Type, typename _Get>
+_Type medianOf(const std::vector<std::vector<StepResult>> &runs, size_t step, _Get get)
+{
+    std::vector<_Type> values;
+
+    for(const std::vector<StepResult> &run:runs)
+        values.push_back(get(run[step]));
+    std::sort(values.begin(), values.end());
+    return values[values.size()/2];
+}
+
+//median of every metric over the repeats, peak rss as the largest seen
+StepResult combine(const std::vector<std::vector<StepResult>> &runs, size_t step)
+{
+    StepResult result;
+    const StepResult &first=runs[0][step];
+
+    result.name=first.name;
+    result.metrics.wallMs=medianOf<double>(runs, step, [](const StepResult &value) { return value.metrics.wallMs; });
+    result.metrics.cpuMs=medianOf<double>(runs, step, [](const StepResult &value) { return value.metrics.cpuMs; });
+    result.metrics.allocations=medianOf<size_t>(runs, step, [](const StepResult &value) { return value.metrics.allocations; });
+    result.metrics.layerAllocations=medianOf<size_t>(runs, step, [](const StepResult &value) { return value.metrics.layerAllocations; });
+
+    for(const std::vector<StepResult> &run:runs)
+        result.metrics.peakRssKiB=std::max(result.metrics.peakRssKiB, run[step].metrics.peakRssKiB);
+
+    for(size_t i=0; i<first.stages.size(); ++i)
+    {
+        std::vector<double> values;
+
+        for(const std::vector<StepResult> &run:runs)
+        {
+            if(i<run[step].stages.size())
+                values.push_back(run[step].stages[i].wallMs);
+        }
+        std::sort(values.begin(), values.end());
+        result.stages.push_back({first.stages[i].name, values[values.size()/2]});
+    }
+    return result;
+}
+
+bool writeResults(const std::string &fileName, const Options &options, const std::vector<ScenarioResult> &results)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+    writer.StartObject();
+    writer.Key("version");
+    writer.Int(1);
+    writer.Key("threads");
+    writer.Uint64(worldgen::ThreadPool::global().size());
+    writer.Key("repeats");
+    writer.Int(options.repeats);
+    writer.Key("scenarios");
+    writer.StartArray();
+    for(const ScenarioResult &scenario:results)
+    {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(scenario.name.c_str());
+        writer.Key("steps");
+        writer.StartArray();
+        for(const StepResult &step:scenario.steps)
+        {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(step.name.c_str());
+            writer.Key("wallMs");
+            writer.Double(step.metrics.wallMs);
+            writer.Key("cpuMs");
+            writer.Double(step.metrics.cpuMs);
+            writer.Key("peakRssKiB");
+            writer.Uint64(step.metrics.peakRssKiB);
+            writer.Key("allocations");
+            writer.Uint64(step.metrics.allocations);
+            writer.Key("layerAllocations");
+            writer.Uint64(step.metrics.layerAllocations);
+            writer.Key("stages");
+            writer.StartArray();
+            for(const StageResult &stage:step.stages)
+            {
+                writer.StartObject();
+                writer.Key("name");
+                writer.String(stage.name.c_str());
+                writer.Key("wallMs");
+                writer.Double(stage.wallMs);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    FILE *file=fopen(fileName.c_str(), "w");
+
+    if(!file)
+        return false;
+
+    size_t written=fwrite(buffer.GetString(), 1, buffer.GetSize(), file);
+
+    fclose(file);
+    return (written==buffer.GetSize());
+}
+
+bool readBaseline(const std::string &fileName, std::vector<ScenarioResult> &baseline)
+{
+    FILE *file=fopen(fileName.c_str(), "rb");
+
+    if(!file)
+        return false;
+
+    std::string json;
+    char chunk[4096];
+    size_t read;
+
+    while((read=fread(chunk, 1, sizeof(chunk), file))>0)
+        json.append(chunk, read);
+    fclose(file);
+
+    rapidjson::Document document;
+
+    document.Parse(json.c_str());
+
+    if(document.HasParseError()||!document.IsObject()||!document.HasMember("scenarios")||!document["scenarios"].IsArray())
+        return false;
+
+    const rapidjson::Value &scenarios=document["scenarios"];
+
+    for(rapidjson::SizeType i=0; i<scenarios.Size(); ++i)
+    {
+        const rapidjson::Value &scenarioValue=scenarios[i];
+        const rapidjson::Value &steps=scenarioValue["steps"];
+        ScenarioResult scenario;
+
+        scenario.name=scenarioValue["name"].GetString();
+        for(rapidjson::SizeType j=0; j<steps.Size(); ++j)
+        {
+            const rapidjson::Value &stepValue=steps[j];
+            const rapidjson::Value &stages=stepValue["stages"];
+            StepResult step;
+
+            step.name=stepValue["name"].GetString();
+            step.metrics.wallMs=stepValue["wallMs"].GetDouble();
+            step.metrics.cpuMs=stepValue["cpuMs"].GetDouble();
+            step.metrics.peakRssKiB=(size_t)stepValue["peakRssKiB"].GetUint64();
+            step.metrics.allocations=(size_t)stepValue["allocations"].GetUint64();
+            step.metrics.layerAllocations=(size_t)stepValue["layerAllocations"].GetUint64();
+
+            for(rapidjson::SizeType k=0; k<stages.Size(); ++k)
+                step.stages.push_back({stages[k]["name"].GetString(), stages[k]["wallMs"].GetDouble()});
+            scenario.steps.push_back(step);
+        }
+        baseline.push_back(scenario);
+    }
+    return true;
+}
+
+class Comparison
+{
+public:
+    Comparison(const Options &options):m_options(options), m_regressions(0) {}
+
+    void time(const std::string &name, double baseline, double current)
+    {
+        bool regressed=(current>baseline*(1.0+m_options.tolerance))&&(current-baseline>m_options.minMs);
+
+        report(name, baseline, current, regressed);
+    }
+
+    void memory(const std::string &name, size_t baseline, size_t current)
+    {
+        report(name, (double)baseline, (double)current, current>baseline*(1.0+m_options.memoryTolerance));
+    }
+
+    void count(const std::string &name, size_t baseline, size_t current)
+    {
+        bool regressed=(current>baseline*(1.0+m_options.tolerance))&&(current-baseline>m_options.minAllocations);
+
+        report(name, (double)baseline, (double)current, regressed);
+    }
+
+    int regressions() const { return m_regressions; }
+
+private:
+    void report(const std::string &name, double baseline, double current, bool regressed)
+    {
+        double change=(baseline>0.0)?100.0*(current-baseline)/baseline:0.0;
+
+        printf("%-44s %14.1f %14.1f %+8.1f%% %s\n", name.c_str(), baseline, current, change, regressed?"REGRESSED":"ok");
+        if(regressed)
+            m_regressions++;
+    }
+
+    const Options &m_options;
+    int m_regressions;
+};
+
+int compare(const Options &options, const std::vector<ScenarioResult> &baseline, const std::vector<ScenarioResult> &results)
+{
+    Comparison comparison(options);
+
+    printf("\n%-44s %14s %14s %9s\n", "metric", "baseline", "current", "change");
+
+    for(const ScenarioResult &scenario:results)
+    {
+        std::vector<ScenarioResult>::const_iterator baseScenario=std::find_if(baseline.begin(), baseline.end(),
+            [&scenario](const ScenarioResult &value) { return value.name==scenario.name; });
+
+        if(baseScenario==baseline.end())
+        {
+            printf("%s: not in the baseline\n", scenario.name.c_str());
+            continue;
+        }
+
+        for(const StepResult &step:scenario.steps)
+        {
+            std::vector<StepResult>::const_iterator baseStep=std::find_if(baseScenario->steps.begin(), baseScenario->steps.end(),
+                [&step](const StepResult &value) { return value.name==step.name; });
+
+            if(baseStep==baseScenario->steps.end())
+                continue;
+
+            std::string prefix=scenario.name+"/"+step.name;
+
+            comparison.time(prefix+" wallMs", baseStep->metrics.wallMs, step.metrics.wallMs);
+            comparison.time(prefix+" cpuMs", baseStep->metrics.cpuMs, step.metrics.cpuMs);
+            comparison.memory(prefix+" peakRssKiB", baseStep->metrics.peakRssKiB, step.metrics.peakRssKiB);
+            comparison.count(prefix+" allocations", baseStep->metrics.allocations, step.metrics.allocations);
+            comparison.count(prefix+" layerAllocations", baseStep->metrics.layerAllocations, step.metrics.layerAllocations);
+
+            for(const StageResult &stage:step.stages)
+            {
+                for(const StageResult &baseStage:baseStep->stages)
+                {
+                    if(baseStage.name==stage.name)
+                        comparison.time(prefix+"/"+stage.name+" wallMs", baseStage.wallMs, stage.wallMs);
+                }
+            }
+        }
+    }
+
+    if(comparison.regressions()>0)
+    {
+        printf("\n%d regressions over %.0f%%\n", comparison.regressions(), 100.0*options.tolerance);
+        return Regression;
+    }
+    printf("\nno regressions\n");
+    return Success;
+}
+
+std::vector<std::string> parseList(const char *value)
+{
+    std::vector<std::string> values;
+    std::stringstream stream(value);
+    std::string item;
+
+    while(std::getline(stream, item, ','))
+    {
+        if(!item.empty())
+            values.push_back(item);
+    }
+    return values;
+}
+
+void printUsage(const char *name)
+{
+    fprintf(stderr, "usage: %s [options]\n", name);
+    fprintf(stderr, "  --scenarios <list>        comma separated, from small, medium, large (default small,medium)\n");
+    fprintf(stderr, "  --repeats <count>         runs per scenario, medians are kept (default 3)\n");
+    fprintf(stderr, "  --threads <count>         worker threads, 0 uses the hardware concurrency\n");
+    fprintf(stderr, "  --record <file>           write this run as a baseline\n");
+    fprintf(stderr, "  --compare <file>          compare against a baseline, exits with 2 on a regression\n");
+    fprintf(stderr, "  --tolerance <fraction>    allowed slowdown and allocation growth (default 0.10)\n");
+    fprintf(stderr, "  --memory-tolerance <f>    allowed peak rss growth (default 0.10)\n");
+    fprintf(stderr, "  --min-ms <ms>             time differences below this never fail (default 5)\n");
+    fprintf(stderr, "  --work-dir <directory>    where worlds are saved and loaded (default a temp directory)\n");
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for(int i=1; i<argc; ++i)
+    {
+        std::string arg=argv[i];
+        bool hasValue=(i+1<argc);
+
+        if((arg=="--scenarios")&&hasValue)
+            options.scenarios=parseList(argv[++i]);
+        else if((arg=="--repeats")&&hasValue)
+            options.repeats=std::max(atoi(argv[++i]), 1);
+        else if((arg=="--threads")&&hasValue)
+            options.threads=(size_t)std::max(atoi(argv[++i]), 0);
+        else if((arg=="--record")&&hasValue)
+            options.recordFile=argv[++i];
+        else if((arg=="--compare")&&hasValue)
+            options.compareFile=argv[++i];
+        else if((arg=="--tolerance")&&hasValue)
+            options.tolerance=std::max(atof(argv[++i]), 0.0);
+        else if((arg=="--memory-tolerance")&&hasValue)
+            options.memoryTolerance=std::max(atof(argv[++i]), 0.0);
+        else if((arg=="--min-ms")&&hasValue)
+            options.minMs=std::max(atof(argv[++i]), 0.0);
+        else if((arg=="--work-dir")&&hasValue)
+            options.workDirectory=argv[++i];
+        else
+        {
+            printUsage(argv[0]);
+            return UsageError;
+        }
+    }
+
+    std::vector<Scenario> scenarios;
+
+    for(const std::string &name:options.scenarios)
+    {
+        std::vector<Scenario>::const_iterator iter=std::find_if(g_scenarios.begin(), g_scenarios.end(),
+            [&name](const Scenario &scenario) { return name==scenario.name; });
+
+        if(iter==g_scenarios.end())
+        {
+            fprintf(stderr, "unknown scenario %s\n", name.c_str());
+            return UsageError;
+        }
+        scenarios.push_back(*iter);
+    }
+
+    std::vector<ScenarioResult> baseline;
+
+    //read first, a bad baseline should not cost a full run
+    if(!options.compareFile.empty()&&!readBaseline(options.compareFile, baseline))
+    {
+        fprintf(stderr, "failed to read baseline %s\n", options.compareFile.c_str());
+        return UsageError;
+    }
+
+    worldgen::ThreadPool::setGlobalThreads(options.threads);
+
+    bool tempDirectory=options.workDirectory.empty();
+
+    if(tempDirectory)
+        options.workDirectory=(std::filesystem::temp_directory_path()/"worldgen_regression").string();
+    if(!fs::exists(options.workDirectory))
+        fs::create_directory(options.workDirectory);
+
+    std::vector<ScenarioResult> results;
+
+    printf("%zu threads, %d repeats\n", worldgen::ThreadPool::global().size(), options.repeats);
+
+    for(const Scenario &scenario:scenarios)
+    {
+        std::string directory=options.workDirectory+"/"+scenario.name;
+        std::vector<std::vector<StepResult>> runs(options.repeats);
+
+        if(!fs::exists(directory))
+            fs::create_directory(directory);
+
+        for(int i=0; i<options.repeats; ++i)
+        {
+            if(!runScenario(scenario, directory, runs[i]))
+            {
+                fprintf(stderr, "scenario %s failed\n", scenario.name);
+                return RunError;
+            }
+        }
+
+        ScenarioResult result;
+
+        result.name=scenario.name;
+        for(size_t i=0; i<runs[0].size(); ++i)
+        {
+            result.steps.push_back(combine(runs, i));
+
+            const StepResult &step=result.steps.back();
+
+            printf("%-8s %-8s wall %10.1f ms  cpu %10.1f ms  peak %8zu KiB  allocations %9zu  layer allocations %6zu\n", scenario.name, step.name.c_str(),
+                step.metrics.wallMs, step.metrics.cpuMs, step.metrics.peakRssKiB, step.metrics.allocations, step.metrics.layerAllocations);
+            for(const StageResult &stage:step.stages)
+                printf("    %-22s %10.1f ms\n", stage.name.c_str(), stage.wallMs);
+        }
+        results.push_back(result);
+    }
+
+    if(tempDirectory)
+    {
+        std::error_code error;
+
+        std::filesystem::remove_all(options.workDirectory, error);
+    }
+
+    if(!options.recordFile.empty()&&!writeResults(options.recordFile, options, results))
+    {
+        fprintf(stderr, "failed to write %s\n", options.recordFile.c_str());
+        return RunError;
+    }
+
+    if(!options.compareFile.empty())
+        return compare(options, baseline, results);
+    return Success;
+}
@@ -0,0 +1,814 @@
+//Micro benchmarks of the generator hot paths. Every case is run warmup+repeats times and reports the
+//distribution of the repeats, inputs come from a fixed seed so runs are comparable between builds.
+#include "worldgen/generators/equiRectWorldGenerator.h"
+#include "worldgen/generators/cubeSphereWorldGenerator.h"
+#include "worldgen/perturbedWeather.h"
+#include "worldgen/tectonicCurves.h"
+#include "worldgen/plateBoundaries.h"
+#include "worldgen/plateSeeds.h"
+#include "worldgen/plateIndex.h"
+#include "worldgen/fill.h"
+#include "worldgen/maths/coords.h"
+#include "worldgen/maths/coordsSoA.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/simdLevel.h"
+#include "testWorlds.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <limits>
+
+namespace chrono=std::chrono;
+
+using worldgen::Projections;
+using worldgen::projectPoint;
+
+struct Options
+{
+    std::vector<int> influenceWidths={256, 512, 1024};
+    int repeats=10;
+    int warmup=1;
+    size_t points=1<<20;
+    size_t threads=0;
+    //levels swept over the noise passes, empty skips the sweep
+    std::vector<worldgen::SimdLevel> simdLevels;
+    std::string filter;
+    std::string jsonFile;
+};
+
+struct Result
+{
+    std::string name;
+    std::string params;
+    //work items per repeat, 0 if the case has no natural item
+    size_t items;
+    std::vector<double> samplesMs;
+
+    double percentile(double fraction) const
+    {
+        std::vector<double> sorted=samplesMs;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        size_t index=(size_t)(fraction*(sorted.size()-1)+0.5);
+
+        return sorted[std::min(index, sorted.size()-1)];
+    }
+
+    double mean() const
+    {
+        double sum=0.0;
+
+        for(double sample:samplesMs)
+            sum+=sample;
+        return sum/samplesMs.size();
+    }
+};
+
+//keeps results alive so the measured loops are not optimized out
+volatile float g_sink;
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, std::milli>(chrono::steady_clock::now()-start).count();
+}
+
+std::vector<int> parseList(const char *value)
+{
+    std::vector<int> values;
+    std::stringstream stream(value);
+    std::string item;
+
+    while(std::getline(stream, item, ','))
+    {
+        int entry=atoi(item.c_str());
+
+        if(entry>0)
+            values.push_back(entry);
+    }
+    return values;
+}
+
+std::string sizeName(const glm::ivec2 &size)
+{
+    return std::to_string(size.x)+"x"+std::to_string(size.y);
+}
+
+class Bench
+{
+public:
+    Bench(const Options &options):m_options(options) {}
+
+    bool enabled(const std::string &name) const
+    {
+        return m_options.filter.empty()||(name.find(m_options.filter)!=std::string::npos);
+    }
+
+    //setup runs before every repeat and is not timed
+    void run(const std::string &name, const std::string &params, size_t items, const std::function<void()> &body,
+        const std::function<void()> &setup=std::function<void()>())
+    {
+        if(!enabled(name))
+            return;
+
+        Result result;
+
+        result.name=name;
+        result.params=params;
+        result.items=items;
+
+        for(int i=0; i<m_options.warmup+m_options.repeats; ++i)
+        {
+            if(setup)
+                setup();
+
+            chrono::steady_clock::time_point start=chrono::steady_clock::now();
+
+            body();
+
+            double ms=elapsedMs(start);
+
+            if(i>=m_options.warmup)
+                result.samplesMs.push_back(ms);
+        }
+
+        add(std::move(result));
+    }
+
+    //for samples measured elsewhere, e.g. the stage timings of a generation
+    void add(Result result)
+    {
+        printf("%-28s %-18s %10.3f %10.3f %10.3f %10.3f %10.3f %12.1f\n", result.name.c_str(), result.params.c_str(), result.percentile(0.0),
+            result.percentile(0.5), result.percentile(0.9), result.percentile(0.99), result.percentile(1.0), itemsPerSecond(result)/1e6);
+        fflush(stdout);
+        m_results.push_back(std::move(result));
+    }
+
+    bool writeJson(const std::string &fileName) const
+    {
+        FILE *file=fopen(fileName.c_str(), "w");
+
+        if(!file)
+            return false;
+
+        fprintf(file, "{\n    \"threads\": %zu,\n    \"repeats\": %d,\n    \"warmup\": %d,\n    \"cpuSimdLevel\": \"%s\",\n    \"results\": [\n",
+            worldgen::ThreadPool::global().size(), m_options.repeats, m_options.warmup, worldgen::simdLevelName(worldgen::resolveSimdLevel(worldgen::SimdLevel::Auto)));
+        for(size_t i=0; i<m_results.size(); ++i)
+        {
+            const Result &result=m_results[i];
+
+            fprintf(file, "        {\"name\": \"%s\", \"params\": \"%s\", \"items\": %zu, \"minMs\": %.4f, \"p50Ms\": %.4f, \"p90Ms\": %.4f, "
+                "\"p99Ms\": %.4f, \"maxMs\": %.4f, \"meanMs\": %.4f, \"itemsPerSecond\": %.1f, \"samplesMs\": [", result.name.c_str(), result.params.c_str(),
+                result.items, result.percentile(0.0), result.percentile(0.5), result.percentile(0.9), result.percentile(0.99), result.percentile(1.0),
+                result.mean(), itemsPerSecond(result));
+            for(size_t j=0; j<result.samplesMs.size(); ++j)
+                fprintf(file, "%s%.4f", (j>0)?", ":"", result.samplesMs[j]);
+            fprintf(file, "]}%s\n", (i+1<m_results.size())?",":"");
+        }
+        fprintf(file, "    ]\n}\n");
+        fclose(file);
+        return true;
+    }
+
+private:
+    static double itemsPerSecond(const Result &result)
+    {
+        double p50=result.percentile(0.5);
+
+        if((result.items==0)||(p50<=0.0))
+            return 0.0;
+        return result.items/(p50/1000.0);
+    }
+
+    const Options &m_options;
+    std::vector<Result> m_results;
+};
+
+void benchGenerator(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+
+    for(int influenceWidth:options.influenceWidths)
+    {
+        worldgen::WorldDescriptors descriptors=worldgen::makeDescriptors(influenceWidth);
+        worldgen::EquiRectWorldGenerator generator;
+        worldgen::Progress progress;
+
+        //nothing kept between repeats, every repeat runs all the stages
+        generator.setLayerRetention(worldgen::LayerRetention::None);
+        //untimed, the lookups need a neighbor map whatever the filter
+        generator.create(&descriptors, progress);
+
+        const glm::ivec2 influenceSize=generator.getInfluenceMapSize();
+        const std::string params=sizeName(influenceSize);
+        const size_t cells=(size_t)influenceSize.x*influenceSize.y;
+
+        bench.run("generatePlates", params, cells, [&]()
+            {
+                generator.generateWorldOverview(progress);
+            });
+
+        bench.run("updateInfluenceNeighbors", params, cells, [&]()
+            {
+                generator.updateInfluenceNeighbors();
+            });
+
+        glm::ivec3 worldSize=descriptors.getSize();
+        std::uniform_real_distribution<float> xDistribution(0.0f, (float)worldSize.x-1.0f);
+        std::uniform_real_distribution<float> yDistribution(0.0f, (float)worldSize.y-1.0f);
+        std::vector<glm::vec2> positions(options.points);
+        std::vector<int> heights(options.points);
+
+        for(glm::vec2 &position:positions)
+            position=glm::vec2(xDistribution(random), yDistribution(random));
+
+        bench.run("getBaseHeight", params, positions.size(), [&]()
+            {
+                int sum=0;
+
+                for(const glm::vec2 &position:positions)
+                    sum+=generator.getBaseHeight(position);
+                g_sink=(float)sum;
+            });
+
+        bench.run("getBaseHeights", params, positions.size(), [&]()
+            {
+                generator.getBaseHeights(positions.data(), heights.data(), positions.size());
+                g_sink=(float)heights.back();
+            });
+    }
+}
+
+//same worlds as benchGenerator on the cube sphere, cells are 6/8 of the equirectangular ones
+void benchCubeSphere(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+
+    for(int influenceWidth:options.influenceWidths)
+    {
+        worldgen::WorldDescriptors descriptors=worldgen::makeDescriptors(influenceWidth);
+        worldgen::CubeSphereWorldGenerator generator;
+        worldgen::Progress progress;
+
+        generator.create(&descriptors, progress);
+
+        const worldgen::CubeSphereGrid &grid=generator.getGrid();
+        const std::string params="6x"+std::to_string(grid.faceSize())+"x"+std::to_string(grid.faceSize());
+        const size_t cells=grid.cellCount();
+
+        bench.run("cubeSphere.buildGrid", params, cells, [&]()
+            {
+                worldgen::CubeSphereGrid buildGrid;
+
+                buildGrid.build(grid.faceSize(), grid.tileSize());
+                g_sink=buildGrid.center(0).x;
+            });
+
+        bench.run("cubeSphere.generateWorldOverview", params, cells, [&]()
+            {
+                generator.generateWorldOverview(progress);
+            });
+
+        glm::ivec3 worldSize=descriptors.getSize();
+        std::uniform_real_distribution<float> xDistribution(0.0f, (float)worldSize.x-1.0f);
+        std::uniform_real_distribution<float> yDistribution(0.0f, (float)worldSize.y-1.0f);
+        std::vector<glm::vec2> positions(options.points);
+        std::vector<int> heights(options.points);
+
+        for(glm::vec2 &position:positions)
+            position=glm::vec2(xDistribution(random), yDistribution(random));
+
+        bench.run("cubeSphere.getBaseHeights", params, positions.size(), [&]()
+            {
+                generator.getBaseHeights(positions.data(), heights.data(), positions.size());
+                g_sink=(float)heights.back();
+            });
+    }
+}
+
+void benchProjections(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const std::string params=std::to_string(options.points);
+
+    std::vector<glm::vec2> equirectangular(options.points);
+    std::vector<glm::vec3> spherical(options.points);
+    std::vector<glm::vec3> cartesian(options.points);
+    std::vector<glm::vec2> stereographic(options.points);
+
+    //valid inputs for every direction, built through the projections themselves
+    for(size_t i=0; i<options.points; ++i)
+    {
+        equirectangular[i]=glm::vec2(unit(random), unit(random));
+        projectPoint<Projections::Equirectangular, Projections::Spherical>(equirectangular[i], spherical[i]);
+        projectPoint<Projections::Spherical, Projections::Cartesian>(spherical[i], cartesian[i]);
+        projectPoint<Projections::Cartesian, Projections::Stereographic>(cartesian[i], stereographic[i]);
+    }
+
+    std::vector<glm::vec2> out2(options.points);
+    std::vector<glm::vec3> out3(options.points);
+
+#define WORLDGEN_BENCH_PROJECTION(_From, _To, _In, _Out) \
+    bench.run("projectPoint<"#_From","#_To">", params, options.points, [&]() \
+        { \
+            for(size_t i=0; i<options.points; ++i) \
+                projectPoint<Projections::_From, Projections::_To>(_In[i], _Out[i]); \
+            g_sink=_Out.back().x; \
+        });
+
+    WORLDGEN_BENCH_PROJECTION(Cartesian, Spherical, cartesian, out3)
+    WORLDGEN_BENCH_PROJECTION(Spherical, Cartesian, spherical, out3)
+    WORLDGEN_BENCH_PROJECTION(Spherical, Equirectangular, spherical, out2)
+    WORLDGEN_BENCH_PROJECTION(Equirectangular, Spherical, equirectangular, out3)
+    WORLDGEN_BENCH_PROJECTION(Equirectangular, Cartesian, equirectangular, out3)
+    WORLDGEN_BENCH_PROJECTION(Cartesian, Equirectangular, cartesian, out2)
+    WORLDGEN_BENCH_PROJECTION(Cartesian, Stereographic, cartesian, out2)
+    WORLDGEN_BENCH_PROJECTION(Stereographic, Cartesian, stereographic, out3)
+
+#undef WORLDGEN_BENCH_PROJECTION
+
+    //same points as structure of arrays, directly comparable with the projectPoint cases above
+    std::vector<float> u(options.points), v(options.points);
+    std::vector<float> theta(options.points), phi(options.points);
+    std::vector<float> x(options.points), y(options.points), z(options.points);
+    std::vector<float> outA(options.points), outB(options.points), outC(options.points);
+
+    for(size_t i=0; i<options.points; ++i)
+    {
+        u[i]=equirectangular[i].x;
+        v[i]=equirectangular[i].y;
+        theta[i]=spherical[i].y;
+        phi[i]=spherical[i].z;
+        x[i]=cartesian[i].x;
+        y[i]=cartesian[i].y;
+        z[i]=cartesian[i].z;
+    }
+
+    bench.run("soa.cartesianToSpherical", params, options.points, [&]()
+        {
+            worldgen::cartesianToSpherical(x.data(), y.data(), z.data(), outA.data(), outB.data(), outC.data(), options.points);
+            g_sink=outC.back();
+        });
+    bench.run("soa.sphericalToCartesian", params, options.points, [&]()
+        {
+            worldgen::sphericalToCartesian(1.0f, theta.data(), phi.data(), outA.data(), outB.data(), outC.data(), options.points);
+            g_sink=outC.back();
+        });
+    bench.run("soa.equirectangularToCartesian", params, options.points, [&]()
+        {
+            worldgen::equirectangularToCartesian(u.data(), v.data(), 1.0f, outA.data(), outB.data(), outC.data(), options.points);
+            g_sink=outC.back();
+        });
+    bench.run("soa.cartesianToEquirectangular", params, options.points, [&]()
+        {
+            worldgen::cartesianToEquirectangular(x.data(), y.data(), z.data(), outA.data(), outB.data(), options.points);
+            g_sink=outB.back();
+        });
+
+    //coordinate generation, per point against the whole grid at once
+    for(int influenceWidth:options.influenceWidths)
+    {
+        const glm::ivec2 size(influenceWidth, influenceWidth/2);
+        const size_t cells=(size_t)size.x*size.y;
+        std::vector<float> gridX(cells), gridY(cells), gridZ(cells);
+
+        bench.run("getSphericalCoords", sizeName(size), cells, [&]()
+            {
+                size_t index=0;
+
+                for(int row=0; row<size.y; ++row)
+                {
+                    for(int column=0; column<size.x; ++column)
+                    {
+                        glm::vec3 pos=worldgen::getSphericalCoords(size.x, size.y, glm::vec3(column, row, size.x/2.0f));
+
+                        gridX[index]=pos.x;
+                        gridY[index]=pos.y;
+                        gridZ[index]=pos.z;
+                        index++;
+                    }
+                }
+                g_sink=gridZ.back();
+            });
+        bench.run("soa.getSphericalCoords", sizeName(size), cells, [&]()
+            {
+                worldgen::getSphericalCoords(size.x, size.y, 0, size.y, size.x/2.0f, gridX.data(), gridY.data(), gridZ.data());
+                g_sink=gridZ.back();
+            });
+    }
+}
+
+void benchWeather(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const std::string queryParams=std::to_string(options.points);
+
+    for(int influenceWidth:options.influenceWidths)
+    {
+        glm::ivec2 influenceSize(influenceWidth, influenceWidth/2);
+
+        bench.run("PerturbedWeatherBands", sizeName(influenceSize), 0, [&]()
+            {
+                worldgen::PerturbedWeatherBands weather(1234, influenceSize, worldgen::getWeatherCells());
+
+                g_sink=weather.getMoisture(glm::vec2(0.0f, 0.0f));
+            });
+    }
+
+    //queries with the largest size, lookups do not depend on it
+    glm::ivec2 influenceSize(options.influenceWidths.back(), options.influenceWidths.back()/2);
+    worldgen::PerturbedWeatherBands weather(1234, influenceSize, worldgen::getWeatherCells());
+    std::vector<glm::vec2> latLongs(options.points);
+
+    //(longitude, latitude) as processInfluenceRows builds them
+    for(glm::vec2 &latLong:latLongs)
+    {
+        glm::vec3 sphericalPoint;
+
+        projectPoint<Projections::Equirectangular, Projections::Spherical>(glm::vec2(unit(random), unit(random)), sphericalPoint);
+        latLong=glm::vec2(sphericalPoint.y, sphericalPoint.z);
+    }
+
+    bench.run("weather.getCellIndex", queryParams, latLongs.size(), [&]()
+        {
+            size_t sum=0;
+
+            for(const glm::vec2 &latLong:latLongs)
+                sum+=weather.getCellIndex(latLong);
+            g_sink=(float)sum;
+        });
+
+    bench.run("weather.getBandIndex", queryParams, latLongs.size(), [&]()
+        {
+            size_t sum=0;
+
+            for(const glm::vec2 &latLong:latLongs)
+                sum+=weather.getBandIndex(latLong);
+            g_sink=(float)sum;
+        });
+
+    bench.run("weather.getWindDirection", queryParams, latLongs.size(), [&]()
+        {
+            glm::vec2 sum(0.0f, 0.0f);
+
+            for(const glm::vec2 &latLong:latLongs)
+                sum+=weather.getWindDirection(latLong);
+            g_sink=sum.x;
+        });
+
+    bench.run("weather.getMoisture", queryParams, latLongs.size(), [&]()
+        {
+            float sum=0.0f;
+
+            for(const glm::vec2 &latLong:latLongs)
+                sum+=weather.getMoisture(latLong);
+            g_sink=sum;
+        });
+}
+
+template<size_t _Resolution>
+void benchTectonicCurveTable(Bench &bench, const std::vector<worldgen::TectonicCurve> &curves,
+    const std::vector<float> &distances, std::vector<float> &values)
+{
+    //built at runtime here, only the generator's resolution is baked in
+    std::unique_ptr<worldgen::TectonicCurveTable<_Resolution>> table=std::make_unique<worldgen::TectonicCurveTable<_Resolution>>();
+    char params[64];
+
+    snprintf(params, sizeof(params), "%zu err=%.1e", _Resolution, table->maxError());
+    bench.run("tectonicCurves.table", params, distances.size(), [&]()
+        {
+            table->evaluate(curves.data(), distances.data(), values.data(), distances.size());
+            g_sink=values.back();
+        });
+}
+
+void benchTectonicCurves(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const std::string params=std::to_string(options.points);
+
+    std::vector<worldgen::TectonicCurve> curves(options.points);
+    std::vector<float> distances(options.points);
+    std::vector<float> values(options.points);
+
+    for(size_t i=0; i<options.points; ++i)
+    {
+        curves[i]=(worldgen::TectonicCurve)(random()%worldgen::TectonicCurveCount);
+        distances[i]=unit(random);
+    }
+
+    bench.run("tectonicCurves.analytic", params, options.points, [&]()
+        {
+            for(size_t i=0; i<options.points; ++i)
+                values[i]=worldgen::tectonicCurveValue(curves[i], distances[i]);
+            g_sink=values.back();
+        });
+
+    benchTectonicCurveTable<250>(bench, curves, distances, values);
+    benchTectonicCurveTable<1000>(bench, curves, distances, values);
+    benchTectonicCurveTable<worldgen::TectonicCurveResolution>(bench, curves, distances, values);
+    benchTectonicCurveTable<8000>(bench, curves, distances, values);
+}
+
+void benchPlateDistance(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+
+    for(int influenceWidth:options.influenceWidths)
+    {
+        int width=influenceWidth;
+        int height=influenceWidth/2;
+        size_t mapSize=(size_t)width*height;
+        std::vector<glm::ivec2> centers(16);
+        std::vector<float> plateMap(mapSize);
+        std::vector<float> distance(mapSize);
+        const std::string params=std::to_string(width)+"x"+std::to_string(height);
+
+        for(glm::ivec2 &center:centers)
+            center=glm::ivec2(random()%width, random()%height);
+
+        //closest center wrapping in x, plain voronoi cells stand in for the plate noise
+        for(int y=0; y<height; ++y)
+        {
+            for(int x=0; x<width; ++x)
+            {
+                int closest=0;
+                int closestDistance=std::numeric_limits<int>::max();
+
+                for(size_t i=0; i<centers.size(); ++i)
+                {
+                    int dx=std::abs(x-centers[i].x);
+
+                    dx=std::min(dx, width-dx);
+
+                    int d=dx*dx+(y-centers[i].y)*(y-centers[i].y);
+
+                    if(d<closestDistance)
+                    {
+                        closestDistance=d;
+                        closest=(int)i;
+                    }
+                }
+                plateMap[(size_t)y*width+x]=(float)closest/centers.size();
+            }
+        }
+
+        worldgen::PlateBoundaries boundaries;
+
+        bench.run("plateDistance.boundaries", params, mapSize, [&]()
+            {
+                boundaries.reset(width, height);
+                boundaries.addRows(plateMap.data(), 0, height);
+            });
+        bench.run("plateDistance.transform", params, mapSize, [&]()
+            {
+                worldgen::boundaryDistance(boundaries, 0, height, distance.data(), &worldgen::ThreadPool::global());
+                g_sink=distance.back();
+            });
+    }
+}
+
+void benchPlateSeeds(Bench &bench, const Options &options)
+{
+    for(int influenceWidth:options.influenceWidths)
+    {
+        int width=influenceWidth;
+        int height=influenceWidth/2;
+        size_t mapSize=(size_t)width*height;
+        std::vector<float> x(mapSize), y(mapSize), z(mapSize);
+        std::vector<float> plate(mapSize), plate2(mapSize);
+
+        worldgen::getSphericalCoords(width, height, 0, height, 1.0f, x.data(), y.data(), z.data());
+
+        for(size_t count:{16, 256, 4096})
+        {
+            worldgen::PlateSeeds seeds;
+            const std::string params=std::to_string(width)+"x"+std::to_string(height)+" "+std::to_string(count);
+
+            bench.run("plateSeeds.build", params, count, [&]()
+                {
+                    seeds.build(count, 1234, &worldgen::ThreadPool::global());
+                });
+            bench.run("plateSeeds.assign", params, mapSize, [&]()
+                {
+                    seeds.assign(x.data(), y.data(), z.data(), mapSize, plate.data(), plate2.data(), &worldgen::ThreadPool::global());
+                    g_sink=plate.back();
+                });
+
+            //same seeds through the k-d tree, exact rather than grid limited
+            worldgen::PlateIndex index;
+            std::vector<uint32_t> plates(mapSize), borderPlates(mapSize);
+
+            bench.run("plateIndex.build", params, count, [&]()
+                {
+                    index.build(seeds.positions());
+                });
+            bench.run("plateIndex.nearest2", params, mapSize, [&]()
+                {
+                    index.nearest2(x.data(), y.data(), z.data(), mapSize, plates.data(), borderPlates.data(), &worldgen::ThreadPool::global());
+                    g_sink=(float)plates.back();
+                });
+        }
+    }
+}
+
+void benchFill(Bench &bench, const Options &options)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> signedUnit(-1.0f, 1.0f);
+
+    for(int influenceWidth:options.influenceWidths)
+    {
+        glm::ivec2 size(influenceWidth, influenceWidth/2);
+        std::uniform_int_distribution<int> xDistribution(0, size.x-1);
+        std::uniform_int_distribution<int> yDistribution(0, size.y-1);
+        //one fill per cell, as the moisture sweep does for every wet cell
+        size_t count=(size_t)size.x*size.y;
+        std::vector<glm::ivec2> points(count);
+        std::vector<glm::vec2> directions(count);
+        std::vector<float> map(count);
+
+        for(size_t i=0; i<count; ++i)
+        {
+            points[i]=glm::ivec2(xDistribution(random), yDistribution(random));
+            directions[i]=glm::vec2(signedUnit(random), signedUnit(random));
+        }
+
+        bench.run("fillPoints", sizeName(size), count, [&]()
+            {
+                for(size_t i=0; i<count; ++i)
+                    worldgen::fillPoints(points[i], directions[i], map.data(), size, 0.001f);
+                g_sink=map[0];
+            },
+            [&]()
+            {
+                std::fill(map.begin(), map.end(), 0.0f);
+            });
+    }
+}
+
+//Whole overview generations with the noise pinned to each level, reported per stage so the noise passes
+//can be compared side by side. Levels the cpu lacks are skipped, FastSIMD would run them at a lower one.
+void benchSimdLevels(Bench &bench, const Options &options)
+{
+    std::vector<worldgen::SimdLevel> supported=worldgen::supportedSimdLevels();
+
+    for(worldgen::SimdLevel level:options.simdLevels)
+    {
+        if((level!=worldgen::SimdLevel::Auto)&&(std::find(supported.begin(), supported.end(), level)==supported.end()))
+        {
+            printf("%s not supported on this cpu, skipped\n", worldgen::simdLevelName(level));
+            continue;
+        }
+
+        for(int influenceWidth:options.influenceWidths)
+        {
+            worldgen::WorldDescriptors descriptors=worldgen::makeDescriptors(influenceWidth);
+            worldgen::EquiRectWorldGenerator generator;
+            worldgen::Progress progress;
+
+            descriptors.getGeneratorArgs()=std::string("{\"simdLevel\": \"")+worldgen::simdLevelName(level)+"\"}";
+            generator.loadDescriptors(&descriptors);
+            generator.setLayerRetention(worldgen::LayerRetention::None);
+
+            const glm::ivec2 influenceSize=generator.getInfluenceMapSize();
+            const size_t cells=(size_t)influenceSize.x*influenceSize.y;
+            Result overview;
+            std::map<std::string, std::vector<double>> stageSamples;
+
+            for(int i=0; i<options.warmup+options.repeats; ++i)
+            {
+                chrono::steady_clock::time_point start=chrono::steady_clock::now();
+
+                generator.generateWorldOverview(progress);
+
+                double ms=elapsedMs(start);
+
+                if(i<options.warmup)
+                    continue;
+
+                overview.samplesMs.push_back(ms);
+                for(const worldgen::StageTiming &timing:generator.getStageTimings())
+                    stageSamples[timing.name].push_back(timing.ms);
+            }
+
+            //what FastSIMD picked, differs from the request for auto
+            std::string params=sizeName(influenceSize)+"/"+worldgen::simdLevelName(generator.getSimdLevel());
+
+            overview.name="simd.generatePlates";
+            overview.params=params;
+            overview.items=cells;
+            if(bench.enabled(overview.name))
+                bench.add(overview);
+
+            for(std::pair<const std::string, std::vector<double>> &stage:stageSamples)
+            {
+                Result result;
+
+                result.name="simd.stage."+stage.first;
+                result.params=params;
+                result.items=cells;
+                result.samplesMs=std::move(stage.second);
+                if(bench.enabled(result.name))
+                    bench.add(std::move(result));
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    for(int i=1; i<argc; ++i)
+    {
+        std::string arg=argv[i];
+        bool hasValue=(i+1<argc);
+
+        if((arg=="--sizes")&&hasValue)
+            options.influenceWidths=parseList(argv[++i]);
+        else if((arg=="--repeats")&&hasValue)
+            options.repeats=std::max(atoi(argv[++i]), 1);
+        else if((arg=="--warmup")&&hasValue)
+            options.warmup=std::max(atoi(argv[++i]), 0);
+        else if((arg=="--points")&&hasValue)
+            options.points=(size_t)std::max(atoi(argv[++i]), 1);
+        else if((arg=="--threads")&&hasValue)
+            options.threads=(size_t)std::max(atoi(argv[++i]), 0);
+        else if((arg=="--simd")&&hasValue)
+        {
+            std::string levels=argv[++i];
+
+            if(levels=="all")
+                options.simdLevels=worldgen::supportedSimdLevels();
+            else
+            {
+                std::stringstream stream(levels);
+                std::string name;
+                worldgen::SimdLevel level;
+
+                while(std::getline(stream, name, ','))
+                {
+                    if(!worldgen::parseSimdLevel(name, level))
+                    {
+                        fprintf(stderr, "unknown simd level %s\n", name.c_str());
+                        return 1;
+                    }
+                    options.simdLevels.push_back(level);
+                }
+            }
+        }
+        else if((arg=="--filter")&&hasValue)
+            options.filter=argv[++i];
+        else if((arg=="--json")&&hasValue)
+            options.jsonFile=argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--sizes <influence widths, comma separated>] [--repeats <count>] [--warmup <count>] [--points <count>]\n"
+                "    [--threads <count>] [--simd <all or levels, comma separated>] [--filter <name substring>] [--json <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.influenceWidths.empty())
+    {
+        fprintf(stderr, "--sizes needs at least one width\n");
+        return 1;
+    }
+
+    worldgen::ThreadPool::setGlobalThreads(options.threads);
+
+    Bench bench(options);
+
+    printf("%zu threads, %d repeats after %d warmup, times in ms\n", worldgen::ThreadPool::global().size(), options.repeats, options.warmup);
+    printf("%-28s %-18s %10s %10s %10s %10s %10s %12s\n", "case", "params", "min", "p50", "p90", "p99", "max", "Mitems/s");
+
+    benchGenerator(bench, options);
+    benchCubeSphere(bench, options);
+    benchProjections(bench, options);
+    benchWeather(bench, options);
+    benchTectonicCurves(bench, options);
+    benchPlateDistance(bench, options);
+    benchPlateSeeds(bench, options);
+    benchFill(bench, options);
+    benchSimdLevels(bench, options);
+
+    if(!options.jsonFile.empty()&&!bench.writeJson(options.jsonFile))
+    {
+        fprintf(stderr, "failed to write %s\n", options.jsonFile.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,828 @@
+#include "worldgen/generators/equiRectWorldGenerator.h"
+#include "worldgen/io/stdFileIO.h"
+#include "worldgen/io/worldCache.h"
+#include "worldgen/render/layerRenderer.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/layerAllocator.h"
+#include "worldgen/utils/trace.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <future>
+#include <functional>
+
+namespace chrono=std::chrono;
+
+typedef worldgen::EquiRectWorldGenerator WorldGenerator;
+typedef generic::io::fs<worldgen::StdFileIO> fs;
+
+enum ExitCode
+{
+    Success=0,
+    UsageError=1,
+    DescriptorError=2,
+    MemoryBudgetExceeded=3,
+    WriteError=4,
+    GenerateError=5,
+    ShardError=6
+};
+
+enum class Mode
+{
+    Bake,//single process generate
+    Plan,//write the shard manifest and descriptors for workers
+    Shard,//generate one shard of the manifest
+    Merge//combine all shards into the standard world output
+};
+
+struct CliOptions
+{
+    std::string descriptorFile;
+    std::string outputDirectory=".";
+    bool hasSeed=false;
+    int seed=0;
+    size_t threads=0;
+    size_t memoryBudget=0;//bytes, 0 is unlimited
+    bool images=true;
+    //a batch bake never looks at the intermediate layers
+    worldgen::LayerRetention retention=worldgen::LayerRetention::None;
+    int streamRows=0;//0 generates the whole map at once
+    bool hasSimdLevel=false;//otherwise the descriptor level is used
+    worldgen::SimdLevel simdLevel=worldgen::SimdLevel::Auto;
+    int plateCount=0;//0 keeps the descriptor plate assignment
+    worldgen::LayerMemoryPolicy memoryPolicy;
+
+    Mode mode=Mode::Bake;
+    int shardCount=0;
+    int shardIndex=0;
+    std::string shardDirectory;//default <output>/shards
+
+    std::string cacheDirectory;//empty disables the cache
+    uint64_t cacheSize=0;//bytes, 0 is unlimited
+
+    std::string traceFile;//empty disables tracing
+};
+
+struct Timings
+{
+    std::vector<worldgen::StageTiming> stages;
+    double generateMs=0.0;
+    double saveMs=0.0;
+    double imagesMs=0.0;
+    double totalMs=0.0;
+    bool cacheHit=false;
+};
+
+void printUsage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -d, --descriptor <file>     world descriptor json (size, regionSize, chunkSize, generator)\n"
+        "  -s, --seed <seed>           overrides the generator seed\n"
+        "  -o, --output <directory>    output directory, default current directory\n"
+        "  -t, --threads <count>       worker threads, default hardware concurrency\n"
+        "  -m, --memory-budget <MiB>   refuse to generate if the estimate exceeds the budget\n"
+        "      --no-images             skip the per layer images\n"
+        "      --retain <policy>       none, debug or all intermediate layers kept, default none\n"
+        "      --stream-rows <rows>    generate in bands of rows to bound memory, default whole map\n"
+        "      --huge-pages <mode>     off, transparent or explicit huge pages for large layers, default off\n"
+        "      --first-touch           fault in new layers from all workers\n"
+        "      --simd <level>          pin the noise to auto, scalar, sse2, sse41, avx2, avx512 or neon\n"
+        "      --plates <count>        grow exactly count plates from seeds instead of plate noise\n"
+        "      --cache <directory>     reuse worlds baked with the same descriptors\n"
+        "      --cache-size <MiB>      evict least recently used worlds over the size, default unlimited\n"
+        "      --trace <file>          write a chrome trace (chrome://tracing, ui.perfetto.dev) of the run\n"
+        "sharded bake, all modes share the shard directory:\n"
+        "      --plan-shards <count>   write manifest and descriptors for count workers\n"
+        "      --shard <index>         generate one shard from the manifest\n"
+        "      --merge                 combine the shards into the standard world output\n"
+        "      --shard-dir <directory> default <output>/shards\n"
+        "  -h, --help\n", name);
+}
+
+bool parseOptions(int argc, char **argv, CliOptions &options)
+{
+    for(int i=1; i<argc; ++i)
+    {
+        std::string arg=argv[i];
+        bool hasValue=(i+1<argc);
+
+        if((arg=="-h")||(arg=="--help"))
+            return false;
+        else if(arg=="--no-images")
+            options.images=false;
+        else if(arg=="--merge")
+            options.mode=Mode::Merge;
+        else if(arg=="--first-touch")
+            options.memoryPolicy.parallelFirstTouch=true;
+        else if(!hasValue)
+        {
+            fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        else if((arg=="-d")||(arg=="--descriptor"))
+            options.descriptorFile=argv[++i];
+        else if((arg=="-s")||(arg=="--seed"))
+        {
+            options.seed=atoi(argv[++i]);
+            options.hasSeed=true;
+        }
+        else if((arg=="-o")||(arg=="--output"))
+            options.outputDirectory=argv[++i];
+        else if((arg=="-t")||(arg=="--threads"))
+            options.threads=(size_t)std::max(atoi(argv[++i]), 0);
+        else if((arg=="-m")||(arg=="--memory-budget"))
+            options.memoryBudget=(size_t)std::max(atoll(argv[++i]), 0ll)*1024*1024;
+        else if(arg=="--plan-shards")
+        {
+            options.shardCount=atoi(argv[++i]);
+            options.mode=Mode::Plan;
+
+            if(options.shardCount<1)
+            {
+                fprintf(stderr, "shard count must be at least 1\n");
+                return false;
+            }
+        }
+        else if(arg=="--shard")
+        {
+            options.shardIndex=atoi(argv[++i]);
+            options.mode=Mode::Shard;
+        }
+        else if(arg=="--shard-dir")
+            options.shardDirectory=argv[++i];
+        else if(arg=="--retain")
+        {
+            std::string policy=argv[++i];
+
+            if(policy=="none")
+                options.retention=worldgen::LayerRetention::None;
+            else if(policy=="debug")
+                options.retention=worldgen::LayerRetention::Debug;
+            else if(policy=="all")
+                options.retention=worldgen::LayerRetention::All;
+            else
+            {
+                fprintf(stderr, "unknown retention policy %s\n", policy.c_str());
+                return false;
+            }
+        }
+        else if(arg=="--huge-pages")
+        {
+            std::string mode=argv[++i];
+
+            if(mode=="off")
+                options.memoryPolicy.hugePages=worldgen::HugePages::Off;
+            else if(mode=="transparent")
+                options.memoryPolicy.hugePages=worldgen::HugePages::Transparent;
+            else if(mode=="explicit")
+                options.memoryPolicy.hugePages=worldgen::HugePages::Explicit;
+            else
+            {
+                fprintf(stderr, "unknown huge page mode %s\n", mode.c_str());
+                return false;
+            }
+        }
+        else if(arg=="--simd")
+        {
+            if(!worldgen::parseSimdLevel(argv[++i], options.simdLevel))
+            {
+                fprintf(stderr, "unknown simd level %s\n", argv[i]);
+                return false;
+            }
+            options.hasSimdLevel=true;
+        }
+        else if(arg=="--plates")
+        {
+            options.plateCount=atoi(argv[++i]);
+            if(options.plateCount<1)
+            {
+                fprintf(stderr, "--plates needs at least 1 plate\n");
+                return false;
+            }
+        }
+        else if(arg=="--stream-rows")
+            options.streamRows=std::max(atoi(argv[++i]), 0);
+        else if(arg=="--cache")
+            options.cacheDirectory=argv[++i];
+        else if(arg=="--cache-size")
+            options.cacheSize=(uint64_t)std::max(atoll(argv[++i]), 0ll)*1024*1024;
+        else if(arg=="--trace")
+            options.traceFile=argv[++i];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if(options.shardDirectory.empty())
+        options.shardDirectory=options.outputDirectory+"/shards";
+    return true;
+}
+
+bool readFile(const std::string &fileName, std::string &contents)
+{
+    FILE *file=fopen(fileName.c_str(), "rb");
+
+    if(!file)
+        return false;
+
+    char buffer[4096];
+    size_t read;
+
+    contents.clear();
+    while((read=fread(buffer, 1, sizeof(buffer), file))>0)
+        contents.append(buffer, read);
+
+    fclose(file);
+    return true;
+}
+
+bool writeFile(const std::string &fileName, const char *data, size_t size)
+{
+    FILE *file=fopen(fileName.c_str(), "wb");
+
+    if(!file)
+        return false;
+
+    size_t written=fwrite(data, 1, size, file);
+
+    fclose(file);
+    return written==size;
+}
+
+bool readIVec3(const rapidjson::Value &document, const char *name, glm::ivec3 &value)
+{
+    if(!document.HasMember(name))
+        return true;
+
+    const rapidjson::Value &array=document[name];
+
+    if(!array.IsArray()||(array.Size()!=3))
+        return false;
+
+    for(rapidjson::SizeType i=0; i<3; ++i)
+    {
+        if(!array[i].IsInt())
+            return false;
+        value[i]=array[i].GetInt();
+    }
+    return true;
+}
+
+bool loadWorldDescriptors(const CliOptions &options, worldgen::WorldDescriptors &descriptors)
+{
+    //same world the viewer builds
+    glm::ivec3 size(4194304, 2097152, 2560);
+    glm::ivec3 regionSize(16, 16, 16);
+    glm::ivec3 chunkSize(64, 64, 16);
+    rapidjson::Document generator;
+
+    generator.SetObject();
+
+    if(!options.descriptorFile.empty())
+    {
+        std::string json;
+        rapidjson::Document document;
+
+        if(!readFile(options.descriptorFile, json))
+        {
+            fprintf(stderr, "failed to read descriptor %s\n", options.descriptorFile.c_str());
+            return false;
+        }
+
+        document.Parse(json.c_str());
+
+        if(document.HasParseError()||!document.IsObject())
+        {
+            fprintf(stderr, "descriptor %s is not a json object\n", options.descriptorFile.c_str());
+            return false;
+        }
+
+        if(!readIVec3(document, "size", size)||!readIVec3(document, "regionSize", regionSize)||!readIVec3(document, "chunkSize", chunkSize))
+        {
+            fprintf(stderr, "descriptor sizes must be arrays of 3 integers\n");
+            return false;
+        }
+
+        if(document.HasMember("generator"))
+        {
+            if(!document["generator"].IsObject())
+            {
+                fprintf(stderr, "descriptor generator must be an object\n");
+                return false;
+            }
+            generator.CopyFrom(document["generator"], generator.GetAllocator());
+        }
+    }
+
+    if(options.hasSeed)
+    {
+        if(generator.HasMember("seed"))
+            generator["seed"].SetInt(options.seed);
+        else
+            generator.AddMember("seed", rapidjson::Value(options.seed).Move(), generator.GetAllocator());
+    }
+
+    if(options.hasSimdLevel)
+    {
+        rapidjson::Value simdLevel(rapidjson::StringRef(worldgen::simdLevelName(options.simdLevel)));
+
+        if(generator.HasMember("simdLevel"))
+            generator["simdLevel"]=simdLevel;
+        else
+            generator.AddMember("simdLevel", simdLevel, generator.GetAllocator());
+    }
+
+    if(options.plateCount>0)
+    {
+        rapidjson::Value plateAssignment(rapidjson::StringRef(worldgen::plateAssignmentName(worldgen::PlateAssignment::Seeded)));
+
+        if(generator.HasMember("plateAssignment"))
+            generator["plateAssignment"]=plateAssignment;
+        else
+            generator.AddMember("plateAssignment", plateAssignment, generator.GetAllocator());
+
+        if(generator.HasMember("plateCount"))
+            generator["plateCount"].SetInt(options.plateCount);
+        else
+            generator.AddMember("plateCount", rapidjson::Value(options.plateCount).Move(), generator.GetAllocator());
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+    generator.Accept(writer);
+
+    descriptors.setSize(size);
+    descriptors.setRegionSize(regionSize);
+    descriptors.setChunkSize(chunkSize);
+    descriptors.getGeneratorArgs()=buffer.GetString();
+    return true;
+}
+
+//world descriptor in the same layout --descriptor reads, with the generator values actually used
+bool writeWorldDescriptors(const std::string &fileName, WorldGenerator &generator, worldgen::WorldDescriptors &descriptors)
+{
+    std::string generatorArgs;
+
+    generator.saveDescriptors(generatorArgs);
+
+    rapidjson::Document document;
+    rapidjson::Document generatorDocument;
+    rapidjson::Document::AllocatorType &allocator=document.GetAllocator();
+
+    document.SetObject();
+    generatorDocument.Parse(generatorArgs.c_str());
+
+    auto addIVec3=[&](const char *name, const glm::ivec3 &value)
+    {
+        rapidjson::Value array(rapidjson::kArrayType);
+
+        array.PushBack(value.x, allocator).PushBack(value.y, allocator).PushBack(value.z, allocator);
+        document.AddMember(rapidjson::StringRef(name), array, allocator);
+    };
+
+    addIVec3("size", descriptors.getSize());
+    addIVec3("regionSize", descriptors.getRegionSize());
+    addIVec3("chunkSize", descriptors.getChunkSize());
+
+    if(!generatorDocument.HasParseError())
+        document.AddMember("generator", rapidjson::Value(generatorDocument, allocator), allocator);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+    document.Accept(writer);
+    return writeFile(fileName, buffer.GetString(), buffer.GetSize());
+}
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, std::milli>(chrono::steady_clock::now()-start).count();
+}
+
+//runs the generation on a worker and reports stage changes while it runs, the stage timings come from
+//the generator once it is done
+bool generate(WorldGenerator &generator, const std::function<bool(worldgen::Progress &)> &run, Timings &timings)
+{
+    worldgen::Progress progress;
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+
+    std::future<bool> task=std::async(std::launch::async, [&run, &progress]()
+        {
+            return run(progress);
+        });
+
+    worldgen::Stage stage=worldgen::Stage::Idle;
+
+    while(true)
+    {
+        bool done=(task.wait_for(chrono::milliseconds(1))==std::future_status::ready);
+        worldgen::Stage current=progress.stage();
+
+        if(current!=stage)
+        {
+            stage=current;
+
+            if((stage!=worldgen::Stage::Idle)&&(stage!=worldgen::Stage::Complete))
+                fprintf(stderr, "[%3d%%] %s\n", progress.progress(), worldgen::stageName(stage));
+        }
+
+        if(done)
+            break;
+    }
+
+    timings.generateMs=elapsedMs(start);
+    timings.stages=generator.getStageTimings();
+    return task.get();
+}
+
+bool readManifest(const std::string &directory, worldgen::ShardManifest &manifest)
+{
+    std::string fileName=directory+"/manifest.json";
+    std::string json;
+
+    if(!readFile(fileName, json)||!manifest.load(json.c_str()))
+    {
+        fprintf(stderr, "failed to read shard manifest %s\n", fileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+//writes the manifest next to the descriptors the workers have to load, so every process bakes the same world
+int planShards(const CliOptions &options, WorldGenerator &generator, worldgen::WorldDescriptors &descriptors)
+{
+    worldgen::ShardManifest manifest;
+    std::string json;
+
+    manifest.partition(generator.getInfluenceMapSize(), generator.getDecriptors().seed, options.shardCount);
+    manifest.save(json);
+
+    if(!fs::exists(options.shardDirectory))
+        fs::create_directory(options.shardDirectory);
+
+    if(!writeWorldDescriptors(options.shardDirectory+"/descriptors.json", generator, descriptors)||
+        !writeFile(options.shardDirectory+"/manifest.json", json.data(), json.size()))
+    {
+        fprintf(stderr, "failed to write shard manifest to %s\n", options.shardDirectory.c_str());
+        return WriteError;
+    }
+
+    for(const worldgen::ShardRange &shard:manifest.shards)
+        fprintf(stderr, "shard %d rows [%d, %d)\n", shard.index, shard.rowBegin, shard.rowEnd);
+    return Success;
+}
+
+int generateShard(const CliOptions &options, WorldGenerator &generator)
+{
+    worldgen::ShardManifest manifest;
+    Timings timings;
+
+    if(!readManifest(options.shardDirectory, manifest))
+        return ShardError;
+
+    if((options.shardIndex<0)||(options.shardIndex>=(int)manifest.shards.size()))
+    {
+        fprintf(stderr, "shard %d not in manifest (%zu shards)\n", options.shardIndex, manifest.shards.size());
+        return ShardError;
+    }
+
+    const worldgen::ShardRange &range=manifest.shards[options.shardIndex];
+    size_t estimatedMemory=generator.estimateShardMemory(range);
+
+    if((options.memoryBudget>0)&&(estimatedMemory>options.memoryBudget))
+    {
+        fprintf(stderr, "shard needs an estimated %zu MiB, over the %zu MiB budget\n", estimatedMemory/(1024*1024), options.memoryBudget/(1024*1024));
+        return MemoryBudgetExceeded;
+    }
+
+    bool generated=generate(generator, [&](worldgen::Progress &progress)
+        {
+            return generator.generateShard<worldgen::StdFileIO>(range, options.shardDirectory, progress);
+        }, timings);
+
+    if(!generated)
+    {
+        fprintf(stderr, "failed to generate shard %d\n", range.index);
+        return GenerateError;
+    }
+
+    fprintf(stderr, "shard %d done in %.1f ms\n", range.index, timings.generateMs);
+    return Success;
+}
+
+bool writePPM(const std::string &fileName, int width, int height, const std::vector<uint32_t> &pixels)
+{
+    std::string header="P6\n"+std::to_string(width)+" "+std::to_string(height)+"\n255\n";
+    std::vector<char> data(header.begin(), header.end());
+
+    data.reserve(header.size()+(size_t)width*height*3);
+    for(uint32_t pixel:pixels)
+    {
+        data.push_back((char)(pixel&0xff));
+        data.push_back((char)((pixel>>8)&0xff));
+        data.push_back((char)((pixel>>16)&0xff));
+    }
+    return writeFile(fileName, data.data(), data.size());
+}
+
+bool writeImages(WorldGenerator &generator, const std::string &directory)
+{
+    using worldgen::render::Layer;
+    using worldgen::render::Overlay;
+
+    struct ImageLayer
+    {
+        const char *name;
+        Layer layer;
+        Overlay overlay;
+    };
+
+    std::vector<ImageLayer> layers=
+    {
+        {"terrain", Layer::Biome, Overlay::None},
+        {"height", Layer::Height, Overlay::None},
+        {"plateHeight", Layer::PlateHeight, Overlay::None},
+        {"plates", Layer::Plates, Overlay::None},
+        {"plateDistance", Layer::Grey, Overlay::None},
+        {"collision", Layer::Black, Overlay::Collision},
+        {"temperature", Layer::Black, Overlay::Temperature},
+        {"moisture", Layer::Black, Overlay::Moisture},
+        {"weatherCells", Layer::Black, Overlay::WeatherCell}
+    };
+
+    worldgen::ThreadPool &pool=worldgen::ThreadPool::global();
+    worldgen::render::Fields fields;
+    worldgen::render::Palette palette=worldgen::render::defaultPalette(generator.getPlateCount());
+    std::vector<uint32_t> pixels;
+
+    fields.build(generator.getInfluenceMap(), generator.getInfluenceMapSize(), &pool);
+
+    std::string layerDirectory=directory+"/layers";
+
+    if(!fs::exists(layerDirectory))
+        fs::create_directory(layerDirectory);
+
+    for(const ImageLayer &imageLayer:layers)
+    {
+        worldgen::render::LayerSettings settings;
+
+        settings.layer=imageLayer.layer;
+        settings.overlay=imageLayer.overlay;
+
+        if(imageLayer.layer==Layer::Grey)
+        {
+            settings.grey=fields.plateDistanceValue.data();
+            worldgen::render::fieldRange(settings.grey, fields.plateDistanceValue.size(), settings.greyMin, settings.greyMax);
+        }
+
+        worldgen::render::renderLayer(fields, palette, settings, pixels, &pool);
+
+        std::string fileName=layerDirectory+"/"+imageLayer.name+".ppm";
+
+        if(!writePPM(fileName, fields.size.x, fields.size.y, pixels))
+        {
+            fprintf(stderr, "failed to write %s\n", fileName.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeReport(const std::string &fileName, const CliOptions &options, WorldGenerator &generator, const Timings &timings)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    const glm::ivec2 &influenceSize=generator.getInfluenceMapSize();
+
+    writer.StartObject();
+
+    writer.Key("seed");
+    writer.Int(generator.getDecriptors().seed);
+    writer.Key("influenceSize");
+    writer.StartArray();
+    writer.Int(influenceSize.x);
+    writer.Int(influenceSize.y);
+    writer.EndArray();
+    writer.Key("plateCount");
+    writer.Int(generator.getPlateCount());
+    writer.Key("plateAssignment");
+    writer.String(worldgen::plateAssignmentName(generator.getDecriptors().m_plateAssignment));
+    writer.Key("threads");
+    writer.Uint64(worldgen::ThreadPool::global().size());
+    writer.Key("memoryBudget");
+    writer.Uint64(options.memoryBudget);
+    writer.Key("estimatedMemory");
+    writer.Uint64(generator.estimateGenerationMemory());
+    writer.Key("cacheHit");
+    writer.Bool(timings.cacheHit);
+    writer.Key("simdLevel");
+    writer.String(worldgen::simdLevelName(generator.getDecriptors().m_simdLevel));
+    //what FastSIMD actually ran, absent when nothing was generated (cache hit)
+    if(generator.getSimdLevel()!=worldgen::SimdLevel::Auto)
+    {
+        writer.Key("simdLevelUsed");
+        writer.String(worldgen::simdLevelName(generator.getSimdLevel()));
+    }
+
+    //what is still held after generation with the retention policy applied
+    writer.Key("memory");
+    writer.StartObject();
+    for(const worldgen::LayerMemory &layer:generator.getMemoryUsage())
+    {
+        writer.Key(layer.name);
+        writer.Uint64(layer.bytes);
+    }
+    writer.EndObject();
+
+    writer.Key("stages");
+    writer.StartArray();
+    for(const worldgen::StageTiming &stage:timings.stages)
+    {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(stage.name.c_str());
+        writer.Key("startMs");
+        writer.Double(stage.startMs);
+        writer.Key("ms");
+        writer.Double(stage.ms);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.Key("generateMs");
+    writer.Double(timings.generateMs);
+    writer.Key("saveMs");
+    writer.Double(timings.saveMs);
+    writer.Key("imagesMs");
+    writer.Double(timings.imagesMs);
+    writer.Key("totalMs");
+    writer.Double(timings.totalMs);
+
+    writer.EndObject();
+
+    return writeFile(fileName, buffer.GetString(), buffer.GetSize());
+}
+
+//writes the trace whichever way main returns
+struct TraceOutput
+{
+    TraceOutput(const std::string &fileName):fileName(fileName)
+    {
+        if(!fileName.empty())
+            worldgen::setTraceEnabled(true);
+    }
+
+    ~TraceOutput()
+    {
+        if(fileName.empty())
+            return;
+
+        worldgen::setTraceEnabled(false);
+        if(!worldgen::writeChromeTrace(fileName))
+            fprintf(stderr, "failed to write trace %s\n", fileName.c_str());
+    }
+
+    std::string fileName;
+};
+
+int main(int argc, char **argv)
+{
+    CliOptions options;
+
+    if(!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return UsageError;
+    }
+
+    //has to happen before anything touches the shared pool
+    worldgen::ThreadPool::setGlobalThreads(options.threads);
+    worldgen::setLayerMemoryPolicy(options.memoryPolicy);
+    worldgen::setTraceThreadName("main");
+
+    TraceOutput traceOutput(options.traceFile);
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+    worldgen::WorldDescriptors descriptors;
+    WorldGenerator generator;
+    Timings timings;
+
+    //workers and the merge read the descriptors written at plan time
+    CliOptions descriptorOptions=options;
+
+    if((options.mode==Mode::Shard)||(options.mode==Mode::Merge))
+    {
+        descriptorOptions.descriptorFile=options.shardDirectory+"/descriptors.json";
+        descriptorOptions.hasSeed=false;
+    }
+
+    if(!loadWorldDescriptors(descriptorOptions, descriptors))
+        return DescriptorError;
+
+    generator.loadDescriptors(&descriptors);
+    generator.setLayerRetention(options.retention);
+    generator.setStreamingBandRows(options.streamRows);
+
+    if(options.mode==Mode::Plan)
+        return planShards(options, generator, descriptors);
+    if(options.mode==Mode::Shard)
+        return generateShard(options, generator);
+
+    worldgen::ShardManifest manifest;
+
+    if((options.mode==Mode::Merge)&&!readManifest(options.shardDirectory, manifest))
+        return ShardError;
+
+    size_t estimatedMemory=generator.estimateGenerationMemory();
+
+    if((options.memoryBudget>0)&&(estimatedMemory>options.memoryBudget))
+    {
+        fprintf(stderr, "generation needs an estimated %zu MiB, over the %zu MiB budget\n", estimatedMemory/(1024*1024), options.memoryBudget/(1024*1024));
+        return MemoryBudgetExceeded;
+    }
+
+    if(!fs::exists(options.outputDirectory))
+        fs::create_directory(options.outputDirectory);
+
+    bool generated;
+
+    if(options.mode==Mode::Merge)
+    {
+        generated=generate(generator, [&](worldgen::Progress &progress)
+            {
+                return generator.mergeShards<worldgen::StdFileIO>(manifest, options.shardDirectory, progress);
+            }, timings);
+    }
+    else if(!options.cacheDirectory.empty())
+    {
+        if(!fs::exists(options.cacheDirectory))
+            fs::create_directory(options.cacheDirectory);
+
+        worldgen::WorldCache cache(options.cacheDirectory, options.cacheSize);
+
+        generated=generate(generator, [&](worldgen::Progress &progress)
+            {
+                return generator.loadOrCreate(&descriptors, cache, progress, &timings.cacheHit);
+            }, timings);
+
+        if(generated)
+            fprintf(stderr, "cache %s %s\n", timings.cacheHit?"hit":"miss", worldgen::WorldCache::keyName(generator.cacheKey()).c_str());
+    }
+    else
+    {
+        generated=generate(generator, [&](worldgen::Progress &progress)
+            {
+                return generator.create(&descriptors, progress);
+            }, timings);
+    }
+
+    if(!generated)
+    {
+        fprintf(stderr, "generation failed\n");
+        return GenerateError;
+    }
+
+    chrono::steady_clock::time_point saveStart=chrono::steady_clock::now();
+
+    bool saved=generator.save<worldgen::StdFileIO>(options.outputDirectory);
+
+    timings.saveMs=elapsedMs(saveStart);
+
+    if(!saved)
+    {
+        fprintf(stderr, "failed to write %s/overview.bin\n", options.outputDirectory.c_str());
+        return WriteError;
+    }
+
+    if(!writeWorldDescriptors(options.outputDirectory+"/descriptors.json", generator, descriptors))
+        return WriteError;
+
+    if(options.images)
+    {
+        chrono::steady_clock::time_point imagesStart=chrono::steady_clock::now();
+
+        if(!writeImages(generator, options.outputDirectory))
+            return WriteError;
+        timings.imagesMs=elapsedMs(imagesStart);
+    }
+
+    timings.totalMs=elapsedMs(start);
+
+    if(!writeReport(options.outputDirectory+"/timing.json", options, generator, timings))
+        return WriteError;
+
+    fprintf(stderr, "done in %.1f ms\n", timings.totalMs);
+    return Success;
+}
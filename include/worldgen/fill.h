@@ -15,7 +15,7 @@ namespace worldgen
 
 inline const std::array<glm::ivec2, 3> &getFloodPoints(const glm::vec2 &direction)
 {
-    static std::vector<std::array<glm::ivec2, 3>> points=
+    static const std::vector<std::array<glm::ivec2, 3>> points=
     {
         {{
             {-1,  1},
@@ -84,7 +84,9 @@ inline const std::array<glm::ivec2, 3> &getFloodPoints(const glm::vec2 &directio
     return points[index];
 }
 
-inline void fillPoints(const glm::ivec2 &point, const glm::vec2 &direction, std::vector<float> &map, const glm::ivec2 &size, float value)
+//point is in map coordinates and wraps over a map of size, map only holds the rowCount rows starting at map
+//row rowOffset (wrapping past the last row). Points landing in rows map does not hold are dropped.
+inline void fillPoints(const glm::ivec2 &point, const glm::vec2 &direction, float *map, const glm::ivec2 &size, float value, int rowOffset, int rowCount)
 {
     //keep in mind that in world coords +y is up, in image coords +y is down
     glm::ivec2 step(0, 0);
@@ -146,19 +148,34 @@ inline void fillPoints(const glm::ivec2 &point, const glm::vec2 &direction, std:
     {
         pt=pt+step;
         glm::ivec2 pt2=wrap(pt, lower, upper);
-        size_t index=(pt2.y*size.x)+pt2.x;
-        map[index]=std::min(map[index]+(value*(1.0f-scale)), 1.0f);
+        int row=((pt2.y-rowOffset)%size.y+size.y)%size.y;
+
+        if(row<rowCount)
+        {
+            size_t index=((size_t)row*size.x)+pt2.x;
+            map[index]=std::min(map[index]+(value*(1.0f-scale)), 1.0f);
+        }
     }
 
     if(scale>0.0f)
     {
         pt=pt+step2;
         glm::ivec2 pt2=wrap(pt, lower, upper);
-        size_t index=(pt2.y*size.x)+pt2.x;
-        map[index]=std::min(map[index]+(value*scale), 1.0f);
+        int row=((pt2.y-rowOffset)%size.y+size.y)%size.y;
+
+        if(row<rowCount)
+        {
+            size_t index=((size_t)row*size.x)+pt2.x;
+            map[index]=std::min(map[index]+(value*scale), 1.0f);
+        }
     }
 }
 
+inline void fillPoints(const glm::ivec2 &point, const glm::vec2 &direction, float *map, const glm::ivec2 &size, float value)
+{
+    fillPoints(point, direction, map, size, value, 0, size.y);
+}
+
 }//namespace worldgen
 
 #endif //_worldgen_fill_h_
\ No newline at end of file
@@ -0,0 +1,206 @@
+#ifndef _worldgen_cubeSphereWorldGenerator_h_
+#define _worldgen_cubeSphereWorldGenerator_h_
+
+#include "worldgen/worldDescriptors.h"
+#include "worldgen/tectonics.h"
+#include "worldgen/progress.h"
+#include "worldgen/plateIndex.h"
+#include "worldgen/maths/cubeSphere.h"
+#include "worldgen/utils/stageGraph.h"
+#include "worldgen/utils/simdLevel.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FastNoise
+{
+class Generator;
+}
+
+namespace worldgen
+{
+
+//corner heights kept per cell for getBaseHeight, same layout as the equirectangular neighbor map
+constexpr int CubeCornerCount=4;
+
+struct WORLDGEN_EXPORT CubeSphereDescriptors
+{
+    CubeSphereDescriptors()
+    {
+        seed=1;
+
+        m_faceSize=0;
+        m_tileSize=16;
+        m_plateCount=16;
+
+        m_influenceGridSize={4096, 4096};
+
+        m_simdLevel=SimdLevel::Auto;
+    }
+
+    //A quarter of the equirectangular influence width per face keeps the equator resolution of
+    //EquiRectWorldGenerator for the same world size with 6/8 of the cells, the cells it spends on the
+    //poles are not needed.
+    void calculateFaceSize(const WorldDescriptors &worldDescriptors)
+    {
+        glm::ivec3 size=worldDescriptors.getSize();
+        int influenceWidth=(size.x+m_influenceGridSize.x-1)/m_influenceGridSize.x;
+
+        m_faceSize=std::max((influenceWidth+3)/4, 1);
+    }
+
+    bool load(const char *json);
+    bool save(char *json, size_t &size);
+
+    void init(const WorldDescriptors &worldDescriptors);
+
+    //canonical hash of every field, independent of the json layout
+    uint64_t hash() const;
+
+    int seed;
+
+    //cells along a face edge, rounded up to a multiple of m_tileSize when the grid is built
+    int m_faceSize;
+    int m_tileSize;
+    //exact, plates are grown from this many seeds
+    int m_plateCount;
+
+    //only used to pick m_faceSize from the world size
+    glm::ivec2 m_influenceGridSize;
+
+    //noise passes are pinned to this level, not part of hash()
+    SimdLevel m_simdLevel;
+};
+
+constexpr unsigned int CubeSphereWorldGeneratorHeader_Marker=0x0c0f0c0f;
+//bump when the overview layout or the generation output changes, it is part of the cache key
+constexpr unsigned int CubeSphereWorldFormatVersion=1;
+struct CubeSphereWorldGeneratorHeader
+{
+    unsigned int marker;
+    unsigned int version;
+    unsigned int faceSize;
+    unsigned int tileSize;
+    unsigned int cellSize;
+    uint64_t size;
+    //CubeSphereWorldGenerator::cacheKey of the descriptors the overview was generated with
+    uint64_t descriptorKey;
+};
+
+//World overview on a cube sphere (see CubeSphereGrid) rather than an equirectangular grid. Cells are close
+//to the same area everywhere so there is no pole oversampling, and neighbors come from the grid's table
+//so plate distance, moisture and the corner heights run over the face seams like anywhere else. Plates
+//are always seeded, m_plateCount of them.
+//
+//Same interface as EquiRectWorldGenerator. World positions given to getBaseHeight are on the same
+//equirectangular world plane so the generators can be swapped, getSphereHeight samples the sphere
+//directly.
+//
+//Thread safety: as EquiRectWorldGenerator, generation state is owned by the instance and a single instance
+//is not reentrant. getBaseHeight is safe from any thread once create/load returned.
+class CubeSphereWorldGenerator
+{
+public:
+    class Hidden;
+
+    typedef std::vector<InfluenceCell> InfluenceMap;
+
+    CubeSphereWorldGenerator();
+    ~CubeSphereWorldGenerator();
+
+    static const char *typeName() { return "CubeSphereWorldGenerator"; }
+
+    //generates the overview and corner heights, returns false if cancelled through progress
+    bool create(WorldDescriptors *descriptors, Progress &progress);
+    //generates the overview if the directory does not have one for the descriptors, returns true only
+    //when it was loaded
+    template<typename _FileIO>
+    bool load(WorldDescriptors *descriptors, const std::string &directory, Progress &progress);
+    template<typename _FileIO>
+    bool save(const std::string &directory);
+
+    //hash of the format version, world size, every descriptor and the seeds in use
+    uint64_t cacheKey() const;
+
+    void loadDescriptors(WorldDescriptors *descriptors);
+    void saveDescriptors(WorldDescriptors *descriptors);
+    void saveDescriptors(std::string &descriptors);
+
+    //returns false if the generation was cancelled through progress
+    bool generateWorldOverview(Progress &progress);
+
+    unsigned int generateChunk(const glm::vec3 &startPos, const glm::ivec3 &chunkSize, void *buffer, size_t bufferSize, size_t lod);
+    unsigned int generateRegion(const glm::vec3 &startPos, const glm::ivec3 &regionSize, void *buffer, size_t bufferSize, size_t lod);
+
+    int getBaseHeight(const glm::vec2 &pos);
+    void getBaseHeights(const glm::vec2 *positions, int *heights, size_t count);
+    //base height along a direction from the planet center, does not have to be normalized
+    int getSphereHeight(const glm::vec3 &direction) const;
+
+    const CubeSphereGrid &getGrid() const { return m_grid; }
+    const InfluenceMap &getInfluenceMap() const { return m_influenceMap; }
+    const std::vector<float> &getCornerHeights() const { return m_cornerHeights; }
+    const std::vector<PlateInfo> &getPlates() const { return m_plates; }
+    //index over the plate seeds, plate indices are InfluenceCell::tectonicPlate
+    const PlateIndex &getPlateIndex() const { return m_plateIndex; }
+    int getPlateCount() const { return (int)m_plates.size(); }
+    const std::vector<StageTiming> &getStageTimings() const { return m_stageTimings; }
+
+    CubeSphereDescriptors &getDescriptors() { return m_descriptorValues; }
+
+    int m_plateSeed;
+
+private:
+    void initialize(WorldDescriptors *descriptors);
+
+    template<typename _FileIO>
+    bool loadWorldOverview(const std::string &fileName);
+    template<typename _FileIO>
+    bool saveWorldOverview(const std::string &fileName) const;
+
+    bool generateNoise(const FastNoise::Generator *node, float *output, int seed, Progress &progress) const;
+    //plate and border plate of every cell from the seeds, through a warp so the borders are not straight
+    bool generatePlates(std::vector<uint32_t> &plates, std::vector<uint32_t> &borderPlates, Progress &progress);
+    //distance along the sphere from every cell to the closest cell on a plate border, 1 on the border
+    //falling to 0 half way around the sphere
+    bool generatePlateDistance(const std::vector<uint32_t> &plates, std::vector<float> &plateDistance, Progress &progress) const;
+    //plate details from the seeds, neighbors are the plate/border plate pairs found in the cells
+    void buildPlates(const std::vector<uint32_t> &plates, const std::vector<uint32_t> &borderPlates);
+    //influence map from the layers, the per cell processing of EquiRectWorldGenerator with the moisture
+    //carried over the neighbor table
+    bool processCells(const std::vector<uint32_t> &plates, const std::vector<uint32_t> &borderPlates, const std::vector<float> &plateDistance,
+        Progress &progress);
+    //rebuilds the corner heights from the influence map, done by create/load
+    void updateCornerHeights();
+    void releaseGeneration();
+
+    WorldDescriptors m_descriptors;
+    CubeSphereDescriptors m_descriptorValues;
+
+    std::unique_ptr<Hidden> m_hidden;
+
+    int m_continentSeed;
+
+    CubeSphereGrid m_grid;
+    InfluenceMap m_influenceMap;
+    std::vector<float> m_cornerHeights;
+    std::vector<PlateInfo> m_plates;
+    PlateIndex m_plateIndex;
+
+    //working layers of the last generation, released once the influence map is built
+    std::vector<float> m_xPositions;
+    std::vector<float> m_yPositions;
+    std::vector<float> m_zPositions;
+    std::vector<float> m_heightMap;
+    std::vector<float> m_terrainScaleMap;
+    std::vector<float> m_airCurrentMap;
+    std::vector<float> m_continentMap;
+
+    std::vector<StageTiming> m_stageTimings;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_cubeSphereWorldGenerator_h_
@@ -12,6 +12,11 @@
 #include "worldgen/sortedVector.h"
 #include "worldgen/maths/glm_point.h"
 #include "worldgen/progress.h"
+#include "worldgen/utils/stageGraph.h"
+#include "worldgen/utils/generationArena.h"
+#include "worldgen/utils/layerAllocator.h"
+#include "worldgen/utils/simdLevel.h"
+#include "worldgen/plateIndex.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/integer.hpp>
@@ -21,16 +26,43 @@
 #include <cassert>
 #include <random>
 #include <chrono>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <memory>
 namespace chrono=std::chrono;
 
+namespace FastNoise
+{
+class Generator;
+}
+
 namespace worldgen
 {
 
+class WorldCache;
+struct PlateStatistics;
+class PlateBoundaries;
+
 constexpr int NeighborCount=4;
+//reduction applied to the influence map when building the preview used during async loads
+constexpr int PreviewScale=8;
+//noise passes are issued in row bands of roughly this many points, cancellation is checked between bands
+constexpr int CancelBandPoints=16384;
 
 //this is expecting cylindrical wrap
 WORLDGEN_EXPORT std::vector<size_t> get2DCellNeighbors_eq(const glm::ivec2 &index, const glm::ivec2 &size);
 
+//how the plate layers are made
+enum class PlateAssignment
+{
+    Noise,//warped cellular noise, the plate count follows the plate frequency
+    Seeded//m_plateCount seeds grown into plates, the count is exact
+};
+
+WORLDGEN_EXPORT const char *plateAssignmentName(PlateAssignment assignment);
+WORLDGEN_EXPORT bool parsePlateAssignment(const std::string &name, PlateAssignment &assignment);
+
 struct WORLDGEN_EXPORT EquiRectDescriptors
 {
     EquiRectDescriptors()
@@ -44,10 +76,12 @@ struct WORLDGEN_EXPORT EquiRectDescriptors
         m_continentLacunarity=2.2f;
 
         m_seaLevel=0.0f;
+        m_continentalShelf=0.0f;
 
         m_plateCount=16;
         m_plateCountMin=8;
         m_plateCountMax=24;
+        m_plateAssignment=PlateAssignment::Noise;
 
         m_plateFrequency=0.00025f;
         m_plateOctaves=3;
@@ -55,6 +89,8 @@ struct WORLDGEN_EXPORT EquiRectDescriptors
 
         m_influenceSize={4096, 4096};
         m_influenceGridSize={4096, 4096};
+
+        m_simdLevel=SimdLevel::Auto;
     }
 
     void calculateInfluenceSize(const WorldDescriptors &worldDescriptors)
@@ -77,6 +113,9 @@ struct WORLDGEN_EXPORT EquiRectDescriptors
 
     void init(const WorldDescriptors &worldDescriptors);
 
+    //canonical hash of every field, independent of the json layout
+    uint64_t hash() const;
+
     int seed;
 
     float m_noiseScale;
@@ -90,6 +129,7 @@ struct WORLDGEN_EXPORT EquiRectDescriptors
     int m_plateCount;
     int m_plateCountMin;
     int m_plateCountMax;
+    PlateAssignment m_plateAssignment;
 
     float m_plateFrequency;
     int m_plateOctaves;
@@ -97,9 +137,15 @@ struct WORLDGEN_EXPORT EquiRectDescriptors
 
     glm::ivec2 m_influenceSize;
     glm::ivec2 m_influenceGridSize;
+
+    //noise passes are pinned to this level. Not part of hash(), FastNoise gives the same values at every
+    //level up to float rounding.
+    SimdLevel m_simdLevel;
 };
 
 constexpr unsigned int EquiRectWorldGeneratorHeader_Marker=0x0f0f0f0f;
+//bump when the overview layout or the generation output changes, it is part of the cache key
+constexpr unsigned int EquiRectWorldFormatVersion=3;
 struct EquiRectWorldGeneratorHeader
 {
     unsigned int marker;
@@ -108,6 +154,8 @@ struct EquiRectWorldGeneratorHeader
     unsigned int y;
     unsigned int cellSize;
     unsigned int size;
+    //EquiRectWorldGenerator::cacheKey of the descriptors the overview was generated with
+    uint64_t descriptorKey;
 };
 
 struct NormalizeHeader
@@ -117,21 +165,95 @@ struct NormalizeHeader
     unsigned int size;
 };
 
-struct ThreadStorage
+//noise layers carried per cell in a bake shard, in file order: height, terrain scale, ns air, ew air,
+//plate, border plate, continent. Plate distance is left to the merge, it needs the borders of the whole map.
+constexpr int ShardLayerCount=7;
+
+//rows [rowBegin, rowEnd) of the influence map a single bake worker generates
+struct ShardRange
+{
+    int index;
+    int rowBegin;
+    int rowEnd;
+};
+
+struct ShardHeader
+{
+    unsigned int marker;
+    //EquiRectWorldFormatVersion the shard was generated with, the merge rejects any other
+    unsigned int version;
+    //EquiRectWorldGenerator::cacheKey of the descriptors the shard was generated with, the merge rejects shards of another world
+    uint64_t descriptorKey;
+    unsigned int index;
+    unsigned int rowBegin;
+    unsigned int rowEnd;
+    unsigned int width;
+    unsigned int layerCount;
+    unsigned int size;
+};
+
+//Partition of a bake across workers. The noise stages are per position so each shard generates its
+//rows independently, the merge concatenates them in row order and runs the global plate reductions
+//and processing once, giving the same overview as a single process bake.
+struct WORLDGEN_EXPORT ShardManifest
+{
+    //splits the rows evenly, the first (rows%shardCount) shards get one extra row
+    void partition(const glm::ivec2 &influenceSize, int seed, int shardCount);
+
+    bool load(const char *json);
+    void save(std::string &json) const;
+
+    static std::string shardFileName(int index);
+
+    glm::ivec2 influenceSize={0, 0};
+    int seed=0;
+    std::vector<ShardRange> shards;
+};
+
+//per cell layers of the last generation, each written by a single stage. Noise layers cover only the
+//shard rows while a shard is being generated.
+struct GenerationLayers
+{
+    LayerBuffer heightMap;
+    LayerBuffer terrainScale;
+    LayerBuffer nsAirCurrent;
+    LayerBuffer ewAirCurrent;
+    LayerBuffer plateMap;
+    LayerBuffer plate2Map;
+    LayerBuffer plateDistance;
+    LayerBuffer continentMap;
+
+    LayerBuffer plateScaleMap;
+    LayerBuffer plate2ScaleMap;
+};
+
+//what is kept of the generation layers once a world overview is finished
+enum class LayerRetention
+{
+    None,//only the influence map and neighbor map, for processes that just serve the world
+    Debug,//the layers the viewer displays
+    All//everything, unchanged stages are reused on the next generation
+};
+
+struct LayerMemory
 {
-    std::vector<float> heightMap;
-    std::vector<float> blockHeightMap;
-    std::vector<float> blockScaleMap;
-    std::vector<float> xMap;
-    std::vector<float> yMap;
-    std::vector<float> zMap;
-    std::vector<float> layerMap;
-//    std::unique_ptr<HastyNoise::VectorSet> vectorSet;
-
-    std::vector<float> regionHeightMap;
-//    std::unique_ptr<HastyNoise::VectorSet> regionVectorSet;
+    const char *name;
+    size_t bytes;
 };
 
+//reduced resolution overview, answers getBaseHeight while a full load/generate is in flight
+struct OverviewPreview
+{
+    glm::ivec2 influenceSize;
+    glm::ivec2 influenceGridSize;
+    std::vector<float> influenceNeighborMap;
+};
+
+//Thread safety: all generation state (noise graphs, layers, influence map) is owned by the instance,
+//so separate generators can generate concurrently. The noise graphs are rebuilt from the descriptors
+//at the start of each generation and only read afterwards, each stage writes its own layer. A single
+//instance is not reentrant, generate/create/load on it must not overlap; getBaseHeight is safe from
+//any thread once isReady().
 //template<typename _Region, typename _Chunk>
 class EquiRectWorldGenerator
 {
@@ -152,11 +274,32 @@ public:
 
     static const char *typeName() { return "EquiRectWorldGenerator"; }
 
-    void create(WorldDescriptors *descriptors, Progress &progress);
+    //generates the overview and neighbor map, returns false if cancelled through progress
+    bool create(WorldDescriptors *descriptors, Progress &progress);
     template<typename _FileIO>
     bool load(WorldDescriptors *descriptors, const std::string &directory, Progress &progress);
     template<typename _FileIO>
-    void save(const std::string &directory);
+    bool save(const std::string &directory);
+    //loads the world for the descriptors from the cache, on a miss generates it and publishes it to the cache
+    bool loadOrCreate(WorldDescriptors *descriptors, WorldCache &cache, Progress &progress, bool *cacheHit=nullptr);
+
+    //hash of the format version, world size, every generator descriptor and the seeds in use, keys the
+    //world cache and is stored in overview.bin so a load never picks up a world made with other settings
+    uint64_t cacheKey() const;
+
+    //loads (or generates on a cache miss) on a background thread, progress must outlive the returned future.
+    //Until isReady() getBaseHeight answers from a coarse preview when one is available, otherwise it blocks.
+    template<typename _FileIO>
+    std::shared_future<bool> loadAsync(WorldDescriptors *descriptors, const std::string &directory, Progress &progress);
+    //snapshots the overview on the calling thread and writes it in the background
+    template<typename _FileIO>
+    std::shared_future<bool> saveAsync(const std::string &directory);
+
+    bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+    bool hasPreview() const { return (bool)std::atomic_load(&m_preview); }
+    //blocks until the pending load completes or the timeout expires, returns isReady()
+    bool waitReady(std::chrono::milliseconds timeout);
+    void waitReady();
 
     void loadDescriptors(WorldDescriptors *descriptors);
     void saveDescriptors(WorldDescriptors *descriptors);
@@ -165,7 +308,8 @@ public:
     //    void setWorld(WorldDescriptors descriptors);
     //    void setWorldDiscriptors(WorldDescriptors descriptors);
 
-    void generateWorldOverview(Progress &progress);
+    //returns false if the generation was cancelled through progress, all generation buffers are released in that case
+    bool generateWorldOverview(Progress &progress);
 
     //    UniqueChunkType generateChunk(unsigned int hash, void *buffer, size_t bufferSize);
     //    UniqueChunkType generateChunk(glm::ivec3 chunkIndex, void *buffer, size_t bufferSize);
@@ -174,45 +318,122 @@ public:
     unsigned int generateRegion(const glm::vec3 &startPos, const glm::ivec3 &regionSize, void *buffer, size_t bufferSize, size_t lod);
 
     int getBaseHeight(const glm::vec2 &pos);
+    //same as getBaseHeight for count positions, the ready/preview check is done once for the batch
+    void getBaseHeights(const glm::vec2 *positions, int *heights, size_t count);
+
+    //closest plate and border plate to a world position by plate point (see PlateIndex), indices are
+    //InfluenceCell::tectonicPlate. Waits for the overview, the influence map is not needed. Seeded plates
+    //match the influence map, the position is warped and matched to the seeds as the generation does.
+    PlateQuery getPlate(const glm::vec2 &pos);
+    void getPlates(const glm::vec2 *positions, PlateQuery *queries, size_t count, ThreadPool *pool=nullptr);
+    //index over the plate points of the current overview, empty without one
+    const PlateIndex &getPlateIndex() const { return m_plateIndex; }
+
+    //peak bytes held by generateWorldOverview plus the neighbor map for the current descriptors
+    size_t estimateGenerationMemory() const;
+    //peak bytes held by generateShard for the given rows
+    size_t estimateShardMemory(const ShardRange &range) const;
+
+    //generates the noise layers for the shard rows and writes them to directory/ShardManifest::shardFileName,
+    //loadDescriptors must have been called with the descriptors the manifest was built from
+    template<typename _FileIO>
+    bool generateShard(const ShardRange &range, const std::string &directory, Progress &progress);
+    //reads every shard of the manifest and finishes the overview and neighbor map as create does
+    template<typename _FileIO>
+    bool mergeShards(const ShardManifest &manifest, const std::string &directory, Progress &progress);
+
+    //rebuilds the neighbor map and the plate index from the influence map, done by create/load. Public for
+    //benchmarking.
+    void updateInfluenceNeighbors();
 
     //for debugging
     int getPlateCount() { return m_plateCount; }
     const InfluenceMap &getInfluenceMap() { return m_influenceMap; }
     const glm::ivec2 &getInfluenceMapSize() { return m_descriptorValues.m_influenceSize; }
+    const GenerationLayers &getLayers() const { return m_layers; }
+    const std::vector<StageTiming> &getStageTimings() const { return m_stageTimings; }
+    //moves the layers out, the next generation rebuilds all of them instead of reusing cached stages
+    GenerationLayers takeLayers();
+
+    //applied at the end of every overview generation, defaults to All
+    void setLayerRetention(LayerRetention retention) { m_layerRetention=retention; }
+    LayerRetention getLayerRetention() const { return m_layerRetention; }
+    //bytes currently held per layer and working buffer, including the influence and neighbor maps
+    std::vector<LayerMemory> getMemoryUsage() const;
+
+    //rows > 0 generates the overview in bands of that many rows, working memory is then proportional to
+    //the band instead of the map. Moisture can differ slightly from a whole map generation (see
+    //StreamHaloRows) and no intermediate layers are kept whatever the retention.
+    void setStreamingBandRows(int rows) { m_streamBandRows=std::max(rows, 0); }
+    int getStreamingBandRows() const { return m_streamBandRows; }
 
     EquiRectDescriptors &getDecriptors() { return m_descriptorValues; }
+    //level the last generation's noise passes ran at, Auto before the first generation
+    SimdLevel getSimdLevel() const;
 
     int m_plateSeed;
     int m_plateCount;
     std::vector<glm::vec2> m_influencePoints;
     std::vector<std::vector<glm::vec2>> m_influenceLines;
 
-    std::vector<float> heightMap_noise;
-    std::vector<float> plateMap_noise;
-    std::vector<float> plate2Map_noise;
-    std::vector<float> plateScaleMap;
-    std::vector<float> plate2ScaleMap;
-    std::vector<float> plateDistance_noise;
-    std::vector<float> continentMap_noise;
-
 private:
     void initialize(WorldDescriptors *descriptors);
 
+    template<typename _FileIO>
+    bool loadOverview(const std::string &directory, Progress &progress, bool buildPreview);
     template<typename _FileIO>
     bool loadWorldOverview(const std::string &directory);
     template<typename _FileIO>
-    void saveWorldOverview(const std::string &directory);
+    static bool saveWorldOverview(const std::string &fileName, const glm::ivec2 &influenceSize, uint64_t descriptorKey, const InfluenceMap &influenceMap);
     template<typename _FileIO>
     bool loadNormalize(const std::string &fileName);
     template<typename _FileIO>
-    void saveNormalize(const std::string &fileName);
+    static bool saveNormalize(const std::string &fileName, const std::vector<float> &influenceNeighborMap);
+    template<typename _FileIO>
+    static bool writeOverview(const std::string &directory, const glm::ivec2 &influenceSize, uint64_t descriptorKey, const InfluenceMap &influenceMap, const std::vector<float> &influenceNeighborMap);
+
+    //builds the preview with the caller's progress so cancelling the load also stops it, returns false if cancelled
+    bool generatePreview(Progress &progress);
+    static int sampleBaseHeight(const std::vector<float> &influenceNeighborMap, const glm::ivec2 &influenceSize, const glm::ivec2 &influenceGridSize, int worldHeight, const glm::vec2 &pos);
 
     void buildHeightMap(const glm::vec3 &startPos, const glm::ivec3 &lodSize, size_t stride);
 
-    void generatePlates(Progress &progress);
+    bool generatePlates(Progress &progress);
+    //fills the noise layers for rows [rowBegin, rowEnd), layers are sized to those rows only. No plate
+    //distance, the rows alone do not hold all the borders.
+    bool generateNoiseLayers(int rowBegin, int rowEnd, Progress &progress);
+    //coordinates followed by the noise passes, which only depend on the coordinates. Passes whose layer is
+    //cached with matching parameters are left out, returns a key combining all the noise layer keys. Plate
+    //distance is measured to boundaries, when given, otherwise to the borders within the rows, and is
+    //skipped when plateDistance is false.
+    uint64_t addNoiseStages(StageGraph &graph, int rowBegin, int rowEnd, Progress &progress, const PlateBoundaries *boundaries=nullptr,
+        bool plateDistance=true);
+    //plate distance layer for rows [rowBegin, rowEnd) from the plate layer covering those rows
+    bool generatePlateDistance(int rowBegin, int rowEnd, const PlateBoundaries *boundaries, Progress &progress);
+    //plate and border plate layers for the current positions, from the plate noise or the plate seeds. Border
+    //plates can be skipped when only the plates are needed, seeded plates always fill both.
+    bool generatePlateLayers(bool borderPlates, Progress &progress);
+    void invalidateStageCache();
+    bool generateCoordinates(int rowBegin, int rowEnd, Progress &progress);
+    //plate reductions and per cell processing, expects full map noise layers
+    bool processPlates(Progress &progress);
+    //reduction pass over plate rows in bands followed by one band plus halo at a time
+    bool generateStreamed(Progress &progress);
+    void buildPlateDetails(const PlateStatistics &statistics, std::vector<PlateInfo> &plateDetails) const;
+    //per cell processing and moisture for rows [rowBegin, rowEnd) from layers covering just those rows
+    bool processInfluenceRows(PerturbedWeatherBands &weather, const PlateStatistics &statistics, std::vector<PlateInfo> &plateDetails,
+        int rowBegin, int rowEnd, InfluenceCell *cells, Progress &progress);
+    bool generateNoise(const FastNoise::Generator *node, float *output, int seed, Progress &progress) const;
+    void releaseGeneration();
+    void applyLayerRetention();
     void generateContinents(Progress &progress);
-
-    void updateInfluenceNeighbors();
+    //plate points from the influence map, the same points buildPlateDetails uses. Seeded plates index the
+    //seeds instead.
+    void updatePlateIndex();
+    //world position to the unit sphere through the equirectangular map
+    glm::vec3 worldToSphere(const glm::vec2 &pos) const;
+    //world positions to the warped points seeded plates are assigned from
+    void warpPlatePoints(const glm::vec2 *positions, size_t count, glm::vec3 *points) const;
 
 //    WorldDescriptors<_Grid> *m_descriptors;
     WorldDescriptors m_descriptors;
@@ -241,9 +462,17 @@ private:
     InfluenceMap m_influenceMap;
     std::vector<float> m_influenceNeighborMap;
 
-    std::vector<float> m_xPositions;
-    std::vector<float> m_yPositions;
-    std::vector<float> m_zPositions;
+    GenerationLayers m_layers;
+    PlateIndex m_plateIndex;
+    //hash of the parameters each layer (by generation layer id) was last generated with, 0 if not valid
+    std::vector<uint64_t> m_layerKeys;
+
+    //working buffers reused between generations, positions point into it
+    GenerationArena m_arena;
+    float *m_xPositions;
+    float *m_yPositions;
+    float *m_zPositions;
+    size_t m_positionCount;
 //    std::unique_ptr<HastyNoise::VectorSet> m_influenceVectorSet;
 
     //    Regular2DGrid<InfluenceCell> m_influence;
@@ -265,15 +494,18 @@ private:
 //
 //    static std::vector<float> regionHeightMap;
 //    static std::unique_ptr<HastyNoise::VectorSet> regionVectorSet;
-    static thread_local ThreadStorage m_threadStorage;
-
-    //timing
-    double allocationTime=0.0;
-    double coordsTime=0.0;
-    double cellularPlateTime=0.0;
-    double cellularPlate2Time=0.0;
-    double cellularDistanceTime=0.0;
-    double processingTime=0.0;
+
+    //async load/save state
+    std::atomic<bool> m_ready;
+    std::shared_ptr<const OverviewPreview> m_preview;
+    std::mutex m_taskMutex;
+    std::shared_future<bool> m_loadTask;
+    std::vector<std::shared_future<bool>> m_saveTasks;
+
+    //per stage timings of the last generation, shard or merge
+    std::vector<StageTiming> m_stageTimings;
+    LayerRetention m_layerRetention;
+    int m_streamBandRows;
 };
 
 }//namespace worldgen
@@ -0,0 +1,62 @@
+#ifndef _worldgen_stdFileIO_h_
+#define _worldgen_stdFileIO_h_
+
+#include <string>
+#include <cstdio>
+#include <filesystem>
+
+namespace generic
+{
+namespace io
+{
+
+//file system access used by the generator load/save templates, specialized per backend
+template<typename _FileIO>
+struct fs;
+
+}//namespace io
+}//namespace generic
+
+namespace worldgen
+{
+
+//plain c stdio/std::filesystem backend, used by the command line tool and anything without a
+//virtual file system of its own
+struct StdFileIO {};
+
+}//namespace worldgen
+
+namespace generic
+{
+namespace io
+{
+
+template<>
+struct fs<worldgen::StdFileIO>
+{
+    typedef FILE Type;
+
+    static bool exists(const std::string &path)
+    {
+        std::error_code error;
+
+        return std::filesystem::exists(path, error);
+    }
+
+    static bool create_directory(const std::string &path)
+    {
+        std::error_code error;
+
+        return std::filesystem::create_directories(path, error);
+    }
+
+    static Type *open(const std::string &path, const char *mode) { return fopen(path.c_str(), mode); }
+    static size_t read(void *buffer, size_t size, size_t count, Type *file) { return fread(buffer, size, count, file); }
+    static size_t write(const void *buffer, size_t size, size_t count, Type *file) { return fwrite(buffer, size, count, file); }
+    static void close(Type *file) { fclose(file); }
+};
+
+}//namespace io
+}//namespace generic
+
+#endif //_worldgen_stdFileIO_h_
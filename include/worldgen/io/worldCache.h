@@ -0,0 +1,57 @@
+#ifndef _worldgen_worldCache_h_
+#define _worldgen_worldCache_h_
+
+#include "worldgen/export.h"
+
+#include <string>
+#include <cstdint>
+#include <mutex>
+
+namespace worldgen
+{
+
+//Content addressed store of generated worlds, one directory per key under the root. Entries are
+//written into a private staging directory and published with a rename, so readers never see a
+//partial world and concurrent bakes of the same key just keep the first. Entries are evicted least
+//recently used first once the total size goes over maxBytes.
+class WORLDGEN_EXPORT WorldCache
+{
+public:
+    //0 maxBytes is unlimited
+    WorldCache(const std::string &root, uint64_t maxBytes=0);
+
+    const std::string &root() const { return m_root; }
+
+    //directory of the published entry for key or empty if there is none, marks the entry as used
+    std::string find(uint64_t key);
+
+    //fresh directory to write an entry into, hand it to publish or abandon when done
+    std::string stage(uint64_t key);
+    //moves the staged entry into place and trims the cache, returns the published directory. If another
+    //process published the key first the staged copy is dropped and the existing entry returned.
+    std::string publish(uint64_t key, const std::string &stagingDirectory);
+    void abandon(const std::string &stagingDirectory);
+
+    //evicts least recently used entries until the cache fits maxBytes, keep is never evicted
+    void trim(uint64_t keep=0);
+
+    //bytes used by published entries
+    uint64_t size() const;
+
+    static std::string keyName(uint64_t key);
+
+private:
+    std::string entryDirectory(uint64_t key) const;
+
+    std::string m_root;
+    uint64_t m_maxBytes;
+
+    //random per cache instance so staging directories of separate processes never collide
+    uint64_t m_token;
+    std::mutex m_mutex;
+    uint64_t m_stagingIndex;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_worldCache_h_
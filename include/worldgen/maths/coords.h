@@ -57,7 +57,7 @@ inline float distance2(const typename ProjectionDetails<_Projection>::PointType
 template<Projections _From, Projections _To>
 void projectPoint(const typename ProjectionDetails<_From>::PointType &inPoint, typename ProjectionDetails<_To>::PointType &outPoint)
 {
-    static_assert(false);
+    static_assert(_From!=_From, "projectPoint not specialized for these projections");
 }
 
 template<>
@@ -138,7 +138,7 @@ template<Projections _Projection>
 float perpendicularDistanceSqrd(const typename ProjectionDetails<_Projection>::PointType &point, const typename ProjectionDetails<_Projection>::PointType &lineStart,
     const typename ProjectionDetails<_Projection>::PointType &lineEnd)
 {
-    using PointType=ProjectionDetails<_Projection>::PointType;
+    using PointType=typename ProjectionDetails<_Projection>::PointType;
 
     PointType delta=lineEnd-lineStart;
     PointType pointDelta=point-lineStart;
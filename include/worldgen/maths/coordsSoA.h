@@ -0,0 +1,41 @@
+#ifndef _worldgen_coordsSoA_h_
+#define _worldgen_coordsSoA_h_
+
+#include "worldgen/export.h"
+
+#include <cstddef>
+
+namespace worldgen
+{
+
+//Structure of arrays versions of the projectPoint batch helpers in coords.h. Each component is its own array
+//of count floats so the loops vectorize, trig goes through the fastMath.h approximations (max error 3e-7
+//radians, so ~1e-6 relative on the outputs). Same conventions as projectPoint: spherical is (radius, theta,
+//phi) with theta the azimuth in [0, 2pi) and phi the inclination in [-pi/2, pi/2], equirectangular is 0-1.0f
+//from the top left corner. Outputs must not overlap the inputs.
+
+WORLDGEN_EXPORT void equirectangularToSpherical(const float *u, const float *v, float *theta, float *phi, size_t count);
+WORLDGEN_EXPORT void sphericalToEquirectangular(const float *theta, const float *phi, float *u, float *v, size_t count);
+
+WORLDGEN_EXPORT void sphericalToCartesian(const float *radius, const float *theta, const float *phi, float *x, float *y, float *z, size_t count);
+//every point on a sphere of the given radius
+WORLDGEN_EXPORT void sphericalToCartesian(float radius, const float *theta, const float *phi, float *x, float *y, float *z, size_t count);
+WORLDGEN_EXPORT void cartesianToSpherical(const float *x, const float *y, const float *z, float *radius, float *theta, float *phi, size_t count);
+
+WORLDGEN_EXPORT void equirectangularToCartesian(const float *u, const float *v, float radius, float *x, float *y, float *z, size_t count);
+WORLDGEN_EXPORT void cartesianToEquirectangular(const float *x, const float *y, const float *z, float *u, float *v, size_t count);
+
+WORLDGEN_EXPORT void cartesianToStereographic(const float *x, const float *y, const float *z, float *sx, float *sy, size_t count);
+WORLDGEN_EXPORT void stereographicToCartesian(const float *sx, const float *sy, float *x, float *y, float *z, size_t count);
+
+//getSphericalCoords over a whole grid, columns 0 to columns-1 of each of the given rows, written row after
+//row. Theta only depends on the column and phi only on the row, so the trig runs once per column and once
+//per row rather than per point. Uses libm for those so the result matches getSphericalCoords exactly.
+WORLDGEN_EXPORT void getSphericalCoords(size_t width, size_t height, size_t columns, const float *rows, size_t rowCount, float radius,
+    float *x, float *y, float *z);
+//same for the full width of rows rowBegin to rowEnd-1
+WORLDGEN_EXPORT void getSphericalCoords(size_t width, size_t height, int rowBegin, int rowEnd, float radius, float *x, float *y, float *z);
+
+}//namespace worldgen
+
+#endif //_worldgen_coordsSoA_h_
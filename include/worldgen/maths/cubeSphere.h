@@ -0,0 +1,84 @@
+#ifndef _worldgen_cubeSphere_h_
+#define _worldgen_cubeSphere_h_
+
+#include "worldgen/export.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace worldgen
+{
+
+//faces in index order: +x, -x, +y, -y, +z, -z
+constexpr int CubeFaceCount=6;
+
+struct CubeCell
+{
+    int face;
+    int x;
+    int y;
+};
+
+//Unit sphere split into the six faces of a cube, each face a square grid of faceSize x faceSize cells. Faces use
+//the equi-angular mapping (cell edges are evenly spaced in angle rather than on the cube face), so the largest
+//cell is only ~1.4x the smallest instead of the ~5x of a plain cube projection or the unbounded ratio of an
+//equirectangular grid at the poles.
+//
+//Cells are stored face after face and tiled within a face, tileSize x tileSize cells row by row per tile, so
+//cells close on the sphere are close in memory. Every cell has a table of its 8 neighbors that continues over
+//the face edges, nothing using the grid needs to know where the seams are.
+class WORLDGEN_EXPORT CubeSphereGrid
+{
+public:
+    //neighbors are in the cell's own face orientation: (-1,-1) (0,-1) (1,-1) (-1,0) (1,0) (-1,1) (0,1) (1,1)
+    static constexpr int CellNeighborCount=8;
+
+    CubeSphereGrid();
+
+    //faceSize is rounded up to a multiple of tileSize
+    void build(int faceSize, int tileSize);
+    void clear();
+
+    int faceSize() const { return m_faceSize; }
+    int tileSize() const { return m_tileSize; }
+    size_t cellCount() const { return m_centers.size(); }
+
+    size_t index(int face, int x, int y) const;
+    size_t index(const CubeCell &cell) const { return index(cell.face, cell.x, cell.y); }
+    CubeCell cell(size_t index) const;
+
+    //unit direction of face coordinates, 0 to faceSize across the face. Coordinates past the face continue
+    //in the face's angles.
+    glm::vec3 direction(int face, float x, float y) const;
+    //face a direction falls on and its face coordinates (0 to faceSize), direction does not have to be normalized
+    int locate(const glm::vec3 &direction, glm::vec2 &coords) const;
+    size_t cellIndex(const glm::vec3 &direction) const;
+
+    //unit direction of the cell center
+    const glm::vec3 &center(size_t index) const { return m_centers[index]; }
+    //CellNeighborCount cell indices. The missing diagonal at the 8 cube corners repeats one of the edge neighbors.
+    const uint32_t *neighbors(size_t index) const { return &m_neighbors[index*CellNeighborCount]; }
+    //solid angle of the cell, the whole sphere is 4pi
+    float area(size_t index) const;
+
+    //cell centers on a sphere of radius, in index order
+    void positions(float radius, float *x, float *y, float *z) const;
+
+private:
+    glm::vec2 faceCoords(int face, const glm::vec3 &direction) const;
+    uint32_t neighbor(int face, int x, int y, int dx, int dy) const;
+
+    int m_faceSize;
+    int m_tileSize;
+    int m_tilesPerRow;
+
+    std::vector<glm::vec3> m_centers;
+    std::vector<uint32_t> m_neighbors;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_cubeSphere_h_
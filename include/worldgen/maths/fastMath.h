@@ -0,0 +1,183 @@
+#ifndef _worldgen_fastMath_h_
+#define _worldgen_fastMath_h_
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace worldgen
+{
+
+//Branch free float approximations for the SoA projections in coordsSoA.h. Every path is arithmetic and selects
+//so a loop calling them auto-vectorizes (SSE/AVX/NEON) instead of calling into libm per element. GCC and clang
+//only if-convert the selects with -fno-trapping-math and only vectorize sqrt with -fno-math-errno, the
+//translation units using these set both. Bounds are the maximum absolute error against double precision libm
+//over 2e7 random inputs, with and without fma contraction.
+//
+//  fastSinCos/fastSin/fastCos  |x|<=8192      <2.0e-7, the argument is reduced by pi/2 in two parts so the
+//                                             error only grows by ~|x|*2e-11 past that
+//  fastAtan                    all x          <2.0e-7
+//  fastAtan2                   all y, x       <3.0e-7, fastAtan2(0, 0)=0, result in [-pi, pi]
+//  fastAsin                    -1<=x<=1       <2.0e-7, inputs outside are clamped
+//
+//None of them handle nan or infinity.
+
+namespace fastMathDetail
+{
+
+constexpr float pi=3.14159265358979f;
+constexpr float halfPi=1.57079632679490f;
+constexpr float quarterPi=0.78539816339745f;
+constexpr float twoOverPi=0.63661977236758f;
+//pi/2 split so j*halfPiHigh is exact for |j|<2^12
+constexpr float halfPiHigh=1.5703125f;
+constexpr float halfPiLow=4.83826794897e-4f;
+constexpr float tanEighthPi=0.41421356237310f;
+
+inline float abs(float x)
+{
+    return (x<0.0f)?-x:x;
+}
+
+//copies the sign of s onto the magnitude of x
+inline float copySign(float x, float s)
+{
+    uint32_t xBits, sBits;
+
+    std::memcpy(&xBits, &x, sizeof(float));
+    std::memcpy(&sBits, &s, sizeof(float));
+    xBits=(xBits&0x7fffffffu)|(sBits&0x80000000u);
+    std::memcpy(&x, &xBits, sizeof(float));
+    return x;
+}
+
+//round to nearest, valid for |x|<2^22
+inline float roundNearest(float x)
+{
+    const float magic=12582912.0f; //1.5*2^23
+
+    return (x+magic)-magic;
+}
+
+//minimax polynomials on [-pi/4, pi/4] (cephes sinf/cosf)
+inline float sinPoly(float r)
+{
+    float r2=r*r;
+
+    return r+r*r2*(-1.6666654611e-1f+r2*(8.3321608736e-3f+r2*-1.9515295891e-4f));
+}
+
+inline float cosPoly(float r)
+{
+    float r2=r*r;
+
+    return 1.0f-0.5f*r2+r2*r2*(4.166664568298827e-2f+r2*(-1.388731625493765e-3f+r2*2.443315711809948e-5f));
+}
+
+//atan on [0, tan(pi/8)] (cephes atanf)
+inline float atanPoly(float x)
+{
+    float z=x*x;
+
+    return x+x*z*(-3.33329491539e-1f+z*(1.99777106478e-1f+z*(-1.38776856032e-1f+z*8.05374449538e-2f)));
+}
+
+//atan for 0<=x<=1
+inline float atanUnit(float x)
+{
+    //atan(x)=pi/4+atan((x-1)/(x+1)) above tan(pi/8), the select is on the operands so there is always exactly one
+    //division and no branch
+    float k=(x>tanEighthPi)?1.0f:0.0f;
+    float t=(x-k)/(1.0f+k*x);
+
+    return k*quarterPi+atanPoly(t);
+}
+
+}//namespace fastMathDetail
+
+inline void fastSinCos(float x, float &sinX, float &cosX)
+{
+    using namespace fastMathDetail;
+
+    float j=roundNearest(x*twoOverPi);
+    float r=(x-j*halfPiHigh)-j*halfPiLow;
+    int quadrant=(int)j&3;
+
+    float s=sinPoly(r);
+    float c=cosPoly(r);
+
+    //rotate by quadrant*pi/2
+    bool swap=(quadrant&1)!=0;
+    float sinR=swap?c:s;
+    float cosR=swap?s:c;
+
+    sinX=(quadrant&2)?-sinR:sinR;
+    cosX=((quadrant+1)&2)?-cosR:cosR;
+}
+
+inline float fastSin(float x)
+{
+    float s, c;
+
+    fastSinCos(x, s, c);
+    return s;
+}
+
+inline float fastCos(float x)
+{
+    float s, c;
+
+    fastSinCos(x, s, c);
+    return c;
+}
+
+inline float fastAtan(float x)
+{
+    using namespace fastMathDetail;
+
+    float a=abs(x);
+    bool invert=(a>1.0f);
+    //atan(x)=pi/2-atan(1/x)
+    float t=atanUnit((invert?1.0f:a)/(invert?a:1.0f));
+
+    return copySign(invert?halfPi-t:t, x);
+}
+
+inline float fastAtan2(float y, float x)
+{
+    using namespace fastMathDetail;
+
+    float ax=abs(x);
+    float ay=abs(y);
+    float maxXY=(ax>ay)?ax:ay;
+    float minXY=(ax>ay)?ay:ax;
+    //0/0 reduces to atan(0)
+    float t=atanUnit(minXY/((maxXY>0.0f)?maxXY:1.0f));
+
+    t=(ay>ax)?halfPi-t:t;
+    t=(x<0.0f)?pi-t:t;
+    return copySign(t, y);
+}
+
+inline float fastAsin(float x)
+{
+    using namespace fastMathDetail;
+
+    float a=abs(x);
+
+    a=(a>1.0f)?1.0f:a;
+
+    //asin(a)=pi/2-2*asin(sqrt((1-a)/2)) keeps the polynomial on [0, 0.5]
+    bool reduce=(a>0.5f);
+    float z=reduce?0.5f*(1.0f-a):a*a;
+    //z is never negative, sqrt is taken for every lane
+    float root=std::sqrt(z);
+    float t=reduce?root:a;
+    float p=t+t*z*(1.6666752422e-1f+z*(7.4953002686e-2f+z*(4.5470025998e-2f+z*(2.4181311049e-2f+z*4.2163199048e-2f))));
+
+    return copySign(reduce?halfPi-2.0f*p:p, x);
+}
+
+}//namespace worldgen
+
+#endif //_worldgen_fastMath_h_
@@ -0,0 +1,21 @@
+#ifndef _worldgen_noiseNodes_h_
+#define _worldgen_noiseNodes_h_
+
+#include "worldgen/export.h"
+
+#include <FastNoise/FastNoise.h>
+
+namespace worldgen
+{
+
+//noise graphs shared by the generators, every call builds a new graph so nothing is shared between stages
+
+//fbm over open simplex, optionally domain warped
+WORLDGEN_EXPORT FastNoise::SmartNode<> newFractalNoise(float scale, bool warp, FastSIMD::eLevel simdLevel);
+//cellular source through a fractal domain warp, scaled to frequency
+WORLDGEN_EXPORT FastNoise::SmartNode<> newWarpedCellular(const FastNoise::SmartNode<> &cellular, float frequency, FastSIMD::eLevel simdLevel);
+WORLDGEN_EXPORT FastNoise::SmartNode<> newCellularValue(int valueIndex, FastSIMD::eLevel simdLevel);
+
+}//namespace worldgen
+
+#endif //_worldgen_noiseNodes_h_
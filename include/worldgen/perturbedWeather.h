@@ -3,6 +3,7 @@
 
 #include "worldgen/weather.h"
 #include "worldgen/maths/coords.h"
+#include "worldgen/utils/simdLevel.h"
 
 #include <glm/glm.hpp>
 
@@ -26,7 +27,7 @@ struct WeatherCellInfo
 class PerturbedWeatherBands:public WeatherBands
 {
 public:
-    PerturbedWeatherBands(int seed, const glm::ivec2 &size, std::vector<WeatherCell> cells);
+    PerturbedWeatherBands(int seed, const glm::ivec2 &size, std::vector<WeatherCell> cells, SimdLevel simdLevel=SimdLevel::Auto);
     
     size_t getCellIndex(const glm::vec2 &coord);
     glm::vec2 getWindDirection(const glm::vec2 &coord);
@@ -40,6 +41,9 @@ private:
     std::vector<std::vector<WeatherCellInfo>> m_cellsInfo;
 };
 
+//latitude bands of the weather cells the generators use, perturbed per seed by PerturbedWeatherBands
+std::vector<WeatherCell> getWeatherCells();
+
 }//namespace worldgen
 
 #endif //_worldgen_weather_h_
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef _worldgen_plateBoundaries_h_
+#define _worldgen_plateBoundaries_h_
+
+#include "worldgen/export.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace worldgen
+{
+
+class ThreadPool;
+
+//Cells of an equirectangular plate map that touch a different plate, 4 connected and wrapping in x. Both
+//cells of a differing pair are marked. One bit per cell stored by column, so a whole map is kept even when
+//the plate layer itself is only generated a band at a time.
+class WORLDGEN_EXPORT PlateBoundaries
+{
+public:
+    PlateBoundaries();
+
+    void reset(int width, int height);
+
+    //marks the boundaries of rows [rowBegin, rowEnd) of a plate map holding just those rows. Bands have to be
+    //added top to bottom, the last row is kept to find the boundaries against the next band.
+    void addRows(const float *plateMap, int rowBegin, int rowEnd);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    bool boundary(int x, int y) const { return (m_bits[word(x, y)]>>(y&63))&1; }
+    //closest boundary row in column x at or above y, -1 if there is none
+    int previous(int x, int y) const;
+    //closest boundary row in column x at or below y, height if there is none
+    int next(int x, int y) const;
+
+private:
+    size_t word(int x, int y) const { return (size_t)x*m_columnWords+(y>>6); }
+    void mark(int x, int y) { m_bits[word(x, y)]|=(uint64_t)1<<(y&63); }
+
+    int m_width;
+    int m_height;
+    size_t m_columnWords;
+    std::vector<uint64_t> m_bits;
+
+    std::vector<float> m_lastRow;
+    int m_lastRowIndex;
+};
+
+//Exact distance from every cell of rows [rowBegin, rowEnd) to the closest boundary cell, written row after
+//row into distance. Separable squared euclidean transform (Felzenszwalb and Huttenlocher): a column pass
+//parallel over columns, then a lower envelope of parabolas per row parallel over rows that wraps in x.
+//Linear in the cells. Distances are in rows (latitude steps). The row pass scales x by the cosine of the
+//row's latitude, so it measures the way the sphere does around each cell rather than the stretched map. Cells
+//with no boundary reachable get infinity.
+WORLDGEN_EXPORT void boundaryDistance(const PlateBoundaries &boundaries, int rowBegin, int rowEnd, float *distance, ThreadPool *pool);
+
+}//namespace worldgen
+
+#endif //_worldgen_plateBoundaries_h_
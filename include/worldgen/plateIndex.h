@@ -0,0 +1,68 @@
+#ifndef _worldgen_plateIndex_h_
+#define _worldgen_plateIndex_h_
+
+#include "worldgen/export.h"
+#include "worldgen/tectonics.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace worldgen
+{
+
+class ThreadPool;
+
+//closest and second closest plate to a position, second is the same as first when there is only one plate
+struct PlateQuery
+{
+    uint32_t plate;
+    uint32_t borderPlate;
+};
+
+//Nearest plate lookups on the sphere without the influence map. A k-d tree over the plate points
+//(PlateInfo::point3d) projected to the unit sphere, the closest point by chord is the closest along the
+//sphere so the tree works in 3d with no seams or pole cases. Queries are exact and O(log plates), so plate
+//membership can be asked for any position at any resolution. Membership is by closest plate point, the
+//voronoi cells of the plate points rather than the ragged borders of the influence map.
+class WORLDGEN_EXPORT PlateIndex
+{
+public:
+    PlateIndex();
+
+    //plate indices returned are the index into plates
+    void build(const std::vector<PlateInfo> &plates);
+    //points do not have to be normalized, index i is points[i]
+    void build(const std::vector<glm::vec3> &points);
+    //points[i] reports plates[i]
+    void build(const std::vector<glm::vec3> &points, const std::vector<uint32_t> &plates);
+    void clear();
+
+    size_t size() const { return m_points.size(); }
+    bool empty() const { return m_points.empty(); }
+
+    //positions do not have to be normalized, the index must not be empty
+    uint32_t nearest(const glm::vec3 &position) const;
+    PlateQuery nearest2(const glm::vec3 &position) const;
+
+    //batches, split over the pool when given
+    void nearest(const glm::vec3 *positions, size_t count, uint32_t *plates, ThreadPool *pool=nullptr) const;
+    void nearest2(const glm::vec3 *positions, size_t count, PlateQuery *queries, ThreadPool *pool=nullptr) const;
+    //structure of arrays positions, as the generator keeps them
+    void nearest2(const float *x, const float *y, const float *z, size_t count, uint32_t *plates, uint32_t *borderPlates, ThreadPool *pool=nullptr) const;
+
+private:
+    void buildRange(size_t begin, size_t end);
+    void search(const glm::vec3 &position, size_t begin, size_t end, uint32_t *closest, float *distances) const;
+
+    //tree in place, the node of range [begin, end) is the median (begin+end)/2 and splits on m_axes of it
+    std::vector<glm::vec3> m_points;
+    std::vector<uint32_t> m_plates;
+    std::vector<uint8_t> m_axes;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_plateIndex_h_
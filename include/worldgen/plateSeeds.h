@@ -0,0 +1,64 @@
+#ifndef _worldgen_plateSeeds_h_
+#define _worldgen_plateSeeds_h_
+
+#include "worldgen/export.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace worldgen
+{
+
+class ThreadPool;
+
+//Tectonic plates grown from a fixed number of seeds on the unit sphere rather than from cellular noise, so
+//the plate count is exactly the seed count. Seeds sit on a jittered fibonacci sphere. The closest seeds of
+//every cell of a coarse latitude/longitude grid are found by jump flooding (wrapping in longitude), the grid
+//then limits every lookup to the seeds of the 3x3 cells around it.
+class WORLDGEN_EXPORT PlateSeeds
+{
+public:
+    //closest seeds kept per grid cell. Two are needed for the plate and border plate, the extra ones catch
+    //the seeds that are only closest to part of a cell.
+    static constexpr int SeedsPerCell=4;
+
+    PlateSeeds();
+
+    //seed is the random seed, values are count distinct plate values spread over [-1, 1)
+    void build(size_t count, int seed, ThreadPool *pool);
+
+    size_t size() const { return m_positions.size(); }
+    const std::vector<glm::vec3> &positions() const { return m_positions; }
+    const std::vector<float> &values() const { return m_values; }
+    //typical angle between neighboring seeds
+    float spacing() const { return m_spacing; }
+
+    //values of the closest and second closest seed to each position, positions do not have to be
+    //normalized. Results only depend on the position, not on how the positions are split into calls.
+    void assign(const float *x, const float *y, const float *z, size_t count, float *plate, float *plate2, ThreadPool *pool) const;
+
+private:
+    //grid cell of equirectangular coordinates
+    size_t cellIndex(float u, float v) const;
+    void flood(ThreadPool *pool);
+    void gatherCandidates();
+
+    std::vector<glm::vec3> m_positions;
+    std::vector<float> m_values;
+    float m_spacing;
+
+    int m_gridWidth;
+    int m_gridHeight;
+    std::vector<glm::vec3> m_cellCenters;
+    //SeedsPerCell closest seeds of each grid cell, closest first, -1 when not found
+    std::vector<int> m_closest;
+    //distinct seeds of the 3x3 cells around each grid cell, cell i's are [m_candidateOffsets[i], m_candidateOffsets[i+1])
+    std::vector<size_t> m_candidateOffsets;
+    std::vector<int> m_candidates;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_plateSeeds_h_
@@ -1,42 +1,127 @@
 #ifndef _worldgen_progress_h_
 #define _worldgen_progress_h_
 
-#include <mutex>
+#include <atomic>
 #include <string>
+#include <cstdint>
 
 namespace worldgen
 {
 
+enum class Stage:uint16_t
+{
+    Idle,
+    Loading,
+    Preview,
+    WeatherBands,
+    Allocating,
+    Coordinates,
+    HeightMap,
+    Terrain,
+    AirCurrents,
+    TectonicPlates,
+    Continents,
+    PlateHeight,
+    TectonicZones,
+    InfluenceMap,
+    Moisture,
+    Neighbors,
+    Saving,
+    Complete,
+    Cancelled,
+    Count
+};
+
+//interned so progress updates never allocate
+inline const char *stageName(Stage stage)
+{
+    static const char *names[]=
+    {
+        "Idle",
+        "Loading overview",
+        "Generating preview",
+        "Generating weather bands",
+        "Allocating resources",
+        "Generating coordinates",
+        "Generating heightmap",
+        "Generating terrain",
+        "Generating air currents",
+        "Generating tectonic plates",
+        "Generating continents",
+        "Generating height map",
+        "Generating tectonic zones",
+        "Generating influence map",
+        "Generating moisture",
+        "Normalize neighbors",
+        "Saving",
+        "Generating complete",
+        "Cancelled"
+    };
+    static_assert(sizeof(names)/sizeof(names[0])==(size_t)Stage::Count, "stage names out of sync with Stage");
+
+    if(stage>=Stage::Count)
+        return "Unknown";
+    return names[(size_t)stage];
+}
+
+//Progress and cancellation token shared between a generation and its observers. Stage, percentage
+//and completion are packed into a single atomic so readers always see a consistent triple without
+//taking a lock, the generator polls cancelled() between stages and row bands.
 class Progress
 {
 public:
-    Progress():m_progress(0), m_complete(false) {}
+    Progress():m_state(pack(Stage::Idle, 0, false)), m_cancel(false) {}
 
-    void update(std::string status, int progress, bool complete)
+    void update(Stage stage, int progress, bool complete=false)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        m_state.store(pack(stage, progress, complete), std::memory_order_release);
+    }
 
-        m_status=status;
-        m_progress=progress;
-        m_complete=complete;
+    void get(Stage &stage, int &progress, bool &complete) const
+    {
+        unpack(m_state.load(std::memory_order_acquire), stage, progress, complete);
     }
 
-    void get(std::string &status, int &progress, bool &complete)
+    void get(std::string &status, int &progress, bool &complete) const
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        Stage stage;
+
+        get(stage, progress, complete);
+        status=stageName(stage);
+    }
+
+    Stage stage() const { Stage stage; int progress; bool complete; get(stage, progress, complete); return stage; }
+    int progress() const { Stage stage; int progress; bool complete; get(stage, progress, complete); return progress; }
+    bool complete() const { Stage stage; int progress; bool complete; get(stage, progress, complete); return complete; }
+
+    //request the generation using this token stop at the next check
+    void cancel() { m_cancel.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return m_cancel.load(std::memory_order_relaxed); }
 
-        status=m_status;
-        progress=m_progress;
-        complete=m_complete;
+    //rearm the token for another run
+    void reset()
+    {
+        m_cancel.store(false, std::memory_order_relaxed);
+        m_state.store(pack(Stage::Idle, 0, false), std::memory_order_release);
     }
 
 private:
-    std::mutex m_mutex;
-    std::string m_status;
-    int m_progress;
-    bool m_complete;
+    static uint32_t pack(Stage stage, int progress, bool complete)
+    {
+        return ((uint32_t)stage<<16)|((uint32_t)(progress&0x7fff)<<1)|(complete?1u:0u);
+    }
+
+    static void unpack(uint32_t state, Stage &stage, int &progress, bool &complete)
+    {
+        stage=(Stage)(state>>16);
+        progress=(int)((state>>1)&0x7fff);
+        complete=(state&1u)!=0;
+    }
+
+    std::atomic<uint32_t> m_state;
+    std::atomic<bool> m_cancel;
 };
 
 }//namespace worldgen
 
-#endif //_worldgen_loadprogress_h_
\ No newline at end of file
+#endif //_worldgen_loadprogress_h_
@@ -0,0 +1,26 @@
+#ifndef _worldgen_render_layerKernels_h_
+#define _worldgen_render_layerKernels_h_
+
+#include <cstdint>
+
+namespace worldgen
+{
+namespace render
+{
+
+//AVX2 versions of the layer renderer's row kernels. They live in their own translation unit built with AVX2
+//enabled (see CMakeLists.txt) while the rest of the library stays at the baseline, the renderer only calls them
+//when avx2Kernels() says the unit has them and the cpu runs them. Each does whole groups of 8 and returns how
+//many values it wrote, the caller finishes the rest. The unit includes nothing but the intrinsics, so no inline
+//function compiled with AVX2 can be merged into code run on other cpus.
+bool avx2KernelsBuilt();
+
+int lutIndicesAvx2(const float *values, int count, float scale, float offset, int32_t size, int32_t *indices);
+int clampIndicesAvx2(const int32_t *values, int count, int32_t size, int32_t *indices);
+int gatherAvx2(const uint32_t *lut, const int32_t *indices, int count, uint32_t *output);
+int addSaturateAvx2(const uint32_t *overlay, int count, uint32_t *output);
+
+}//namespace render
+}//namespace worldgen
+
+#endif //_worldgen_render_layerKernels_h_
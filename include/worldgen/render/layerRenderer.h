@@ -0,0 +1,148 @@
+#ifndef _worldgen_render_layerRenderer_h_
+#define _worldgen_render_layerRenderer_h_
+
+#include "worldgen/export.h"
+#include "worldgen/tectonics.h"
+#include "worldgen/utils/colorMap.h"
+#include "worldgen/utils/threadPool.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <tuple>
+#include <cstdint>
+
+namespace worldgen
+{
+namespace render
+{
+
+//colors are packed RGBA8 with red in the low byte, so a buffer of them is laid out the same as
+//GL_RGBA/GL_UNSIGNED_BYTE and can be uploaded or written out directly
+inline uint32_t packColor(int r, int g, int b, int a=255)
+{
+    return (uint32_t)clamp(r, 0, 255)|((uint32_t)clamp(g, 0, 255)<<8)|((uint32_t)clamp(b, 0, 255)<<16)|((uint32_t)clamp(a, 0, 255)<<24);
+}
+
+inline uint32_t packColor(const glm::ivec4 &color) { return packColor(color.r, color.g, color.b, color.a); }
+
+struct ColorLut
+{
+    std::vector<uint32_t> colors;
+};
+
+struct ColorLut2D
+{
+    ColorLut2D():width(0), height(0) {}
+
+    int width;
+    int height;
+    std::vector<uint32_t> colors;
+};
+
+WORLDGEN_EXPORT ColorLut makeLut(const ColorMap &colorMap);
+WORLDGEN_EXPORT ColorLut2D makeLut(const ColorMap2D &colorMap);
+WORLDGEN_EXPORT ColorLut makeLut(const std::vector<std::tuple<int, int, int>> &colors);
+
+//structure of arrays copy of the influence map fields the layers read, built once per generation
+//so colorizing only streams the fields it needs
+struct WORLDGEN_EXPORT Fields
+{
+    void build(const std::vector<InfluenceCell> &influenceMap, const glm::ivec2 &size, ThreadPool *pool=nullptr);
+
+    glm::ivec2 size;
+
+    std::vector<float> heightBase;
+    std::vector<float> plateHeight;
+    std::vector<float> plateDistanceValue;
+    std::vector<float> collision;
+    std::vector<float> terrainScale;
+    std::vector<float> temperature;
+    std::vector<float> moisture;
+    std::vector<int32_t> tectonicPlate;
+    std::vector<int32_t> weatherCell;
+    std::vector<int32_t> weatherBand;
+};
+
+//luts are expected to be non-empty
+struct Palette
+{
+    ColorLut2D biome;
+    ColorLut temperature;
+    ColorLut moisture;
+    ColorLut plates;
+};
+
+//the biome, temperature and moisture scales used by the viewer with random colors for plateCount plates
+WORLDGEN_EXPORT Palette defaultPalette(int plateCount);
+
+enum class Layer
+{
+    Biome,          //height/moisture biome colors with polar caps
+    Height,         //heightBase as grey
+    PlateHeight,    //plateHeight through the biome colors
+    Plates,         //tectonic plate colors
+    Grey,           //LayerSettings::grey mapped through greyMin/greyMax
+    RedGreen,       //LayerSettings::red and green as 0-1 channels
+    Black
+};
+
+enum class Overlay
+{
+    None,
+    Collision,
+    CollisionDistance,
+    TerrainScale,
+    Temperature,
+    Moisture,
+    LandMoisture,
+    WeatherCell,
+    WeatherBand
+};
+
+struct LayerSettings
+{
+    LayerSettings():layer(Layer::Biome), overlay(Overlay::None), grey(nullptr), greyMin(0.0f), greyMax(1.0f), red(nullptr), green(nullptr) {}
+
+    Layer layer;
+    Overlay overlay;
+
+    //external fields, same size as Fields
+    const float *grey;
+    float greyMin;
+    float greyMax;
+    const float *red;
+    const float *green;
+};
+
+//source rectangle in field cells, every stride'th cell is sampled so the output is
+//ceil(width/stride) x ceil(height/stride)
+struct Region
+{
+    Region():x(0), y(0), width(0), height(0), stride(1) {}
+    Region(int x, int y, int width, int height, int stride=1):x(x), y(y), width(width), height(height), stride(stride) {}
+
+    int outputWidth() const { return (width+stride-1)/stride; }
+    int outputHeight() const { return (height+stride-1)/stride; }
+
+    int x;
+    int y;
+    int width;
+    int height;
+    int stride;
+};
+
+//colorizes region into output, outputPitch is in pixels. Rows are split across the pool when given.
+WORLDGEN_EXPORT void renderLayer(const Fields &fields, const Palette &palette, const LayerSettings &settings, const Region &region,
+    uint32_t *output, size_t outputPitch, ThreadPool *pool=nullptr);
+
+//full field at stride 1 into a tightly packed buffer
+WORLDGEN_EXPORT void renderLayer(const Fields &fields, const Palette &palette, const LayerSettings &settings, std::vector<uint32_t> &output,
+    ThreadPool *pool=nullptr);
+
+WORLDGEN_EXPORT void fieldRange(const float *field, size_t size, float &min, float &max);
+
+}//namespace render
+}//namespace worldgen
+
+#endif //_worldgen_render_layerRenderer_h_
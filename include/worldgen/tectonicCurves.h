@@ -0,0 +1,141 @@
+#ifndef _worldgen_tectonicCurves_h_
+#define _worldgen_tectonicCurves_h_
+
+#include "worldgen/export.h"
+#include "worldgen/tectonics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+namespace worldgen
+{
+
+//Boundary terrain curves of tectonics.h by boundary type. Convergent and divergent each come in the four
+//ocean/continent pairings of calculateConvergentCurve/calculateDivergentCurve, plus no curve for cells
+//without a moving boundary.
+enum TectonicCurve:uint8_t
+{
+    ConvergentContinentContinent,
+    ConvergentContinentOcean,
+    ConvergentOceanContinent,
+    ConvergentOceanOcean,
+    DivergentContinentContinent,
+    DivergentContinentOcean,
+    DivergentOceanContinent,
+    DivergentOceanOcean,
+    NoTectonicCurve,
+    TectonicCurveCount
+};
+
+//collision<0 divergent, >0 convergent, 0 none
+inline TectonicCurve tectonicCurve(float collision, bool plate1Ocean, bool plate2Ocean)
+{
+    int pairing=(plate1Ocean?2:0)+(plate2Ocean?1:0);
+
+    if(collision<0.0f)
+        return (TectonicCurve)(DivergentContinentContinent+pairing);
+    if(collision>0.0f)
+        return (TectonicCurve)(ConvergentContinentContinent+pairing);
+    return NoTectonicCurve;
+}
+
+//analytic value, what the tables are built from
+constexpr float tectonicCurveValue(TectonicCurve curve, float distance)
+{
+    if(curve==NoTectonicCurve)
+        return 0.0f;
+
+    bool plate1Ocean=((curve-ConvergentContinentContinent)&2)!=0;
+    bool plate2Ocean=((curve-ConvergentContinentContinent)&1)!=0;
+
+    if(curve>=DivergentContinentContinent)
+        return calculateDivergentCurve(distance, plate1Ocean, plate2Ocean);
+    return calculateConvergentCurve(distance, plate1Ocean, plate2Ocean);
+}
+
+//Every curve sampled at _Resolution+1 evenly spaced distances over 0-1.0f and read back with linear
+//interpolation, distances outside that (and nan) are clamped. The constructor is constexpr so a table built
+//as a constant is baked into the binary. Error against tectonicCurveValue falls with the square of the
+//resolution, use maxError to pick one.
+template<size_t _Resolution>
+class TectonicCurveTable
+{
+public:
+    static_assert(_Resolution>=2, "tectonic curve tables need at least 2 intervals");
+
+    static constexpr size_t resolution=_Resolution;
+    static constexpr size_t stride=_Resolution+1;
+
+    constexpr TectonicCurveTable():m_values{}
+    {
+        for(size_t curve=0; curve<TectonicCurveCount; ++curve)
+        {
+            for(size_t i=0; i<stride; ++i)
+                m_values[curve*stride+i]=tectonicCurveValue((TectonicCurve)curve, (float)i/_Resolution);
+        }
+    }
+
+    float operator()(TectonicCurve curve, float distance) const
+    {
+        return lookup(curve, distance);
+    }
+
+    //values[i] is curve curves[i] at distances[i], values can be distances
+    void evaluate(const TectonicCurve *curves, const float *distances, float *values, size_t count) const
+    {
+        for(size_t i=0; i<count; ++i)
+            values[i]=lookup(curves[i], distances[i]);
+    }
+
+    //largest difference to the analytic curves over samples points per table interval
+    float maxError(size_t samples=16) const
+    {
+        float error=0.0f;
+
+        for(size_t curve=0; curve<TectonicCurveCount; ++curve)
+        {
+            for(size_t i=0; i<=_Resolution*samples; ++i)
+            {
+                float distance=(float)i/(_Resolution*samples);
+                float delta=lookup((TectonicCurve)curve, distance)-tectonicCurveValue((TectonicCurve)curve, distance);
+
+                error=std::max(error, std::abs(delta));
+            }
+        }
+        return error;
+    }
+
+private:
+    float lookup(TectonicCurve curve, float distance) const
+    {
+        //selects rather than branches, written so a nan distance clamps to 0
+        float position=((distance>0.0f)?distance:0.0f)*_Resolution;
+
+        position=(position<(float)_Resolution)?position:(float)_Resolution;
+
+        size_t index=(size_t)position;
+
+        //distance 1.0f interpolates the last interval at its end
+        index=(index<_Resolution)?index:_Resolution-1;
+
+        const float *values=&m_values[curve*stride+index];
+        float t=position-(float)index;
+
+        return values[0]+(values[1]-values[0])*t;
+    }
+
+    float m_values[TectonicCurveCount*stride];
+};
+
+//Resolution the generator uses. A multiple of 10 puts the branch points of the curves (0.6, 0.7, 0.8, 0.9)
+//on samples so the error is only the interpolation's, at 2000 that is <5e-5 for 72KiB of tables.
+constexpr size_t TectonicCurveResolution=2000;
+
+//built at compile time where the compiler's constant evaluation limits allow it, at load otherwise
+WORLDGEN_EXPORT const TectonicCurveTable<TectonicCurveResolution> &tectonicCurveTable();
+
+}//namespace worldgen
+
+#endif //_worldgen_tectonicCurves_h_
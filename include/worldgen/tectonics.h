@@ -2,6 +2,13 @@
 #define _worldgen_tectonics_h_
 
 #include "worldgen/export.h"
+#include "worldgen/maths/math_helpers.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
 
 namespace worldgen
 {
@@ -67,33 +74,35 @@ struct PlateInfo
     std::vector<float> neighborCollisions;
 };
 
+//Random drift direction for every plate (seeded, in plate order) rotated to the plate's point3d, then the
+//collision with each of its neighbors from how the drifts move the plate points towards each other. Expects
+//point3d and neighbors to be set.
+WORLDGEN_EXPORT void initPlateMotion(std::vector<PlateInfo> &plates, int seed);
+
+//plate2 takes up to half the height past the cutoff, written without a branch as it runs for every cell
 inline void calculateCurve(float distance, float &plate1, float &plate2, float cutoff=0.07f)
 {
-    if(distance>cutoff)
-    {
-        float d=(distance-cutoff)*(1.0f/(1.0f-cutoff));
-        plate2=d*0.5f;
-        //        plate2=(d*d)*0.5f;
-        plate1=1.0f-plate2;
-    }
-    else
-    {
-        plate1=1.0f;
-        plate2=0.0f;
-    }
+    //a nan distance (single cell plate) stays all plate1 like before
+    float d=((distance>cutoff)?distance-cutoff:0.0f)*(1.0f/(1.0f-cutoff));
+
+    plate2=d*0.5f;
+    //        plate2=(d*d)*0.5f;
+    plate1=1.0f-plate2;
 }
 
-inline float subductionCurve(float distance)
+//The boundary curves are constexpr so tectonicCurves.h can bake them into tables at compile time, integer
+//powers go through the constexpr pow in math_helpers.h
+constexpr float subductionCurve(float distance)
 {
     if(distance>0.9)
     {
         distance=(distance-0.9)*10.0f;
-        return (1.0f/(1.0f+pow(((1.0f-distance)/distance), 3.0f)))*0.5f+0.5;
+        return (1.0f/(1.0f+pow(((1.0f-distance)/distance), 3)))*0.5f+0.5;
     }
     else if(distance>0.8)
     {
         distance=(distance-0.8)*10.0f;
-        return (1.0f/(1.0f+pow(((1.0f-distance)/distance), 3.0f)))*0.3+0.2;
+        return (1.0f/(1.0f+pow(((1.0f-distance)/distance), 3)))*0.3+0.2;
     }
     if(distance>0.6)
     {
@@ -103,28 +112,28 @@ inline float subductionCurve(float distance)
     return 0.0f;
 }
 
-inline float orogenicCurve(float distance)
+constexpr float orogenicCurve(float distance)
 {
     if(distance>0.6)
     {
         distance=(distance-0.6)*2.5f;
-        return 1.0f/(1.0f+pow(3.0f*(1.0f-distance)/distance, 2.0f));
+        return 1.0f/(1.0f+pow(3.0f*(1.0f-distance)/distance, 2));
         //        return (distance*distance);
     }
     return 0.0f;
 }
 
-inline float divergentCurve(float distance, float cutoff=0.9)
+constexpr float divergentCurve(float distance, float cutoff=0.9)
 {
     if(distance>cutoff)
     {
         distance=(distance-cutoff)/(1.0f-cutoff);
-        return -(1.0f/(1.0f+pow(((1.0f-distance)/distance), 3.0f)));
+        return -(1.0f/(1.0f+pow(((1.0f-distance)/distance), 3)));
     }
     return 0.0f;
 }
 
-inline float calculateConvergentCurve(float distance, bool plate1Ocean, bool plate2Ocean)
+constexpr float calculateConvergentCurve(float distance, bool plate1Ocean, bool plate2Ocean)
 {
     if(plate1Ocean && plate2Ocean)
         return orogenicCurve(distance)*0.5f;
@@ -135,7 +144,7 @@ inline float calculateConvergentCurve(float distance, bool plate1Ocean, bool pla
     return orogenicCurve(distance);
 }
 
-inline float calculateDivergentCurve(float distance, bool plate1Ocean, bool plate2Ocean)
+constexpr float calculateDivergentCurve(float distance, bool plate1Ocean, bool plate2Ocean)
 {
     if(plate1Ocean && plate2Ocean)
         return divergentCurve(distance, 0.7f)*0.5f;
@@ -0,0 +1,60 @@
+#ifndef _worldgen_generationArena_h_
+#define _worldgen_generationArena_h_
+
+#include "worldgen/export.h"
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace worldgen
+{
+
+//Working buffers kept between generations. Each slot holds one cache line aligned slab that is only
+//reallocated when a request outgrows it, so regenerating the same world does no large allocations.
+//Slabs come from allocateLayerMemory and follow the LayerMemoryPolicy.
+//Slabs are handed out uninitialized, users are expected to overwrite them. Different slots can be
+//requested from different threads, the same slot can not.
+class WORLDGEN_EXPORT GenerationArena
+{
+public:
+    static constexpr size_t Alignment=64;
+
+    GenerationArena(size_t slotCount);
+    ~GenerationArena();
+
+    GenerationArena(const GenerationArena &)=delete;
+    GenerationArena &operator=(const GenerationArena &)=delete;
+
+    //contents are undefined, including when the slab is reused
+    template<typename _Type>
+    _Type *get(size_t slot, size_t count)
+    {
+        static_assert(std::is_trivially_destructible<_Type>::value, "arena slabs are never destructed");
+        return (_Type *)slab(slot, count*sizeof(_Type));
+    }
+
+    //frees all slabs, pointers from get are invalid afterwards
+    void release();
+
+    size_t reservedBytes() const;
+    //slab allocations made since construction, flat across regenerations that fit the existing slabs
+    size_t allocations() const { return m_allocations; }
+
+private:
+    void *slab(size_t slot, size_t bytes);
+
+    struct Slab
+    {
+        void *data=nullptr;
+        size_t capacity=0;
+    };
+
+    std::vector<Slab> m_slabs;
+    std::atomic<size_t> m_allocations;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_generationArena_h_
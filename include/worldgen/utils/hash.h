@@ -0,0 +1,51 @@
+#ifndef _worldgen_hash_h_
+#define _worldgen_hash_h_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace worldgen
+{
+
+//FNV-1a over the raw bytes of the values added, stable between runs so it can key caches
+class Hash64
+{
+public:
+    Hash64():m_value(14695981039346656037ull) {}
+
+    Hash64 &add(const void *data, size_t size)
+    {
+        const unsigned char *bytes=(const unsigned char *)data;
+
+        for(size_t i=0; i<size; ++i)
+        {
+            m_value^=bytes[i];
+            m_value*=1099511628211ull;
+        }
+        return *this;
+    }
+
+    template<typename _Type>
+    Hash64 &add(const _Type &value)
+    {
+        static_assert(std::is_trivially_copyable<_Type>::value, "only plain values can be hashed by bytes");
+        return add(&value, sizeof(_Type));
+    }
+
+    Hash64 &add(const std::string &value)
+    {
+        add(value.size());
+        return add(value.data(), value.size());
+    }
+
+    uint64_t value() const { return m_value; }
+
+private:
+    uint64_t m_value;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_hash_h_
@@ -0,0 +1,81 @@
+#ifndef _worldgen_layerAllocator_h_
+#define _worldgen_layerAllocator_h_
+
+#include "worldgen/export.h"
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace worldgen
+{
+
+enum class HugePages
+{
+    Off,
+    Transparent,//madvise, the kernel backs the layer with huge pages when it can
+    Explicit//MAP_HUGETLB from the reserved pool, falls back to Transparent if the pool is empty
+};
+
+//Process wide, read when a layer is allocated so it can change between generations. Only allocations of
+//at least LargeLayerBytes are affected, smaller ones come from the heap.
+struct LayerMemoryPolicy
+{
+    HugePages hugePages=HugePages::Off;
+    //write every page of a new layer from the global pool, so the page faults (and the kernel zeroing the
+    //pages) are taken in parallel instead of by whichever pass first writes the layer. Pool workers are not
+    //pinned and passes do not split layers the same way, no NUMA placement is implied.
+    bool parallelFirstTouch=false;
+};
+
+constexpr size_t LargeLayerBytes=2*1024*1024;
+
+WORLDGEN_EXPORT void setLayerMemoryPolicy(const LayerMemoryPolicy &policy);
+WORLDGEN_EXPORT LayerMemoryPolicy getLayerMemoryPolicy();
+
+//64 byte aligned, contents undefined. bytes has to be passed back unchanged to free.
+WORLDGEN_EXPORT void *allocateLayerMemory(size_t bytes);
+WORLDGEN_EXPORT void freeLayerMemory(void *data, size_t bytes);
+//allocateLayerMemory calls since startup, these do not go through operator new
+WORLDGEN_EXPORT size_t getLayerAllocationCount();
+
+//Allocates through allocateLayerMemory and default initializes, so resizing a layer does not write (and
+//first touch) every page from the resizing thread.
+template<typename _Type>
+class LayerAllocator
+{
+public:
+    typedef _Type value_type;
+
+    LayerAllocator()=default;
+    template<typename _Other>
+    LayerAllocator(const LayerAllocator<_Other> &) {}
+
+    _Type *allocate(size_t count)
+    {
+        void *data=allocateLayerMemory(count*sizeof(_Type));
+
+        if(!data)
+            throw std::bad_alloc();
+        return (_Type *)data;
+    }
+
+    void deallocate(_Type *data, size_t count) { freeLayerMemory(data, count*sizeof(_Type)); }
+
+    template<typename _Other>
+    void construct(_Other *data) { ::new((void *)data) _Other; }
+    template<typename _Other, typename... _Args>
+    void construct(_Other *data, _Args &&...args) { ::new((void *)data) _Other(std::forward<_Args>(args)...); }
+
+    template<typename _Other>
+    bool operator==(const LayerAllocator<_Other> &) const { return true; }
+    template<typename _Other>
+    bool operator!=(const LayerAllocator<_Other> &) const { return false; }
+};
+
+typedef std::vector<float, LayerAllocator<float>> LayerBuffer;
+
+}//namespace worldgen
+
+#endif //_worldgen_layerAllocator_h_
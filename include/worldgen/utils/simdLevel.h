@@ -0,0 +1,41 @@
+#ifndef _worldgen_simdLevel_h_
+#define _worldgen_simdLevel_h_
+
+#include "worldgen/export.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace worldgen
+{
+
+//Instruction set the FastNoise passes are built for. Auto leaves the choice to FastSIMD, which picks the
+//highest level the cpu has. A pinned level the cpu lacks runs at the highest level below it.
+enum class SimdLevel
+{
+    Auto,
+    Scalar,
+    SSE2,
+    SSE41,
+    AVX2,
+    AVX512,
+    NEON
+};
+
+//lowercase names as used in descriptors and on the command line: auto, scalar, sse2, sse41, avx2, avx512, neon
+WORLDGEN_EXPORT const char *simdLevelName(SimdLevel level);
+WORLDGEN_EXPORT bool parseSimdLevel(const std::string &name, SimdLevel &level);
+
+//every level this cpu can run, lowest first, Auto not included
+WORLDGEN_EXPORT std::vector<SimdLevel> supportedSimdLevels();
+//level the noise actually runs at when level is requested
+WORLDGEN_EXPORT SimdLevel resolveSimdLevel(SimdLevel level);
+
+//FastSIMD::eLevel flag to hand FastNoise::New, 0 (Level_Null) for Auto
+WORLDGEN_EXPORT uint32_t toFastSimdLevel(SimdLevel level);
+WORLDGEN_EXPORT SimdLevel fromFastSimdLevel(uint32_t level);
+
+}//namespace worldgen
+
+#endif //_worldgen_simdLevel_h_
@@ -0,0 +1,65 @@
+#ifndef _worldgen_stageGraph_h_
+#define _worldgen_stageGraph_h_
+
+#include "worldgen/export.h"
+#include "worldgen/utils/threadPool.h"
+
+#include <functional>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace worldgen
+{
+
+typedef uint32_t LayerId;
+
+struct StageTiming
+{
+    std::string name;
+    //relative to the start of StageGraph::run
+    double startMs;
+    double ms;
+};
+
+//Stages declare the layers they read and write, a stage runs once every stage writing one of its
+//inputs has finished. Independent stages run concurrently on the pool, the calling thread takes
+//stages as well so run can be called from inside a pool task.
+class WORLDGEN_EXPORT StageGraph
+{
+public:
+    //returning false stops the graph, stages already running are finished first
+    typedef std::function<bool()> StageTask;
+
+    //every layer has a single writer, inputs must be written by a stage added before this one. Inputs no
+    //added stage writes are taken as already available (cached from an earlier run).
+    void add(const char *name, std::vector<LayerId> inputs, std::vector<LayerId> outputs, StageTask task);
+
+    //runs all stages, only on the calling thread if pool is null. Returns false if any stage did.
+    bool run(ThreadPool *pool);
+
+    //one entry per stage that ran, in add order
+    const std::vector<StageTiming> &timings() const { return m_timings; }
+
+private:
+    struct RunState;
+
+    struct Stage
+    {
+        std::string name;
+        const char *traceName;
+        std::vector<LayerId> inputs;
+        std::vector<LayerId> outputs;
+        StageTask task;
+
+        std::vector<size_t> dependents;
+        size_t dependencyCount;
+    };
+
+    std::vector<Stage> m_stages;
+    std::vector<StageTiming> m_timings;
+};
+
+}//namespace worldgen
+
+#endif //_worldgen_stageGraph_h_
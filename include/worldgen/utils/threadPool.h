@@ -0,0 +1,61 @@
+#ifndef _worldgen_threadPool_h_
+#define _worldgen_threadPool_h_
+
+#include "worldgen/export.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+namespace worldgen
+{
+
+//Fixed set of worker threads pulling from a single task queue. parallelFor has the calling thread
+//take chunks as well, so it can be nested inside a task without starving the pool.
+class WORLDGEN_EXPORT ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+    typedef std::function<void(size_t begin, size_t end)> RangeTask;
+
+    //0 threads uses hardware_concurrency
+    ThreadPool(size_t threads=0);
+    ~ThreadPool();
+
+    size_t size() const { return m_threads.size(); }
+
+    void submit(Task task);
+
+    //splits [begin, end) into chunks of grain and blocks until all of them ran
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeTask &task);
+
+    //shared pool created on first use, sized to the machine unless setGlobalThreads was called before
+    static ThreadPool &global();
+    static void setGlobalThreads(size_t threads);
+
+private:
+    void worker();
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_event;
+    std::deque<Task> m_tasks;
+    bool m_shutdown;
+};
+
+//runs on the pool if given, otherwise inline on the calling thread
+inline void parallelFor(ThreadPool *pool, size_t begin, size_t end, size_t grain, const ThreadPool::RangeTask &task)
+{
+    if(pool)
+        pool->parallelFor(begin, end, grain, task);
+    else if(begin<end)
+        task(begin, end);
+}
+
+}//namespace worldgen
+
+#endif //_worldgen_threadPool_h_
@@ -0,0 +1,101 @@
+#ifndef _worldgen_trace_h_
+#define _worldgen_trace_h_
+
+#include "worldgen/export.h"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace worldgen
+{
+
+//Scoped zones and counters recorded into per thread ring buffers, exported as Chrome trace json
+//(chrome://tracing or ui.perfetto.dev). Off until setTraceEnabled(true), a zone then costs one relaxed
+//load. Building with WORLDGEN_DISABLE_TRACE compiles zones and counter events out entirely.
+
+//events kept per thread, once full the oldest are overwritten
+constexpr size_t TraceBufferEvents=1<<16;
+
+WORLDGEN_EXPORT extern std::atomic<bool> g_traceEnabled;
+
+WORLDGEN_EXPORT void setTraceEnabled(bool enabled);
+
+inline bool traceEnabled()
+{
+#ifdef WORLDGEN_DISABLE_TRACE
+    return false;
+#else
+    return g_traceEnabled.load(std::memory_order_relaxed);
+#endif
+}
+
+//event names are kept by pointer until export, names built at runtime have to go through here
+WORLDGEN_EXPORT const char *traceName(const std::string &name);
+//names the calling thread in the export
+WORLDGEN_EXPORT void setTraceThreadName(const char *name);
+
+//nanoseconds since the first trace call of the process
+WORLDGEN_EXPORT uint64_t traceNow();
+WORLDGEN_EXPORT void traceComplete(const char *name, uint64_t startNs, uint64_t endNs);
+
+class TraceZone
+{
+public:
+    TraceZone(const char *name):m_name(traceEnabled()?name:nullptr), m_start(m_name?traceNow():0) {}
+    ~TraceZone() { if(m_name) traceComplete(m_name, m_start, traceNow()); }
+
+    TraceZone(const TraceZone &)=delete;
+    TraceZone &operator=(const TraceZone &)=delete;
+
+private:
+    const char *m_name;
+    uint64_t m_start;
+};
+
+//process wide running total, kept whether tracing or not. While tracing every change is also recorded
+//as a counter event so the export graphs it over time.
+class WORLDGEN_EXPORT TraceCounter
+{
+public:
+    TraceCounter(const char *name):m_name(name), m_value(0) {}
+
+    void add(int64_t delta)
+    {
+        int64_t value=m_value.fetch_add(delta, std::memory_order_relaxed)+delta;
+
+        if(traceEnabled())
+            record(value);
+    }
+
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    void record(int64_t value);
+
+    const char *m_name;
+    std::atomic<int64_t> m_value;
+};
+
+//influence cells finished by generation
+WORLDGEN_EXPORT TraceCounter &traceCellsProcessed();
+//bytes currently held through allocateLayerMemory
+WORLDGEN_EXPORT TraceCounter &traceLayerBytes();
+
+WORLDGEN_EXPORT void clearTrace();
+//Events of every thread that recorded since the last clear. Only consistent while no zone is open, export
+//between generations.
+WORLDGEN_EXPORT std::string exportChromeTrace();
+WORLDGEN_EXPORT bool writeChromeTrace(const std::string &fileName);
+
+}//namespace worldgen
+
+#ifdef WORLDGEN_DISABLE_TRACE
+#define WORLDGEN_TRACE_ZONE(name)
+#else
+#define WORLDGEN_TRACE_CONCAT_(a, b) a##b
+#define WORLDGEN_TRACE_CONCAT(a, b) WORLDGEN_TRACE_CONCAT_(a, b)
+#define WORLDGEN_TRACE_ZONE(name) worldgen::TraceZone WORLDGEN_TRACE_CONCAT(traceZone_, __LINE__)(name)
+#endif
+
+#endif //_worldgen_trace_h_
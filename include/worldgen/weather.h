@@ -9,6 +9,7 @@
 #include <math.h>
 #include <string>
 #include <algorithm>
+#include <cassert>
 
 namespace worldgen
 {
@@ -120,6 +120,8 @@ int main(int argc, char ** argv)
         glfwSwapBuffers(window);
     }
 
+    mapgen.terminate();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
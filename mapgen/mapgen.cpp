@@ -2,6 +2,7 @@
 
 #include "worldgen/utils/randomcolor.h"
 #include "worldgen/utils/colorMap.h"
+#include "worldgen/utils/threadPool.h"
 
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
@@ -11,6 +12,7 @@
 #include <imglib/draw.h>
 
 #include <tuple>
+#include <cmath>
 
 std::vector<char> packVectorString(const std::vector<std::string> &values)
 {
@@ -36,35 +38,27 @@ std::vector<char> packVectorString(const std::vector<std::string> &values)
 }
 
 MapGen::MapGen():
-    m_textureValid(false),
-    m_show(true)
+    m_show(true),
+    m_generatePending(false),
+    m_generateShutdown(false),
+    m_overviewVersion(0),
+    m_viewZoom(0.0f),
+    m_hoverCell(0, 0)
 {
     m_worldWidth=4194304;
     m_worldHeight=2097152;
     m_worldDepth=2560;
 
-    worldgen::ColorScale tempColorScale;
-
-    tempColorScale.addColorPosition(glm::ivec4(255, 255, 255, 255), 0.0f);
-    tempColorScale.addColorPosition(glm::ivec4(255, 0, 255, 255), 0.2f);
-    tempColorScale.addColorPosition(glm::ivec4(0, 0, 255, 255), 0.4f);
-    tempColorScale.addColorPosition(glm::ivec4(0, 255, 0, 255), 0.6f);
-    tempColorScale.addColorPosition(glm::ivec4(255, 0, 0, 255), 0.8f);
-    tempColorScale.addColorPosition(glm::ivec4(0, 0, 0, 255), 1.0f);
-
-    m_tempColorMap=generateColorMap(tempColorScale, 64);
-
-    worldgen::ColorScale moistureColorScale;
-
-    moistureColorScale.addColorPosition(glm::ivec4(255, 0, 0, 255), 0.0f);
-    moistureColorScale.addColorPosition(glm::ivec4(0, 255, 0, 255), 0.5f);
-    moistureColorScale.addColorPosition(glm::ivec4(0, 0, 255, 255), 1.0f);
-
-    m_moistureColorMap=worldgen::generateColorMap(moistureColorScale, 64);
-
-    m_biomeColorMap=worldgen::generateHieghtMoistureColorMap(64, 64);
+    //plate colors are replaced once the plate count of a generation is known
+    m_palette=worldgen::render::defaultPalette(1);
 
     m_plateCount=16;
+    m_seededPlates=false;
+}
+
+MapGen::~MapGen()
+{
+    terminate();
 }
 
 void MapGen::initialize()
@@ -72,15 +66,19 @@ void MapGen::initialize()
 //    WorldGeneratorTemplate *genTemplate=(WorldGeneratorTemplate *)&m_world.getGenerator();
 //    m_worldGenerator=(WorldGenerator *)genTemplate->get();
     worldgen::WorldDescriptors descriptors;
-    worldgen::Progress progress;
 
     m_worldGenerator.reset(new WorldGenerator());
+    //the debug layers are displayed and keeping everything lets edits only rerun the changed stages
+    m_worldGenerator->setLayerRetention(worldgen::LayerRetention::All);
 
     descriptors.setSize({4194304, 2097152, 2560});
     descriptors.setRegionSize({16, 16, 16});
     descriptors.setChunkSize({64, 64, 16});
 
-    m_worldGenerator->create(&descriptors, progress);
+    //only sets up the descriptors, the overview is built on the generate thread
+    m_worldGenerator->loadDescriptors(&descriptors);
+    m_descriptors=m_worldGenerator->getDecriptors();
+    m_noiseSeed=m_descriptors.seed;
 
     m_layerIndex=0;
     m_info=0;
@@ -88,7 +86,24 @@ void MapGen::initialize()
     m_overlayVector=0;
     m_layerNames=packVectorString({"Terrain", "Plate Info", "Tectonic Plates", "Plates Distance", "Terrain Scale"});
 
-	updateTexture();
+    m_generateThread=std::thread(&MapGen::generateThread, this);
+    generate();
+}
+
+void MapGen::terminate()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_generateMutex);
+
+        m_generateShutdown=true;
+        m_progress.cancel();
+    }
+    m_generateEvent.notify_one();
+
+    if(m_generateThread.joinable())
+        m_generateThread.join();
+
+    m_tiles.clear();
 }
 
 void MapGen::setSize(int width, int height)
@@ -101,7 +116,17 @@ void MapGen::draw()
 {
     bool forceUpdate=false;
 
-    worldgen::EquiRectDescriptors &descriptors=m_worldGenerator->getDecriptors();
+    worldgen::EquiRectDescriptors &descriptors=m_descriptors;
+
+    //pick up a finished generation, the previous overview is kept until then
+    std::shared_ptr<const Overview> overview=std::atomic_load(&m_overview);
+
+    if(overview!=m_drawOverview)
+    {
+        m_drawOverview=overview;
+        m_overviewVersion++;
+        forceUpdate=true;
+    }
 
     int controlsWidth=350;
 
@@ -111,22 +136,27 @@ void MapGen::draw()
     ImGui::Begin("Controls", &m_show, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoBringToFrontOnFocus|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoResize);
     
     if(ImGui::Button("Generate"))
-    {
         generate();
-        forceUpdate=true;
-    }
 
     ImGui::Separator();
 
     ImGui::InputInt("Seed", &m_noiseSeed);
-    if(ImGui::SliderInt("Plate Count", &m_plateCount, 1000, 10000))
-    {
+    //the count only applies to seeded plates, noise plates follow the plate frequency
+    if(ImGui::Checkbox("Seeded Plates", &m_seededPlates))
+        generate();
+    if(ImGui::SliderInt("Plate Count", &m_plateCount, 2, 256) && m_seededPlates)
         generate();
-        forceUpdate=true;
-    }
     ImGui::SliderFloat("Plate Frequency", &descriptors.m_plateFrequency, 0.0001f, 1.0f, "%.4f", 3.0f);
     ImGui::SliderFloat("Continent Frequency", &descriptors.m_continentFrequency, 0.001f, 1.0f, "%.3f", 3.0f);
 
+    worldgen::Stage stage;
+    int progress;
+    bool complete;
+
+    m_progress.get(stage, progress, complete);
+    if(!complete)
+        ImGui::ProgressBar((float)progress/100.0f, ImVec2(-1.0f, 0.0f), worldgen::stageName(stage));
+
     ImGui::Separator();
 
     if(ImGui::Combo("Layer", &m_layerIndex, &m_layerNames[0]))
@@ -185,472 +215,265 @@ void MapGen::draw()
 //    if(ImGui::Checkbox("overlay", &m_overlay))
 //        forceUpdate=true;
 
-    ImVec2 mousePosition=ImGui::GetMousePos();
-
-    mousePosition.x=mousePosition.x-controlsWidth-lastDrawPos.x-1.0f;//-1.of border
-    mousePosition.y=mousePosition.y-lastDrawPos.y-1.0f;//-1.of border
-
-    if(mousePosition.x<0.0f)
-        mousePosition.x=0.0f;
-    if(mousePosition.y<0.0f)
-        mousePosition.y=0.0f;
-
-    if(mousePosition.x>lastDrawSize.x-1)
-        mousePosition.x=lastDrawSize.x-1;
-    if(mousePosition.y>lastDrawSize.y-1)
-        mousePosition.y=lastDrawSize.y-1;
+    int texturePosX=m_hoverCell.x;
+    int texturePosY=m_hoverCell.y;
 
-    int texturePosX=mousePosition.x/lastDrawSize.x*m_textureWidth;
-    int texturePosY=mousePosition.y/lastDrawSize.y*m_textureHeight;
-
-    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
-    const glm::ivec2 &influenceMapSize=m_worldGenerator->getInfluenceMapSize();
-    size_t index=texturePosY*influenceMapSize.x+texturePosX;
-    float value;
-    float overlayValue;
+    if(m_drawOverview)
+    {
+        const typename WorldGenerator::InfluenceMap &influenceMap=m_drawOverview->influenceMap;
+        const glm::ivec2 &influenceMapSize=m_drawOverview->influenceMapSize;
+        size_t index=texturePosY*influenceMapSize.x+texturePosX;
+        float value;
+        float overlayValue;
 
-    if((index<0)||(index>=influenceMapSize.x*influenceMapSize.y))
-        index=0;
+        if((index<0)||(index>=influenceMapSize.x*influenceMapSize.y))
+            index=0;
 
-    if((m_info==0) || (m_info==1))
-        value=influenceMap[index].heightBase;
-    else if(m_info==2)
-        value=influenceMap[index].plateHeight;
-    else if(m_info==3)
-        value=(float)influenceMap[index].tectonicPlate;
-    else if(m_info==5)
-        value=m_worldGenerator->plateMap_noise[index];
-    else if(m_info==6)
-        value=m_worldGenerator->plate2Map_noise[index];
-    else if(m_info==7)
-        value=m_worldGenerator->plateDistance_noise[index];
-    else if(m_info==8)
-        value=m_worldGenerator->continentMap_noise[index];
-    else if(m_info==9)
-        value=m_worldGenerator->heightMap_noise[index];
-    else if(m_info==10)
-        value=influenceMap[index].plateDistanceValue;
-    else if(m_info==11)
-        value=m_worldGenerator->plateScaleMap[index];
-    else
-        value=0.0f;
+        if((m_info==0) || (m_info==1))
+            value=influenceMap[index].heightBase;
+        else if(m_info==2)
+            value=influenceMap[index].plateHeight;
+        else if(m_info==3)
+            value=(float)influenceMap[index].tectonicPlate;
+        else if(m_info==5)
+            value=m_drawOverview->plateMap_noise[index];
+        else if(m_info==6)
+            value=m_drawOverview->plate2Map_noise[index];
+        else if(m_info==7)
+            value=m_drawOverview->plateDistance_noise[index];
+        else if(m_info==8)
+            value=m_drawOverview->continentMap_noise[index];
+        else if(m_info==9)
+            value=m_drawOverview->heightMap_noise[index];
+        else if(m_info==10)
+            value=influenceMap[index].plateDistanceValue;
+        else if(m_info==11)
+            value=m_drawOverview->plateScaleMap[index];
+        else
+            value=0.0f;
 
-    ImGui::Text("Position: %d, %d : %f", texturePosX, texturePosY, value);
+        ImGui::Text("Position: %d, %d : %f", texturePosX, texturePosY, value);
 
-    if(m_overlay > 0)
-    {
-        overlayValue=0.0f;
-
-        if(m_overlay==1)
-            overlayValue=influenceMap[index].collision;
-        else if(m_overlay==2)
-            overlayValue=influenceMap[index].collision*influenceMap[index].plateDistanceValue;
-        else if(m_overlay==3)
-            overlayValue=influenceMap[index].terrainScale;
-        else if(m_overlay==4)
-            overlayValue=(influenceMap[index].temperature+90.0f)/160.0f;
-        else if((m_overlay==5) || (m_overlay==6))
-            overlayValue=std::min(influenceMap[index].moisture, 1.0f);
-        else if(m_overlay==7)
-            overlayValue=(float)influenceMap[index].weatherCell;
-        else if(m_overlay==8)
-            overlayValue=(float)influenceMap[index].weatherBand;
-        ImGui::Text("Overlay: %f", overlayValue);
+        if(m_overlay > 0)
+        {
+            overlayValue=0.0f;
+
+            if(m_overlay==1)
+                overlayValue=influenceMap[index].collision;
+            else if(m_overlay==2)
+                overlayValue=influenceMap[index].collision*influenceMap[index].plateDistanceValue;
+            else if(m_overlay==3)
+                overlayValue=influenceMap[index].terrainScale;
+            else if(m_overlay==4)
+                overlayValue=(influenceMap[index].temperature+90.0f)/160.0f;
+            else if((m_overlay==5) || (m_overlay==6))
+                overlayValue=std::min(influenceMap[index].moisture, 1.0f);
+            else if(m_overlay==7)
+                overlayValue=(float)influenceMap[index].weatherCell;
+            else if(m_overlay==8)
+                overlayValue=(float)influenceMap[index].weatherBand;
+            ImGui::Text("Overlay: %f", overlayValue);
+        }
     }
 
+    if(ImGui::Button("Fit View"))
+        m_viewZoom=0.0f;
+
     ImGui::End();
 
     if(forceUpdate)
-        updateTexture();
+        updateLayer();
 
     int imageWindowWidth=std::max(m_width-controlsWidth, 0);
 
     ImGui::SetNextWindowPos({(float)controlsWidth, 0});
     ImGui::SetNextWindowSize({(float)imageWindowWidth, (float)m_height});
 
-    ImGui::Begin("Image", &m_show, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoBringToFrontOnFocus|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoResize);
-
-    lastDrawPos=ImGui::GetCursorPos();
-    int imageWidth=imageWindowWidth-(2*lastDrawPos.y)-2.0f;//margin, -2.0f border
-    int imageHeight=m_height-(2*lastDrawPos.y)-2.0f;//margin, -2.0f border
-
-    float ratioX=(float)imageWidth/m_textureWidth;
-    float ratioY=(float)imageHeight/m_textureHeight;
-
-    ImVec2 textureStart=lastDrawPos;
-    ImVec2 textureSize(imageWidth, imageHeight);
-
-    if(ratioX<ratioY)
-    {
-        textureSize.y=ratioX*m_textureHeight;
-        textureStart.y=lastDrawPos.y+(imageHeight-textureSize.y)/2.0f;
-    }
-    else
-    {
-        textureSize.x=ratioY*m_textureWidth;
-        textureStart.x=lastDrawPos.x+(imageWidth-textureSize.x)/2.0f;
-    }
-    lastDrawPos=textureStart;
-    ImGui::SetCursorPos(textureStart);
+    ImGui::Begin("Image", &m_show, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoBringToFrontOnFocus|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoResize|ImGuiWindowFlags_NoScrollWithMouse);
 
-    lastDrawSize.x=textureSize.x;
-    lastDrawSize.y=textureSize.y;
+    ImVec2 viewPos=ImGui::GetCursorScreenPos();
+    ImVec2 viewSize=ImGui::GetContentRegionAvail();
 
-    if(m_textureValid)
+    if(m_drawOverview && (viewSize.x>0.0f) && (viewSize.y>0.0f))
     {
-        ImGui::Image((ImTextureID)m_textureId, {(float)textureSize.x, (float)textureSize.y}, {0.0f, 0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 0.5f});
+        ImGui::InvisibleButton("view", viewSize);
+        drawView(*m_drawOverview, glm::vec2(viewPos.x, viewPos.y), glm::vec2(viewSize.x, viewSize.y));
     }
 
     ImGui::End();
 }
 
-void MapGen::updateTexture()
+void MapGen::drawView(const Overview &overview, const glm::vec2 &viewPos, const glm::vec2 &viewSize)
 {
-    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
-    const glm::ivec2 &influenceMapSize=m_worldGenerator->getInfluenceMapSize();
-
-    std::vector<GLubyte> textureBuffer;
-
-    textureBuffer.resize(influenceMap.size()*4);
-
-    //    int min=std::numeric_limits<int>::max();
-    //    int max=0;
-    //
-    //    for(size_t i=0; i<influenceMap.size(); ++i)
-    //    {
-    //        int value=influenceMap[i].tectonicPlate;
-    //
-    //        min=std::min(min, value);
-    //        max=std::max(max, value);
-    //    }
-    m_layerNames=packVectorString({"Terrain", "Plate Info", "Tectonic Plates", "Plates Distance"});
-
-    if(m_layerIndex==0)
-        updatePlateInfoTexture(textureBuffer);
-    if(m_layerIndex==1)
-        updatePlateInfoTexture(textureBuffer);
-    else if(m_layerIndex==2)
-        updatePlateTexture(textureBuffer);
-    else if(m_layerIndex==3)
-        updatePlateDistanceTexture(textureBuffer);
-}
-
-void MapGen::updatePlateTexture(std::vector<GLubyte> &textureBuffer)
-{
-    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
-    const glm::ivec2 &influenceMapSize=m_worldGenerator->getInfluenceMapSize();
+    glm::vec2 mapSize(overview.influenceMapSize);
+    float fitZoom=std::min(viewSize.x/mapSize.x, viewSize.y/mapSize.y);
 
-    int plateCount=m_worldGenerator->getPlateCount();
+    if(m_viewZoom<=0.0f)
+    {
+        m_viewZoom=fitZoom;
+        m_viewCenter=mapSize*0.5f;
+    }
 
-    worldgen::RandomColorGenerator colorGenerator;
+    ImGuiIO &io=ImGui::GetIO();
+    glm::vec2 mouse(io.MousePos.x, io.MousePos.y);
 
-    if(m_plateColors.size() <plateCount)
-        m_plateColors=colorGenerator.randomColors(plateCount);
+    if(ImGui::IsItemHovered() && (io.MouseWheel!=0.0f))
+    {
+        //zoom around the cursor, keeping the cell under it in place
+        glm::vec2 origin=viewPos+viewSize*0.5f-m_viewCenter*m_viewZoom;
+        glm::vec2 mouseCell=(mouse-origin)/m_viewZoom;
+        float zoom=m_viewZoom*std::pow(1.25f, io.MouseWheel);
+
+        zoom=std::max(fitZoom*0.5f, std::min(zoom, 32.0f));
+        m_viewCenter=mouseCell-(mouse-viewPos-viewSize*0.5f)/zoom;
+        m_viewZoom=zoom;
+    }
 
-    size_t index=0;
-    for(size_t i=0; i<influenceMap.size(); ++i)
+    if(ImGui::IsItemActive() && ImGui::IsMouseDragging(0))
     {
-        auto &color=m_plateColors[influenceMap[i].tectonicPlate];
+        ImVec2 delta=ImGui::GetMouseDragDelta(0);
 
-        textureBuffer[index++]=(GLubyte)std::get<0>(color);
-        textureBuffer[index++]=(GLubyte)std::get<1>(color);
-        textureBuffer[index++]=(GLubyte)std::get<2>(color);
-        textureBuffer[index++]=255;
+        m_viewCenter-=glm::vec2(delta.x, delta.y)/m_viewZoom;
+        ImGui::ResetMouseDragDelta(0);
     }
 
-    m_textureWidth=influenceMapSize.x;
-    m_textureHeight=influenceMapSize.y;
-
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
+    m_viewCenter=glm::clamp(m_viewCenter, glm::vec2(0.0f), mapSize);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_textureWidth, m_textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, &textureBuffer[0]);
+    glm::vec2 origin=viewPos+viewSize*0.5f-m_viewCenter*m_viewZoom;
+    glm::ivec2 minCell=glm::max(glm::ivec2(glm::floor((viewPos-origin)/m_viewZoom)), glm::ivec2(0));
+    glm::ivec2 maxCell=glm::min(glm::ivec2(glm::ceil((viewPos+viewSize-origin)/m_viewZoom)), overview.influenceMapSize);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    if(ImGui::IsItemHovered())
+        m_hoverCell=glm::clamp(glm::ivec2((mouse-origin)/m_viewZoom), glm::ivec2(0), overview.influenceMapSize-1);
 
-    m_textureValid=true;
-}
+    m_tiles.request(minCell, maxCell, m_tiles.lodFor(1.0f/m_viewZoom), m_visibleTiles);
 
-void MapGen::updatePlateInfoTexture(std::vector<GLubyte> &textureBuffer)
-{
-    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
-    const glm::ivec2 &influenceMapSize=m_worldGenerator->getInfluenceMapSize();
-    int plateCount=m_worldGenerator->getPlateCount();
-    worldgen::RandomColorGenerator colorGenerator;
+    ImDrawList *drawList=ImGui::GetWindowDrawList();
 
-    if(m_plateColors.size()<plateCount)
-        m_plateColors=colorGenerator.randomColors(plateCount);
+    drawList->PushClipRect(ImVec2(viewPos.x, viewPos.y), ImVec2(viewPos.x+viewSize.x, viewPos.y+viewSize.y), true);
 
-    size_t index=0;
-    for(size_t i=0; i<influenceMap.size(); ++i)
+    for(const TilePyramid::VisibleTile &tile:m_visibleTiles)
     {
-        glm::ivec4 color;
-        
-        if(m_info==0)
-        {
-            color=m_biomeColorMap.color((size_t)64*influenceMap[i].heightBase, (size_t)64*influenceMap[i].moisture);
-
-            float value=(influenceMap[i].temperature+90.0f)/160.0f;
-
-            if((value<0.4f) && (influenceMap[i].heightBase>0.5f)) //polar caps
-            {
-                if(value<0.2f)
-                {
-                    color.r=255;
-                    color.g=255;
-                    color.b=255;
-                }
-                else
-                {
-                    value=5.0f*(0.4f-value);
-                    color.r=(255*value)+(color.r*(1.0f-value));
-                    color.g=(255*value)+(color.g*(1.0f-value));
-                    color.b=(255*value)+(color.b*(1.0f-value));
-                }
-            }
-        }
-        else if(m_info==1)
-        {
-            unsigned char value=255*influenceMap[i].heightBase;
-
-            color.r=value;
-            color.g=value;
-            color.b=value;
-            color.a=255;
-        }
-        else if(m_info==2)
-            color=m_biomeColorMap.color((size_t)64*influenceMap[i].plateHeight, 32);
-        else if(m_info==3)
-        {
-            auto &plateColor=m_plateColors[influenceMap[i].tectonicPlate];
-
-            color.r=std::get<0>(plateColor);
-            color.g=std::get<1>(plateColor);
-            color.b=std::get<2>(plateColor);
-            color.a=255;
-        }
-        else if((m_info >= 5) && (m_info <= 10))
-        {
-            float fValue;
-
-            if(m_info==5)
-                fValue=m_worldGenerator->plateMap_noise[i];
-            else if(m_info==6)
-                fValue=m_worldGenerator->plate2Map_noise[i];
-            else if(m_info==7)
-                fValue=m_worldGenerator->plateDistance_noise[i];
-            else if(m_info==8)
-                fValue=m_worldGenerator->continentMap_noise[i];
-            else if(m_info==9)
-                fValue=m_worldGenerator->heightMap_noise[i];
-            else if(m_info == 10)
-                fValue=influenceMap[i].plateDistanceValue;
-
-            unsigned char value=255*fValue;
-
-            color.r=value;
-            color.g=value;
-            color.b=value;
-            color.a=255;
-        }
-        else if(m_info == 11)
-        {
-            color.r=255*m_worldGenerator->plateScaleMap[i];
-            color.g=255*m_worldGenerator->plate2ScaleMap[i];
-            color.b=0;
-            color.a=255;
-        }
-        else
-        {
-            color.r=0;
-            color.g=0;
-            color.b=0;
-            color.a=255;
-        }
+        glm::vec2 start=origin+glm::vec2(tile.cell)*m_viewZoom;
+        glm::vec2 end=origin+glm::vec2(tile.cell+tile.cells)*m_viewZoom;
 
-        if(m_overlay==1)
-        {
-            if(influenceMap[i].collision<0.0f)
-                color.r=color.r+(255.0f*-influenceMap[i].collision);
-            else
-                color.g=color.g+(255.0f*influenceMap[i].collision);
-        }
-        else if(m_overlay==2)
-        {
-            if(influenceMap[i].collision<0.0f)
-                color.r=color.r+(255.0f*-influenceMap[i].collision*influenceMap[i].plateDistanceValue);
-            else
-                color.g=color.g+(255.0f*influenceMap[i].collision*influenceMap[i].plateDistanceValue);
-        }
-        else if(m_overlay==3)
-        {
-            if(influenceMap[i].terrainScale<0.0f)
-                color.r=color.r+(255.0f*-influenceMap[i].terrainScale);
-            else
-                color.g=color.g+(255.0f*influenceMap[i].terrainScale);
-        }
-        else if(m_overlay==4)
-        {
-            //color scale intended for -50 to 60, temp runs -90 to 60
-            float value=(influenceMap[i].temperature+50.0f)/110.0f;
+        drawList->AddImage((ImTextureID)(intptr_t)tile.texture, ImVec2(start.x, start.y), ImVec2(end.x, end.y), ImVec2(0.0f, 0.0f), ImVec2(tile.uv.x, tile.uv.y));
+    }
 
-            value=std::max(value, 0.0f);
-            value=std::min(value, 1.0f);
+    if((m_layerIndex<2) && (m_overlayVector>0))
+        drawVectorOverlay(overview, drawList, origin, minCell, maxCell);
 
-            color=color+(m_tempColorMap.color((size_t)63*value));
-        }
-        else if(m_overlay==5)
-        {
-            float moisture=std::min(influenceMap[i].moisture, 1.0f);
-            color=color+(m_moistureColorMap.color((size_t)63*moisture));
-        }
-        else if(m_overlay==6)
-        {
-            unsigned char value=255*influenceMap[i].moisture;
+    drawList->PopClipRect();
+}
 
-            if(influenceMap[i].heightBase > 0.5f)
-                color=color+glm::ivec4(value, value, value, 255);
-        }
-        else if(m_overlay==7)
-        {
-            auto &plateColor=m_plateColors[influenceMap[i].weatherCell];
+void MapGen::updateLayer()
+{
+    if(!m_drawOverview)
+        return;
 
-            color.r=std::get<0>(plateColor);
-            color.g=std::get<1>(plateColor);
-            color.b=std::get<2>(plateColor);
-            color.a=255;
-        }
-        else if(m_overlay==8)
-        {
-            auto &plateColor=m_plateColors[influenceMap[i].weatherBand];
+    const Overview &overview=*m_drawOverview;
+    worldgen::render::LayerSettings settings;
 
-            color.r=std::get<0>(plateColor);
-            color.g=std::get<1>(plateColor);
-            color.b=std::get<2>(plateColor);
-            color.a=255;
-        }
+    m_layerNames=packVectorString({"Terrain", "Plate Info", "Tectonic Plates", "Plates Distance"});
 
-        
-        color.r=std::min(color.r, 255);
-        color.g=std::min(color.g, 255);
-        color.b=std::min(color.b, 255);
+    if(m_plateColors.size()<overview.plateCount)
+    {
+        worldgen::RandomColorGenerator colorGenerator;
 
-        textureBuffer[index++]=(GLubyte)color.r;
-        textureBuffer[index++]=(GLubyte)color.g;
-        textureBuffer[index++]=(GLubyte)color.b;
-        textureBuffer[index++]=255;
+        m_plateColors=colorGenerator.randomColors(overview.plateCount);
+        m_palette.plates=worldgen::render::makeLut(m_plateColors);
     }
 
-    if(m_overlayVector>0)
+    if(m_layerIndex==2)
+        settings.layer=worldgen::render::Layer::Plates;
+    else if(m_layerIndex==3)
     {
-        imglib::SimpleImage textureImage(imglib::Format::RGBA, imglib::Depth::Bit8, influenceMapSize.x, influenceMapSize.y, &textureBuffer[0], influenceMap.size());
-        glm::tvec4<unsigned char> colorRed(255, 0, 0, 255);
-        glm::tvec4<unsigned char> colorWhite(255, 255, 255, 255);
-
-//        colorRed.r=255;
-//        colorRed.g=0;
-//        colorRed.b=0;
-//        colorRed.a=255;
-
-        glm::vec2 point;
-        index=0;
-
-        size_t skip=10;
-        float fskip=(float)skip;
-
-        point.y=0.0f;
-        for(size_t y=0; y<influenceMapSize.y; y+=skip)
-        {
-            index=y*influenceMapSize.x;
-            point.x=0.0f;
-            for(size_t x=0; x<influenceMapSize.x; x+=skip)
-            {
-                glm::vec2 endPoint;
-                glm::vec2 direction;
-
-                if(m_overlayVector==1)
-                    direction=influenceMap[index].direction;
-                else
-                    direction=influenceMap[index].airDirection;
-                
-                direction.y=-direction.y;//for images y origin is top left
-                endPoint=(direction*8.0f)+point;
-
-                endPoint.x=std::max(endPoint.x, 0.0f);
-                endPoint.x=std::min(endPoint.x, (float)influenceMapSize.x);
-                endPoint.y=std::max(endPoint.y, 0.0f);
-                endPoint.y=std::min(endPoint.y, (float)influenceMapSize.y);
-
-                imglib::drawLine(point, endPoint, colorRed, textureImage);
-
-//                auto &plateColor=m_plateColors[influenceMap[index].tectonicPlate];
-//
-//                colorWhite.r=std::get<0>(plateColor);
-//                colorWhite.g=std::get<1>(plateColor);
-//                colorWhite.b=std::get<2>(plateColor);
-//                colorWhite.a=255;
-
-                imglib::drawPoint(point, colorWhite, textureImage);
-                index+=skip;
-                point.x+=fskip;
-            }
-            point.y+=fskip;
-        }
+        settings.layer=worldgen::render::Layer::Grey;
+        settings.grey=overview.fields.plateDistanceValue.data();
+        worldgen::render::fieldRange(settings.grey, overview.fields.plateDistanceValue.size(), settings.greyMin, settings.greyMax);
     }
+    else
+        plateInfoSettings(overview, settings);
 
-    m_textureWidth=influenceMapSize.x;
-    m_textureHeight=influenceMapSize.y;
-
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_textureWidth, m_textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, &textureBuffer[0]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    m_textureValid=true;
+    m_tiles.setSource(&overview.fields, &m_palette, m_overviewVersion);
+    m_tiles.setLayer((uint32_t)((m_layerIndex<<16)|(m_info<<8)|m_overlay), settings);
 }
 
-void MapGen::updatePlateDistanceTexture(std::vector<GLubyte> &textureBuffer)
+void MapGen::plateInfoSettings(const Overview &overview, worldgen::render::LayerSettings &settings)
 {
-    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
-    const glm::ivec2 &influenceMapSize=m_worldGenerator->getInfluenceMapSize();
-    
-    float min=std::numeric_limits<float>::max();
-    float max=0.0f;
+    using worldgen::render::Layer;
 
-    for(size_t i=0; i<influenceMap.size(); ++i)
+    if(m_info==0)
+        settings.layer=Layer::Biome;
+    else if(m_info==1)
+        settings.layer=Layer::Height;
+    else if(m_info==2)
+        settings.layer=Layer::PlateHeight;
+    else if(m_info==3)
+        settings.layer=Layer::Plates;
+    else if((m_info>=5) && (m_info<=10))
     {
-        float value=influenceMap[i].plateDistanceValue;
-
-        min=std::min(min, value);
-        max=std::max(max, value);
+        settings.layer=Layer::Grey;
+
+        if(m_info==5)
+            settings.grey=overview.plateMap_noise.data();
+        else if(m_info==6)
+            settings.grey=overview.plate2Map_noise.data();
+        else if(m_info==7)
+            settings.grey=overview.plateDistance_noise.data();
+        else if(m_info==8)
+            settings.grey=overview.continentMap_noise.data();
+        else if(m_info==9)
+            settings.grey=overview.heightMap_noise.data();
+        else
+            settings.grey=overview.fields.plateDistanceValue.data();
     }
+    else if(m_info==11)
+    {
+        settings.layer=Layer::RedGreen;
+        settings.red=overview.plateScaleMap.data();
+        settings.green=overview.plate2ScaleMap.data();
+    }
+    else
+        settings.layer=Layer::Black;
+
+    if((m_overlay>0) && (m_overlay<=(int)worldgen::render::Overlay::WeatherBand))
+        settings.overlay=(worldgen::render::Overlay)m_overlay;
+}
 
-    float delta=255/(max-min);
-    size_t index=0;
+void MapGen::drawVectorOverlay(const Overview &overview, ImDrawList *drawList, const glm::vec2 &origin, const glm::ivec2 &minCell, const glm::ivec2 &maxCell)
+{
+    const typename WorldGenerator::InfluenceMap &influenceMap=overview.influenceMap;
+    const glm::ivec2 &influenceMapSize=overview.influenceMapSize;
 
-    for(size_t i=0; i<influenceMap.size(); ++i)
-    {
-        GLubyte value=std::max(0, std::min(255, (int)((influenceMap[i].plateDistanceValue-min)*delta)));
+    //keep the arrows about 10 pixels apart at any zoom
+    int skip=std::max(1, (int)std::ceil(10.0f/m_viewZoom));
+    ImU32 colorRed=IM_COL32(255, 0, 0, 255);
+    ImU32 colorWhite=IM_COL32(255, 255, 255, 255);
 
-        textureBuffer[index++]=value;
-        textureBuffer[index++]=value;
-        textureBuffer[index++]=value;
-        textureBuffer[index++]=255;
-    }
+    for(int y=(minCell.y/skip)*skip; y<maxCell.y; y+=skip)
+    {
+        size_t index=(size_t)y*influenceMapSize.x+(minCell.x/skip)*skip;
 
-    m_textureWidth=influenceMapSize.x;
-    m_textureHeight=influenceMapSize.y;
+        for(int x=(minCell.x/skip)*skip; x<maxCell.x; x+=skip)
+        {
+            glm::vec2 direction;
 
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
+            if(m_overlayVector==1)
+                direction=influenceMap[index].direction;
+            else
+                direction=influenceMap[index].airDirection;
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_textureWidth, m_textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, &textureBuffer[0]);
+            direction.y=-direction.y;//for images y origin is top left
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glm::vec2 point=origin+(glm::vec2(x, y)+0.5f)*m_viewZoom;
+            glm::vec2 endPoint=(direction*8.0f)+point;
 
-    m_textureValid=true;
+            drawList->AddLine(ImVec2(point.x, point.y), ImVec2(endPoint.x, endPoint.y), colorRed);
+            drawList->AddRectFilled(ImVec2(point.x, point.y), ImVec2(point.x+1.0f, point.y+1.0f), colorWhite);
+            index+=skip;
+        }
+    }
 }
 
 //void MapGen::updateContinentTexture(std::vector<GLubyte> &textureBuffer)
@@ -691,43 +514,6 @@ void MapGen::updatePlateDistanceTexture(std::vector<GLubyte> &textureBuffer)
 //    m_textureValid=true;
 //}
 
-void MapGen::updateHeightMapTexture(std::vector<GLubyte> &textureBuffer)
-{
-    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
-    const glm::ivec2 &influenceMapSize=m_worldGenerator->getInfluenceMapSize();
-    imglib::SimpleImage textureImage(imglib::Format::RGBA, imglib::Depth::Bit8, influenceMapSize.x, influenceMapSize.y, &textureBuffer[0], influenceMap.size());
-
-    size_t index=0;
-
-    for(size_t i=0; i<influenceMap.size(); ++i)
-    {
-        const float &height=influenceMap[i].heightBase;
-        
-        glm::ivec4 color=m_biomeColorMap.color((size_t)64*height, 32);
-
-        textureBuffer[index++]=(GLubyte)color.r;
-        textureBuffer[index++]=(GLubyte)color.g;
-        textureBuffer[index++]=(GLubyte)color.b;
-//		textureBuffer[index++]=(GLubyte)255.0f*height;
-//		textureBuffer[index++]=(GLubyte)255.0f*height;
-//		textureBuffer[index++]=(GLubyte)255.0f*height;
-        textureBuffer[index++]=255;
-    }
-
-    m_textureWidth=influenceMapSize.x;
-    m_textureHeight=influenceMapSize.y;
-
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_textureWidth, m_textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, &textureBuffer[0]);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    m_textureValid=true;
-}
-
-
 //void MapGen::updateGeometryTexture(std::vector<GLubyte> &textureBuffer)
 //{
 //    const typename WorldGenerator::InfluenceMap &influenceMap=m_worldGenerator->getInfluenceMap();
@@ -805,11 +591,72 @@ void MapGen::updateHeightMapTexture(std::vector<GLubyte> &textureBuffer)
 
 void MapGen::generate()
 {
-    worldgen::Progress progress;
+    {
+        std::unique_lock<std::mutex> lock(m_generateMutex);
+
+        m_generateRequest.seed=m_noiseSeed;
+        m_generateRequest.plateCount=m_plateCount;
+        m_generateRequest.seededPlates=m_seededPlates;
+        m_generateRequest.plateFrequency=m_descriptors.m_plateFrequency;
+        m_generateRequest.continentFrequency=m_descriptors.m_continentFrequency;
+        m_generatePending=true;
+
+        //anything still running is stale now
+        m_progress.cancel();
+    }
+    m_generateEvent.notify_one();
+}
+
+void MapGen::generateThread()
+{
+    while(true)
+    {
+        GenerateRequest request;
+
+        {
+            std::unique_lock<std::mutex> lock(m_generateMutex);
+
+            m_generateEvent.wait(lock, [this]() { return m_generatePending||m_generateShutdown; });
 
-    m_worldGenerator->m_plateSeed=m_noiseSeed;
-    m_worldGenerator->m_plateCount=m_plateCount;
-    m_worldGenerator->generateWorldOverview(progress);
+            if(m_generateShutdown)
+                return;
 
-//    updateTexture();
-}
\ No newline at end of file
+            request=m_generateRequest;
+            m_generatePending=false;
+            m_progress.reset();
+        }
+
+        worldgen::EquiRectDescriptors &descriptors=m_worldGenerator->getDecriptors();
+
+        descriptors.m_plateFrequency=request.plateFrequency;
+        descriptors.m_continentFrequency=request.continentFrequency;
+        descriptors.m_plateCount=request.plateCount;
+        descriptors.m_plateAssignment=request.seededPlates?worldgen::PlateAssignment::Seeded:worldgen::PlateAssignment::Noise;
+        m_worldGenerator->m_plateSeed=request.seed;
+
+        //cancelled, a newer request is already pending
+        if(!m_worldGenerator->generateWorldOverview(m_progress))
+            continue;
+
+        std::shared_ptr<Overview> overview=std::make_shared<Overview>();
+
+        overview->influenceMap=m_worldGenerator->getInfluenceMap();
+        overview->influenceMapSize=m_worldGenerator->getInfluenceMapSize();
+        overview->plateCount=m_worldGenerator->getPlateCount();
+        overview->fields.build(overview->influenceMap, overview->influenceMapSize, &worldgen::ThreadPool::global());
+
+        //copied so the generator keeps its layers, the next generate only reruns the stages whose parameters changed
+        const worldgen::GenerationLayers &layers=m_worldGenerator->getLayers();
+
+        overview->heightMap_noise.assign(layers.heightMap.begin(), layers.heightMap.end());
+        overview->plateMap_noise.assign(layers.plateMap.begin(), layers.plateMap.end());
+        overview->plate2Map_noise.assign(layers.plate2Map.begin(), layers.plate2Map.end());
+        overview->plateScaleMap.assign(layers.plateScaleMap.begin(), layers.plateScaleMap.end());
+        overview->plate2ScaleMap.assign(layers.plate2ScaleMap.begin(), layers.plate2ScaleMap.end());
+        overview->plateDistance_noise.assign(layers.plateDistance.begin(), layers.plateDistance.end());
+        overview->continentMap_noise.assign(layers.continentMap.begin(), layers.continentMap.end());
+
+        std::atomic_store(&m_overview, std::shared_ptr<const Overview>(overview));
+        m_progress.update(worldgen::Stage::Complete, 100, true);
+    }
+}
@@ -3,36 +3,73 @@
 
 #include "worldgen/utils/colorMap.h"
 #include "worldgen/generators/equiRectWorldGenerator.h"
+#include "worldgen/render/layerRenderer.h"
+
+#include "tilePyramid.h"
 
 #include <glbinding/gl/gl.h>
 using namespace gl;
 
 #include <imgui.h>
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
 typedef worldgen::EquiRectWorldGenerator WorldGenerator;
 
+//immutable copy of a finished generation, the ui draws from one while the worker builds the next
+struct Overview
+{
+    WorldGenerator::InfluenceMap influenceMap;
+    glm::ivec2 influenceMapSize;
+    int plateCount;
+    worldgen::render::Fields fields;
+
+    std::vector<float> heightMap_noise;
+    std::vector<float> plateMap_noise;
+    std::vector<float> plate2Map_noise;
+    std::vector<float> plateScaleMap;
+    std::vector<float> plate2ScaleMap;
+    std::vector<float> plateDistance_noise;
+    std::vector<float> continentMap_noise;
+};
+
+struct GenerateRequest
+{
+    int seed;
+    int plateCount;
+    bool seededPlates;
+    float plateFrequency;
+    float continentFrequency;
+};
+
 class MapGen
 {
 public:
     MapGen();
+    ~MapGen();
     
     void initialize();
+    void terminate();
     void setSize(int width, int height);
 
     void draw();
 
 private:
-    void updateTexture();
-    void updatePlateTexture(std::vector<GLubyte> &textureBuffer);
-    void updatePlateInfoTexture(std::vector<GLubyte> &textureBuffer);
-    void updatePlateDistanceTexture(std::vector<GLubyte> &textureBuffer);
+    void updateLayer();
+    void plateInfoSettings(const Overview &overview, worldgen::render::LayerSettings &settings);
+    void drawView(const Overview &overview, const glm::vec2 &viewPos, const glm::vec2 &viewSize);
+    void drawVectorOverlay(const Overview &overview, ImDrawList *drawList, const glm::vec2 &origin, const glm::ivec2 &minCell, const glm::ivec2 &maxCell);
 //    void updateContinentTexture(std::vector<GLubyte> &textureBuffer);
 //    void updateGeometryTexture(std::vector<GLubyte> &textureBuffer);
-    void updateHeightMapTexture(std::vector<GLubyte> &textureBuffer);
 //    void updateCollisionInfoTexture(std::vector<GLubyte> &textureBuffer);
 //    void updatePlateWithInfoTexture(std::vector<GLubyte> &textureBuffer);
 
+    //queues a generation with the current settings, a running one is cancelled as it is superseded
     void generate();
+    void generateThread();
 
     bool m_show;
 
@@ -44,17 +81,35 @@ private:
     int m_worldHeight;
     int m_worldDepth;
 
+    //owned by the generate thread once initialized, the ui only touches m_descriptors and the snapshots
     std::unique_ptr<WorldGenerator> m_worldGenerator;
 //    WorldGenerator *m_worldGenerator;
+    worldgen::EquiRectDescriptors m_descriptors;
+
+    std::thread m_generateThread;
+    std::mutex m_generateMutex;
+    std::condition_variable m_generateEvent;
+    bool m_generatePending;
+    bool m_generateShutdown;
+    GenerateRequest m_generateRequest;
+
+    //published by the generate thread with atomic_store, m_drawOverview is the one the texture was built from
+    std::shared_ptr<const Overview> m_overview;
+    std::shared_ptr<const Overview> m_drawOverview;
 
     int m_noiseSeed;
     float m_plateFrequency;
     float m_continentFrequency;
 
-    bool m_textureValid;
-    GLuint m_textureId;
-    int m_textureWidth;
-    int m_textureHeight;
+    //overview version bumps on every new snapshot and dirties the cached tiles
+    TilePyramid m_tiles;
+    std::vector<TilePyramid::VisibleTile> m_visibleTiles;
+    size_t m_overviewVersion;
+
+    //view center in map cells, zoom in screen pixels per cell, 0 fits the map to the view
+    glm::vec2 m_viewCenter;
+    float m_viewZoom;
+    glm::ivec2 m_hoverCell;
 
     int m_layerIndex;
     std::vector<char> m_layerNames;
@@ -63,15 +118,12 @@ private:
     int m_overlayVector;
 
     int m_plateCount;
+    bool m_seededPlates;
     std::vector<std::tuple<int, int, int>> m_plateColors;
     
-    worldgen::ColorMap m_tempColorMap;
-    worldgen::ColorMap m_moistureColorMap;
-    worldgen::ColorMap2D m_biomeColorMap;
+    worldgen::render::Palette m_palette;
     worldgen::Progress m_progress;
 
-    ImVec2 lastDrawPos;
-    ImVec2 lastDrawSize;
 };
 
 #endif//_worldgen_mapgen_h_
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "tilePyramid.h"
+
+#include "worldgen/utils/threadPool.h"
+
+#include <algorithm>
+
+TilePyramid::TilePyramid(size_t maxTiles):
+    m_fields(nullptr),
+    m_palette(nullptr),
+    m_version(0),
+    m_levels(1),
+    m_layer(0),
+    m_maxTiles(maxTiles),
+    m_frame(0)
+{
+}
+
+TilePyramid::~TilePyramid()
+{
+    //textures are left to the gl context, clear() has to be called while it is current
+}
+
+void TilePyramid::setSource(const worldgen::render::Fields *fields, const worldgen::render::Palette *palette, size_t version)
+{
+    m_fields=fields;
+    m_palette=palette;
+    m_version=version;
+
+    m_levels=1;
+    if(m_fields)
+    {
+        int size=std::max(m_fields->size.x, m_fields->size.y);
+
+        while((TileSize<<(m_levels-1))<size)
+            m_levels++;
+    }
+}
+
+void TilePyramid::setLayer(uint32_t layer, const worldgen::render::LayerSettings &settings)
+{
+    m_layer=layer;
+    m_settings=settings;
+}
+
+int TilePyramid::lodFor(float cellsPerPixel) const
+{
+    int lod=0;
+
+    while((lod+1<m_levels) && ((float)(1<<(lod+1))<=cellsPerPixel))
+        lod++;
+    return lod;
+}
+
+worldgen::render::Region TilePyramid::tileRegion(int lod, int x, int y) const
+{
+    int stride=1<<lod;
+    int span=TileSize*stride;
+    worldgen::render::Region region(x*span, y*span, span, span, stride);
+
+    region.width=std::min(span, m_fields->size.x-region.x);
+    region.height=std::min(span, m_fields->size.y-region.y);
+    return region;
+}
+
+void TilePyramid::request(const glm::ivec2 &min, const glm::ivec2 &max, int lod, std::vector<VisibleTile> &tiles)
+{
+    tiles.clear();
+    m_frame++;
+
+    if(!m_fields || !m_palette || (m_fields->size.x<=0) || (m_fields->size.y<=0))
+        return;
+
+    lod=std::max(0, std::min(lod, m_levels-1));
+
+    int span=TileSize<<lod;
+    glm::ivec2 tileCount((m_fields->size.x+span-1)/span, (m_fields->size.y+span-1)/span);
+    glm::ivec2 first(std::max(min.x/span, 0), std::max(min.y/span, 0));
+    glm::ivec2 last(std::min((max.x+span-1)/span, tileCount.x), std::min((max.y+span-1)/span, tileCount.y));
+
+    std::vector<Tile *> visible;
+    std::vector<size_t> dirty;
+
+    for(int y=first.y; y<last.y; ++y)
+    {
+        for(int x=first.x; x<last.x; ++x)
+        {
+            TileKey key={m_layer, lod, x, y};
+            auto iter=m_tiles.find(key);
+
+            if(iter==m_tiles.end())
+                iter=m_tiles.emplace(key, Tile{0, ~(size_t)0, 0}).first;
+
+            Tile &tile=iter->second;
+            worldgen::render::Region region=tileRegion(lod, x, y);
+            VisibleTile visibleTile;
+
+            tile.lastUsed=m_frame;
+            if(tile.version!=m_version)
+                dirty.push_back(visible.size());
+
+            visibleTile.texture=0;
+            visibleTile.cell=glm::ivec2(region.x, region.y);
+            visibleTile.cells=glm::ivec2(region.width, region.height);
+            visibleTile.uv=glm::vec2((float)region.outputWidth()/TileSize, (float)region.outputHeight()/TileSize);
+
+            tiles.push_back(visibleTile);
+            visible.push_back(&tile);
+        }
+    }
+
+    if(!dirty.empty())
+    {
+        std::vector<std::vector<uint32_t>> buffers(dirty.size());
+
+        //colorize in parallel, uploads have to stay on the gl thread
+        worldgen::ThreadPool::global().parallelFor(0, dirty.size(), 1, [&](size_t begin, size_t end)
+        {
+            for(size_t i=begin; i<end; ++i)
+            {
+                const VisibleTile &visibleTile=tiles[dirty[i]];
+                int stride=1<<lod;
+                worldgen::render::Region region(visibleTile.cell.x, visibleTile.cell.y, visibleTile.cells.x, visibleTile.cells.y, stride);
+
+                buffers[i].assign(TileSize*TileSize, 0);
+                worldgen::render::renderLayer(*m_fields, *m_palette, m_settings, region, buffers[i].data(), TileSize);
+            }
+        });
+
+        for(size_t i=0; i<dirty.size(); ++i)
+        {
+            Tile &tile=*visible[dirty[i]];
+
+            if(tile.texture==0)
+            {
+                glGenTextures(1, &tile.texture);
+                glBindTexture(GL_TEXTURE_2D, tile.texture);
+
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TileSize, TileSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            }
+            else
+                glBindTexture(GL_TEXTURE_2D, tile.texture);
+
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, TileSize, TileSize, GL_RGBA, GL_UNSIGNED_BYTE, buffers[i].data());
+            tile.version=m_version;
+        }
+    }
+
+    for(size_t i=0; i<visible.size(); ++i)
+        tiles[i].texture=visible[i]->texture;
+
+    evict();
+}
+
+void TilePyramid::evict()
+{
+    if(m_tiles.size()<=m_maxTiles)
+        return;
+
+    std::vector<std::pair<size_t, TileKey>> unused;
+
+    for(auto &entry:m_tiles)
+    {
+        if(entry.second.lastUsed<m_frame)
+            unused.emplace_back(entry.second.lastUsed, entry.first);
+    }
+
+    std::sort(unused.begin(), unused.end(), [](const std::pair<size_t, TileKey> &a, const std::pair<size_t, TileKey> &b) { return a.first<b.first; });
+
+    for(size_t i=0; (i<unused.size()) && (m_tiles.size()>m_maxTiles); ++i)
+    {
+        auto iter=m_tiles.find(unused[i].second);
+
+        if(iter->second.texture!=0)
+            glDeleteTextures(1, &iter->second.texture);
+        m_tiles.erase(iter);
+    }
+}
+
+void TilePyramid::clear()
+{
+    for(auto &entry:m_tiles)
+    {
+        if(entry.second.texture!=0)
+            glDeleteTextures(1, &entry.second.texture);
+    }
+    m_tiles.clear();
+}
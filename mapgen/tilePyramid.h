@@ -0,0 +1,95 @@
+#ifndef _worldgen_tilePyramid_h_
+#define _worldgen_tilePyramid_h_
+
+#include "worldgen/render/layerRenderer.h"
+
+#include <glbinding/gl/gl.h>
+using namespace gl;
+
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+//Colorized layers cut into fixed size tiles at power of two strides. Tiles are cached per layer and
+//lod and only the ones covering the visible area are rendered and uploaded. A new source version
+//marks every tile dirty, dirty tiles keep their texture and are refreshed with glTexSubImage2D.
+class TilePyramid
+{
+public:
+    static constexpr int TileSize=256;
+
+    struct VisibleTile
+    {
+        GLuint texture;
+        glm::ivec2 cell;    //first source cell covered
+        glm::ivec2 cells;   //source cells covered
+        glm::vec2 uv;       //used part of the texture, edge tiles are partial
+    };
+
+    TilePyramid(size_t maxTiles=512);
+    ~TilePyramid();
+
+    //fields and palette must stay alive while tiles are requested, changing version dirties all tiles
+    void setSource(const worldgen::render::Fields *fields, const worldgen::render::Palette *palette, size_t version);
+    void setLayer(uint32_t layer, const worldgen::render::LayerSettings &settings);
+
+    //lod with the largest stride that still has at least one cell per screen pixel
+    int lodFor(float cellsPerPixel) const;
+    int levels() const { return m_levels; }
+
+    //brings the tiles covering cells [min, max) at lod up to date and returns them
+    void request(const glm::ivec2 &min, const glm::ivec2 &max, int lod, std::vector<VisibleTile> &tiles);
+
+    //drops all tiles and their textures, needs the gl context
+    void clear();
+
+private:
+    struct TileKey
+    {
+        bool operator==(const TileKey &key) const { return (layer==key.layer)&&(lod==key.lod)&&(x==key.x)&&(y==key.y); }
+
+        uint32_t layer;
+        int lod;
+        int x;
+        int y;
+    };
+
+    struct TileKeyHash
+    {
+        size_t operator()(const TileKey &key) const
+        {
+            size_t hash=key.layer;
+
+            hash=hash*31+key.lod;
+            hash=hash*1000003+key.x;
+            hash=hash*1000003+key.y;
+            return hash;
+        }
+    };
+
+    struct Tile
+    {
+        GLuint texture;
+        size_t version;
+        size_t lastUsed;
+    };
+
+    worldgen::render::Region tileRegion(int lod, int x, int y) const;
+    void evict();
+
+    const worldgen::render::Fields *m_fields;
+    const worldgen::render::Palette *m_palette;
+    size_t m_version;
+    int m_levels;
+
+    uint32_t m_layer;
+    worldgen::render::LayerSettings m_settings;
+
+    std::unordered_map<TileKey, Tile, TileKeyHash> m_tiles;
+    size_t m_maxTiles;
+    size_t m_frame;
+};
+
+#endif //_worldgen_tilePyramid_h_
@@ -0,0 +1,1060 @@
+#include "worldgen/generators/cubeSphereWorldGenerator.h"
+#include "worldgen/maths/coords.h"
+#include "worldgen/maths/math_helpers.h"
+#include "worldgen/tectonicCurves.h"
+#include "worldgen/plateSeeds.h"
+#include "worldgen/perturbedWeather.h"
+#include "worldgen/weather.h"
+#include "worldgen/noiseNodes.h"
+#include "worldgen/io/stdFileIO.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/hash.h"
+#include "worldgen/utils/trace.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <FastNoise/FastNoise.h>
+
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <queue>
+#include <limits>
+#include <cmath>
+
+namespace worldgen
+{
+
+namespace
+{
+
+//layers the generation stages declare as inputs/outputs
+enum CubeLayerId:LayerId
+{
+    PositionsLayer,
+    HeightLayer,
+    TerrainScaleLayer,
+    AirCurrentLayer,
+    ContinentLayer,
+    PlateLayer,
+    PlateDistanceLayer,
+    InfluenceLayer
+};
+
+//positions are on a sphere of half the equirectangular map width the face size stands for, so the fixed
+//scale noise graphs give features the same size as on EquiRectWorldGenerator
+constexpr float PositionRadiusScale=2.0f;
+
+//same plate warp as the equirectangular seeded plates
+constexpr float PlateWarpAmplitude=0.3f;
+constexpr float PlateWarpFrequency=4.0f;
+
+//cells between cancel checks
+constexpr size_t CancelBandCells=16384;
+constexpr int MoistureLoops=10;
+
+//neighbor slots along the face axes, the ones sharing an edge with the cell
+constexpr int EdgeSlots[4]={1, 3, 4, 6};
+
+//neighbor slots sharing each corner of a cell, corners in bilinear order (-x-y, +x-y, -x+y, +x+y)
+constexpr int CornerSlots[CubeCornerCount][3]={{0, 1, 3}, {1, 2, 4}, {3, 5, 6}, {4, 6, 7}};
+
+//the equirectangular plate frequency for an influence map four faces wide
+inline float plateFrequency(int faceSize)
+{
+    return 0.64f/faceSize;
+}
+
+inline float bilinear(float v00, float v10, float v01, float v11, float t0, float t1)
+{
+    float v0=v00+(v10-v00)*t0;
+    float v1=v01+(v11-v01)*t0;
+
+    return v0+(v1-v0)*t1;
+}
+
+//slot in CubeSphereGrid::neighbors of a step, dx and dy not both 0
+inline int neighborSlot(int dx, int dy)
+{
+    int slot=(dy+1)*3+(dx+1);
+
+    return (slot>4)?slot-1:slot;
+}
+
+//fillPoints over the neighbor table: the neighbor along the major axis of flow gets (1-scale) of value and
+//the diagonal next to it scale, scale being minor/major. Flow is in the cell's face axes.
+void fillNeighbors(const uint32_t *neighbors, const glm::vec2 &flow, float *map, float value)
+{
+    float flowX=std::abs(flow.x);
+    float flowY=std::abs(flow.y);
+
+    if((flowX==0.0f)&&(flowY==0.0f))
+        return;
+
+    int stepX=(flow.x>0.0f)?1:-1;
+    int stepY=(flow.y>0.0f)?1:-1;
+    uint32_t major;
+    float scale;
+
+    if(flowX>=flowY)
+    {
+        major=neighbors[neighborSlot(stepX, 0)];
+        scale=flowY/flowX;
+    }
+    else
+    {
+        major=neighbors[neighborSlot(0, stepY)];
+        scale=flowX/flowY;
+    }
+
+    map[major]=std::min(map[major]+(value*(1.0f-scale)), 1.0f);
+
+    if(scale>0.0f)
+    {
+        uint32_t diagonal=neighbors[neighborSlot(stepX, stepY)];
+
+        map[diagonal]=std::min(map[diagonal]+(value*scale), 1.0f);
+    }
+}
+
+}//namespace
+
+bool CubeSphereDescriptors::load(const char *json)
+{
+    if(strlen(json)<=0)
+        return false;
+
+    rapidjson::Document document;
+
+    document.Parse(json);
+    if(!document.IsObject())
+        return false;
+
+    //descriptors of another generator do not have a face size
+    if(!document.HasMember("faceSize"))
+        return false;
+    m_faceSize=document["faceSize"].GetInt();
+
+    if(document.HasMember("seed"))
+        seed=document["seed"].GetInt();
+    if(document.HasMember("tileSize"))
+        m_tileSize=document["tileSize"].GetInt();
+    if(document.HasMember("plateCount"))
+        m_plateCount=document["plateCount"].GetInt();
+    if(document.HasMember("influenceGridSize"))
+    {
+        const rapidjson::Value &gridSize=document["influenceGridSize"];
+
+        if(gridSize.IsArray()&&(gridSize.Size()==2))
+        {
+            m_influenceGridSize.x=gridSize[0u].GetInt();
+            m_influenceGridSize.y=gridSize[1u].GetInt();
+        }
+    }
+    //optional, unknown names keep the default rather than failing the load
+    if(document.HasMember("simdLevel")&&document["simdLevel"].IsString())
+        parseSimdLevel(document["simdLevel"].GetString(), m_simdLevel);
+
+    return true;
+}
+
+bool CubeSphereDescriptors::save(char *json, size_t &size)
+{
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+
+    rapidjson::Document document;
+
+    document.SetObject();
+
+    document.AddMember("seed", rapidjson::Value(seed).Move(), document.GetAllocator());
+    document.AddMember("faceSize", rapidjson::Value(m_faceSize).Move(), document.GetAllocator());
+    document.AddMember("tileSize", rapidjson::Value(m_tileSize).Move(), document.GetAllocator());
+    document.AddMember("plateCount", rapidjson::Value(m_plateCount).Move(), document.GetAllocator());
+
+    rapidjson::Value gridSize(rapidjson::kArrayType);
+
+    gridSize.PushBack(m_influenceGridSize.x, document.GetAllocator()).PushBack(m_influenceGridSize.y, document.GetAllocator());
+    document.AddMember("influenceGridSize", gridSize, document.GetAllocator());
+    document.AddMember("simdLevel", rapidjson::StringRef(simdLevelName(m_simdLevel)), document.GetAllocator());
+
+    document.Accept(writer);
+
+    if(sb.GetSize()<size-1)
+    {
+        strncpy(json, sb.GetString(), sb.GetSize());
+        size=sb.GetSize();
+        return true;
+    }
+
+    size=sb.GetSize();
+    return false;
+}
+
+void CubeSphereDescriptors::init(const WorldDescriptors &worldDescriptors)
+{
+    if(m_faceSize<=0)
+        calculateFaceSize(worldDescriptors);
+
+    m_tileSize=std::max(m_tileSize, 1);
+    m_plateCount=std::max(m_plateCount, 1);
+}
+
+uint64_t CubeSphereDescriptors::hash() const
+{
+    //field by field, hashing the struct bytes would pick up padding
+    Hash64 hash;
+
+    hash.add(seed);
+    hash.add(m_faceSize);
+    hash.add(m_tileSize);
+    hash.add(m_plateCount);
+    hash.add(m_influenceGridSize.x).add(m_influenceGridSize.y);
+    //m_simdLevel is left out, it changes how fast the noise runs rather than what it produces
+    return hash.value();
+}
+
+
+//one graph per noise stage, as EquiRectWorldGenerator::Hidden
+class CubeSphereWorldGenerator::Hidden
+{
+public:
+    Hidden():
+        m_plateSeedsKey(0)
+    {}
+
+    void build(const CubeSphereDescriptors &descriptors, int faceSize)
+    {
+        FastSIMD::eLevel simdLevel=(FastSIMD::eLevel)toFastSimdLevel(descriptors.m_simdLevel);
+        float frequency=plateFrequency(faceSize);
+
+        m_heightNoise=newFractalNoise(0.01f, false, simdLevel);
+        m_terrainScaleNoise=newFractalNoise(0.05f, false, simdLevel);
+        m_airCurrentNoise=newFractalNoise(0.01f, true, simdLevel);
+        m_continentNoise=newWarpedCellular(newCellularValue(0, simdLevel), 10*frequency, simdLevel);
+        m_plateWarpNoise=newFractalNoise(PlateWarpFrequency*frequency, false, simdLevel);
+    }
+
+    //seeds are only placed again when the count or seed changes
+    const PlateSeeds &plateSeeds(int count, int seed)
+    {
+        uint64_t key=Hash64().add(count).add(seed).value();
+
+        if(m_plateSeedsKey!=key)
+        {
+            m_plateSeeds.build((size_t)std::max(count, 1), seed, &ThreadPool::global());
+            m_plateSeedsKey=key;
+        }
+        return m_plateSeeds;
+    }
+
+    FastNoise::SmartNode<> m_heightNoise;
+    FastNoise::SmartNode<> m_terrainScaleNoise;
+    FastNoise::SmartNode<> m_airCurrentNoise;
+    FastNoise::SmartNode<> m_continentNoise;
+    FastNoise::SmartNode<> m_plateWarpNoise;
+
+    PlateSeeds m_plateSeeds;
+    uint64_t m_plateSeedsKey;
+};
+
+CubeSphereWorldGenerator::CubeSphereWorldGenerator():
+    m_plateSeed(0),
+    m_continentSeed(0)
+{
+    m_hidden.reset(new Hidden());
+}
+
+
+CubeSphereWorldGenerator::~CubeSphereWorldGenerator()
+{
+}
+
+
+bool CubeSphereWorldGenerator::create(WorldDescriptors *descriptors, Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("create");
+
+    initialize(descriptors);
+
+    if(!generateWorldOverview(progress))
+        return false;
+
+    progress.update(Stage::Neighbors, 80);
+    updateCornerHeights();
+    progress.update(Stage::Complete, 100, true);
+    return true;
+}
+
+
+void CubeSphereWorldGenerator::initialize(WorldDescriptors *descriptors)
+{
+    m_descriptors=*descriptors;
+
+    bool loaded=m_descriptorValues.load(m_descriptors.getGeneratorArgs().c_str());
+
+    if(!loaded)
+    {
+        m_descriptorValues.calculateFaceSize(m_descriptors);
+        saveDescriptors(m_descriptors.getGeneratorArgs());
+    }
+
+    m_descriptorValues.init(m_descriptors);
+
+    int seed=m_descriptorValues.seed;
+
+    m_continentSeed=seed;
+    m_plateSeed=seed+2;
+}
+
+
+void CubeSphereWorldGenerator::loadDescriptors(WorldDescriptors *descriptors)
+{
+    initialize(descriptors);
+}
+
+
+void CubeSphereWorldGenerator::saveDescriptors(WorldDescriptors *descriptors)
+{
+    saveDescriptors(descriptors->getGeneratorArgs());
+}
+
+
+void CubeSphereWorldGenerator::saveDescriptors(std::string &descriptors)
+{
+    size_t size=1024;
+
+    descriptors.resize(size);
+
+    //removing const as we plan to stay inside the memory range from the resize above
+    if(!m_descriptorValues.save((char *)descriptors.data(), size))
+    {
+        descriptors.resize(size);
+        m_descriptorValues.save((char *)descriptors.data(), size);
+    }
+    descriptors.resize(size);
+}
+
+
+template<typename _FileIO>
+bool CubeSphereWorldGenerator::load(WorldDescriptors *descriptors, const std::string &directory, Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("load");
+
+    typedef generic::io::fs<_FileIO> fs;
+
+    initialize(descriptors);
+    //the file is checked against the grid of the descriptors
+    m_grid.build(m_descriptorValues.m_faceSize, m_descriptorValues.m_tileSize);
+
+    std::string overviewFileName=directory+"/cubeSphere.bin";
+    bool loaded=false;
+
+    progress.update(Stage::Loading, 0);
+    if(fs::exists(overviewFileName))
+        loaded=loadWorldOverview<_FileIO>(overviewFileName);
+
+    if(loaded)
+    {
+        //plates are not stored, the cells have everything they are built from
+        size_t cellCount=m_influenceMap.size();
+        std::vector<uint32_t> plates(cellCount);
+        std::vector<uint32_t> borderPlates(cellCount);
+
+        for(size_t i=0; i<cellCount; ++i)
+        {
+            plates[i]=(uint32_t)m_influenceMap[i].tectonicPlate;
+            borderPlates[i]=(uint32_t)m_influenceMap[i].borderPlate;
+        }
+
+        buildPlates(plates, borderPlates);
+        m_plateIndex.build(m_plates);
+    }
+    else if(!generateWorldOverview(progress))
+        return false;
+
+    progress.update(Stage::Neighbors, 80);
+    updateCornerHeights();
+    progress.update(Stage::Complete, 100, true);
+
+    return loaded;
+}
+
+
+template<typename _FileIO>
+bool CubeSphereWorldGenerator::save(const std::string &directory)
+{
+    WORLDGEN_TRACE_ZONE("save");
+
+    typedef generic::io::fs<_FileIO> fs;
+
+    if(!fs::exists(directory))
+        fs::create_directory(directory);
+
+    return saveWorldOverview<_FileIO>(directory+"/cubeSphere.bin");
+}
+
+
+uint64_t CubeSphereWorldGenerator::cacheKey() const
+{
+    const glm::ivec3 &size=m_descriptors.getSize();
+    Hash64 hash;
+
+    hash.add(CubeSphereWorldFormatVersion);
+    hash.add(std::string(typeName()));
+    hash.add(size.x).add(size.y).add(size.z);
+    hash.add(m_descriptorValues.hash());
+    //mapgen changes these without going through the descriptors
+    hash.add(m_plateSeed).add(m_continentSeed);
+    return hash.value();
+}
+
+
+bool CubeSphereWorldGenerator::generateWorldOverview(Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("generateWorldOverview");
+
+    struct NoiseStage
+    {
+        const char *name;
+        LayerId layer;
+        Stage stage;
+        int percent;
+        const FastNoise::Generator *generator;
+        std::vector<float> *output;
+        int seed;
+    };
+
+    //face size can change between generations (mapgen edits the descriptors)
+    m_grid.build(m_descriptorValues.m_faceSize, m_descriptorValues.m_tileSize);
+    m_hidden->build(m_descriptorValues, m_grid.faceSize());
+
+    const size_t cellCount=m_grid.cellCount();
+    const NoiseStage stages[]=
+    {
+        {"height", HeightLayer, Stage::HeightMap, 15, m_hidden->m_heightNoise.get(), &m_heightMap, m_plateSeed},
+        {"terrainScale", TerrainScaleLayer, Stage::Terrain, 20, m_hidden->m_terrainScaleNoise.get(), &m_terrainScaleMap, m_plateSeed},
+        {"airCurrent", AirCurrentLayer, Stage::AirCurrents, 25, m_hidden->m_airCurrentNoise.get(), &m_airCurrentMap, m_plateSeed+3},
+        {"continents", ContinentLayer, Stage::Continents, 45, m_hidden->m_continentNoise.get(), &m_continentMap, m_continentSeed}
+    };
+
+    std::vector<uint32_t> plates;
+    std::vector<uint32_t> borderPlates;
+    std::vector<float> plateDistance;
+    StageGraph graph;
+
+    graph.add("coordinates", {}, {PositionsLayer}, [this, cellCount, &progress]()
+        {
+            progress.update(Stage::Allocating, 5);
+            m_xPositions.resize(cellCount);
+            m_yPositions.resize(cellCount);
+            m_zPositions.resize(cellCount);
+
+            progress.update(Stage::Coordinates, 10);
+            if(progress.cancelled())
+                return false;
+
+            m_grid.positions(PositionRadiusScale*m_grid.faceSize(), m_xPositions.data(), m_yPositions.data(), m_zPositions.data());
+            return true;
+        });
+
+    //every noise pass only reads the positions and writes its own layer
+    for(const NoiseStage &stage:stages)
+    {
+        graph.add(stage.name, {PositionsLayer}, {stage.layer}, [this, stage, cellCount, &progress]()
+            {
+                progress.update(stage.stage, stage.percent);
+                stage.output->resize(cellCount);
+
+                return generateNoise(stage.generator, stage.output->data(), stage.seed, progress);
+            });
+    }
+
+    graph.add("plates", {PositionsLayer}, {PlateLayer}, [this, &plates, &borderPlates, &progress]()
+        {
+            progress.update(Stage::TectonicPlates, 30);
+            return generatePlates(plates, borderPlates, progress);
+        });
+    graph.add("plateDistance", {PlateLayer}, {PlateDistanceLayer}, [this, &plates, &plateDistance, &progress]()
+        {
+            progress.update(Stage::TectonicPlates, 35);
+            return generatePlateDistance(plates, plateDistance, progress);
+        });
+    graph.add("processing", {HeightLayer, TerrainScaleLayer, AirCurrentLayer, ContinentLayer, PlateLayer, PlateDistanceLayer}, {InfluenceLayer},
+        [this, &plates, &borderPlates, &plateDistance, &progress]()
+        {
+            return processCells(plates, borderPlates, plateDistance, progress);
+        });
+
+    bool complete=graph.run(&ThreadPool::global());
+
+    m_stageTimings=graph.timings();
+
+    //swap with empties so the memory is actually returned, only the influence map is kept
+    std::vector<float>().swap(m_xPositions);
+    std::vector<float>().swap(m_yPositions);
+    std::vector<float>().swap(m_zPositions);
+    std::vector<float>().swap(m_heightMap);
+    std::vector<float>().swap(m_terrainScaleMap);
+    std::vector<float>().swap(m_airCurrentMap);
+    std::vector<float>().swap(m_continentMap);
+
+    if(!complete)
+    {
+        releaseGeneration();
+        progress.update(Stage::Cancelled, 0, true);
+        return false;
+    }
+    return true;
+}
+
+
+void CubeSphereWorldGenerator::releaseGeneration()
+{
+    InfluenceMap().swap(m_influenceMap);
+    std::vector<float>().swap(m_cornerHeights);
+    m_plates.clear();
+    m_plateIndex.clear();
+}
+
+
+bool CubeSphereWorldGenerator::generateNoise(const FastNoise::Generator *node, float *output, int seed, Progress &progress) const
+{
+    WORLDGEN_TRACE_ZONE("generateNoise");
+
+    size_t mapSize=m_xPositions.size();
+
+    //noise is per position so generating in bands is identical to a single pass
+    for(size_t start=0; start<mapSize; start+=CancelBandCells)
+    {
+        if(progress.cancelled())
+            return false;
+
+        int count=(int)std::min(CancelBandCells, mapSize-start);
+
+        node->GenPositionArray3D(output+start, count, m_xPositions.data()+start, m_yPositions.data()+start, m_zPositions.data()+start,
+            0.0f, 0.0f, 0.0f, seed);
+    }
+    return true;
+}
+
+
+template<typename _FileIO>
+bool CubeSphereWorldGenerator::loadWorldOverview(const std::string &fileName)
+{
+    typedef generic::io::fs<_FileIO> fs;
+
+    typename fs::Type *file=fs::open(fileName, "rb");
+
+    if(!file)
+        return false;
+
+    CubeSphereWorldGeneratorHeader header;
+
+    size_t readSize=fs::read(&header, 1, sizeof(CubeSphereWorldGeneratorHeader), file);
+    bool valid=(readSize == sizeof(CubeSphereWorldGeneratorHeader));
+
+    valid=valid&&(header.marker == CubeSphereWorldGeneratorHeader_Marker);
+    valid=valid&&(header.version == CubeSphereWorldFormatVersion);
+    //written for other descriptors, regenerate rather than serve a stale world
+    valid=valid&&(header.descriptorKey == cacheKey());
+    valid=valid&&(header.cellSize==sizeof(InfluenceCell));
+    //cells are in the grid's tiled order, the layout has to match
+    valid=valid&&(header.faceSize==(unsigned int)m_grid.faceSize());
+    valid=valid&&(header.tileSize==(unsigned int)m_grid.tileSize());
+
+    size_t cellCount=m_grid.cellCount();
+
+    valid=valid&&(header.size==cellCount*sizeof(InfluenceCell));
+
+    if(!valid)
+    {
+        fs::close(file);
+        return false;
+    }
+
+    m_influenceMap.resize(cellCount);
+
+    readSize=fs::read(m_influenceMap.data(), sizeof(InfluenceCell), cellCount, file);
+    fs::close(file);
+
+    return (readSize == cellCount);
+}
+
+
+template<typename _FileIO>
+bool CubeSphereWorldGenerator::saveWorldOverview(const std::string &fileName) const
+{
+    typedef generic::io::fs<_FileIO> fs;
+
+    typename fs::Type *file=fs::open(fileName, "wb");
+
+    if(!file)
+        return false;
+
+    CubeSphereWorldGeneratorHeader header;
+
+    header.marker=CubeSphereWorldGeneratorHeader_Marker;
+    header.version=CubeSphereWorldFormatVersion;
+    header.faceSize=m_grid.faceSize();
+    header.tileSize=m_grid.tileSize();
+    header.cellSize=sizeof(InfluenceCell);
+    header.size=m_influenceMap.size()*sizeof(InfluenceCell);
+    header.descriptorKey=cacheKey();
+
+    assert(m_influenceMap.size()==m_grid.cellCount());
+
+    fs::write(&header, sizeof(CubeSphereWorldGeneratorHeader), 1, file);
+    size_t written=fs::write(m_influenceMap.data(), sizeof(InfluenceCell), m_influenceMap.size(), file);
+    fs::close(file);
+
+    return (written==m_influenceMap.size());
+}
+
+
+bool CubeSphereWorldGenerator::generatePlates(std::vector<uint32_t> &plates, std::vector<uint32_t> &borderPlates, Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("generatePlates");
+
+    const PlateSeeds &seeds=m_hidden->plateSeeds(m_descriptorValues.m_plateCount, m_plateSeed);
+    size_t cellCount=m_grid.cellCount();
+    std::vector<float> warpX(cellCount);
+    std::vector<float> warpY(cellCount);
+    std::vector<float> warpZ(cellCount);
+
+    if(!generateNoise(m_hidden->m_plateWarpNoise.get(), warpX.data(), m_plateSeed+5, progress)||
+        !generateNoise(m_hidden->m_plateWarpNoise.get(), warpY.data(), m_plateSeed+6, progress)||
+        !generateNoise(m_hidden->m_plateWarpNoise.get(), warpZ.data(), m_plateSeed+7, progress))
+        return false;
+
+    //warp scaled to the seed spacing so plate borders are ragged by the same amount whatever the plate count
+    float radius=PositionRadiusScale*m_grid.faceSize();
+    float amplitude=PlateWarpAmplitude*seeds.spacing();
+
+    for(size_t i=0; i<cellCount; ++i)
+    {
+        warpX[i]=m_xPositions[i]/radius+amplitude*warpX[i];
+        warpY[i]=m_yPositions[i]/radius+amplitude*warpY[i];
+        warpZ[i]=m_zPositions[i]/radius+amplitude*warpZ[i];
+    }
+
+    //plate indices are seed indices, the index answers for any position without the grid
+    m_plateIndex.build(seeds.positions());
+
+    plates.resize(cellCount);
+    borderPlates.resize(cellCount);
+    m_plateIndex.nearest2(warpX.data(), warpY.data(), warpZ.data(), cellCount, plates.data(), borderPlates.data(), &ThreadPool::global());
+    return !progress.cancelled();
+}
+
+
+bool CubeSphereWorldGenerator::generatePlateDistance(const std::vector<uint32_t> &plates, std::vector<float> &plateDistance, Progress &progress) const
+{
+    WORLDGEN_TRACE_ZONE("generatePlateDistance");
+
+    typedef std::pair<float, uint32_t> QueueEntry;
+
+    size_t cellCount=m_grid.cellCount();
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+    plateDistance.assign(cellCount, std::numeric_limits<float>::max());
+
+    //border cells are the ones with an edge neighbor on another plate
+    for(size_t i=0; i<cellCount; ++i)
+    {
+        const uint32_t *neighbors=m_grid.neighbors(i);
+
+        for(int slot:EdgeSlots)
+        {
+            if(plates[neighbors[slot]]!=plates[i])
+            {
+                plateDistance[i]=0.0f;
+                queue.push(QueueEntry(0.0f, (uint32_t)i));
+                break;
+            }
+        }
+    }
+
+    //Shortest paths from the borders over the neighbor table, steps are the chords between cell centers. Runs
+    //over the face seams like anywhere else, the distance is along the sphere in radians.
+    size_t settled=0;
+
+    while(!queue.empty())
+    {
+        QueueEntry entry=queue.top();
+
+        queue.pop();
+        if(entry.first>plateDistance[entry.second])
+            continue;
+
+        if(((++settled)%CancelBandCells==0) && progress.cancelled())
+            return false;
+
+        const glm::vec3 &center=m_grid.center(entry.second);
+        const uint32_t *neighbors=m_grid.neighbors(entry.second);
+
+        for(int slot=0; slot<CubeSphereGrid::CellNeighborCount; ++slot)
+        {
+            uint32_t neighbor=neighbors[slot];
+            float distance=entry.first+glm::length(m_grid.center(neighbor)-center);
+
+            if(distance<plateDistance[neighbor])
+            {
+                plateDistance[neighbor]=distance;
+                queue.push(QueueEntry(distance, neighbor));
+            }
+        }
+    }
+
+    //1 on the border falling towards the plate centers as the equirectangular distance (half way around the
+    //sphere is the map height there), the per plate range is normalized in processing
+    const float pi=glm::pi<float>();
+
+    for(size_t i=0; i<cellCount; ++i)
+        plateDistance[i]=1.0f-std::min(plateDistance[i], pi)/pi;
+
+    return !progress.cancelled();
+}
+
+
+void CubeSphereWorldGenerator::buildPlates(const std::vector<uint32_t> &plates, const std::vector<uint32_t> &borderPlates)
+{
+    WORLDGEN_TRACE_ZONE("buildPlates");
+
+    const PlateSeeds &seeds=m_hidden->plateSeeds(m_descriptorValues.m_plateCount, m_plateSeed);
+    std::vector<std::pair<uint32_t, uint32_t>> neighbors;
+    std::pair<uint32_t, uint32_t> lastNeighbor(0, 0);
+
+    for(size_t i=0; i<plates.size(); ++i)
+    {
+        std::pair<uint32_t, uint32_t> neighbor(plates[i], borderPlates[i]);
+
+        if((neighbor.first!=neighbor.second)&&(neighbor!=lastNeighbor))
+        {
+            neighbors.push_back(neighbor);
+            lastNeighbor=neighbor;
+        }
+    }
+
+    //sorted so each plate gets its neighbors in index order
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+    m_plates.assign(seeds.size(), PlateInfo());
+
+    for(const std::pair<uint32_t, uint32_t> &neighbor:neighbors)
+        m_plates[neighbor.first].neighbors.push_back(neighbor.second);
+
+    for(size_t i=0; i<m_plates.size(); ++i)
+    {
+        PlateInfo &details=m_plates[i];
+
+        details.index=i;
+        details.value=seeds.values()[i];
+
+        //we want plate heights to be 0.5 to -0.5, as the equirectangular plates
+        details.height=details.value*0.1f+0.5f;
+        if(details.height<0.5f)
+            details.height=details.height-0.05f;
+
+        //there is no map point on the cube, the seed is the plate's point
+        details.point=glm::ivec2(-1, -1);
+        details.point3d=seeds.positions()[i];
+    }
+
+    initPlateMotion(m_plates, m_descriptorValues.seed);
+}
+
+
+bool CubeSphereWorldGenerator::processCells(const std::vector<uint32_t> &plates, const std::vector<uint32_t> &borderPlates, const std::vector<float> &plateDistance,
+    Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("processCells");
+
+    size_t cellCount=m_grid.cellCount();
+    int faceSize=m_grid.faceSize();
+
+    progress.update(Stage::WeatherBands, 47);
+    //sized as the equirectangular map with the same equator resolution
+    PerturbedWeatherBands weather(m_plateSeed+10, glm::ivec2(4*faceSize, 2*faceSize), getWeatherCells(), m_descriptorValues.m_simdLevel);
+
+    if(progress.cancelled())
+        return false;
+
+    progress.update(Stage::TectonicZones, 55);
+    buildPlates(plates, borderPlates);
+
+    std::vector<float> minDistance(m_plates.size(), 2.0f);
+    std::vector<float> maxDistance(m_plates.size(), -2.0f);
+
+    for(size_t i=0; i<cellCount; ++i)
+    {
+        minDistance[plates[i]]=std::min(minDistance[plates[i]], plateDistance[i]);
+        maxDistance[plates[i]]=std::max(maxDistance[plates[i]], plateDistance[i]);
+    }
+
+    m_influenceMap.assign(cellCount, InfluenceCell());
+
+    InfluenceCell *cells=m_influenceMap.data();
+    std::vector<TectonicCurve> curveMap(cellCount);
+    std::vector<float> curveScaleMap(cellCount);
+
+    progress.update(Stage::PlateHeight, 50);
+
+    //boundary type of every cell first so the terrain curves are evaluated in one pass
+    for(size_t i=0; i<cellCount; i++)
+    {
+        if((i%CancelBandCells==0) && progress.cancelled())
+            return false;
+
+        size_t index=plates[i];
+        size_t borderIndex=borderPlates[i];
+
+        const PlateInfo &details=m_plates[index];
+        const PlateInfo &details2=m_plates[borderIndex];
+
+        float collision=0.0f;
+
+        //neighbors come from these same pairs, the border plate is always found
+        for(size_t j=0; j<details.neighbors.size(); ++j)
+        {
+            if(details.neighbors[j]==borderIndex)
+                collision=details.neighborCollisions[j];
+        }
+
+        cells[i].tectonicPlate=index;
+        cells[i].borderPlate=borderIndex;
+        cells[i].plateHeight=details.value*0.1f+0.5f;
+        cells[i].plateValue=details.value;
+        cells[i].continentValue=m_continentMap[i];
+
+        //normalize distance, a plate that is nothing but border has no range
+        float distanceRange=maxDistance[index]-minDistance[index];
+
+        cells[i].plateDistanceValue=(distanceRange>0.0f)?(plateDistance[i]-minDistance[index])/distanceRange:1.0f;
+        cells[i].collision=collision;
+
+        curveMap[i]=tectonicCurve(collision, (details.height<0.5f), (details2.height<0.5f));
+        curveScaleMap[i]=cells[i].plateDistanceValue;
+    }
+
+    if(progress.cancelled())
+        return false;
+
+    progress.update(Stage::InfluenceMap, 60);
+    tectonicCurveTable().evaluate(curveMap.data(), curveScaleMap.data(), curveScaleMap.data(), cellCount);
+
+    std::vector<float> moistureMap(cellCount);
+    std::vector<float> moistureDeltaMap(cellCount);
+    //wind in each cell's face axes, what the moisture sweep steps along
+    std::vector<glm::vec2> faceWind(cellCount);
+
+    for(size_t i=0; i<cellCount; i++)
+    {
+        if((i%CancelBandCells==0) && progress.cancelled())
+            return false;
+
+        const PlateInfo &details=m_plates[cells[i].tectonicPlate];
+        const PlateInfo &details2=m_plates[cells[i].borderPlate];
+
+        //magnitude, the curve carries the direction
+        float collision=std::abs(cells[i].collision);
+
+        const glm::vec3 &cartPoint=m_grid.center(i);
+        glm::vec3 sphericalPoint;
+        glm::vec3 direction;
+        glm::vec3 sphericalDirection;
+
+        projectPoint<Projections::Cartesian, Projections::Spherical>(cartPoint, sphericalPoint);
+        rotateTangetVectorToPoint(cartPoint, details.driftDirection, direction);
+
+        projectVector(direction, sphericalPoint, sphericalDirection);
+        cells[i].direction.x=sphericalDirection.y;
+        cells[i].direction.y=sphericalDirection.z;
+
+        //air currents from the bands, x east and y north
+        glm::vec2 latLong(sphericalPoint.y, sphericalPoint.z);
+        float latitude=sphericalPoint.z;
+
+        cells[i].weatherCell=weather.getCellIndex(latLong);
+        cells[i].weatherBand=weather.getBandIndex(latLong);
+        cells[i].airDirection=weather.getWindDirection(latLong);
+
+        float sinTheta=std::sin(sphericalPoint.y);
+        float cosTheta=std::cos(sphericalPoint.y);
+        float sinPhi=std::sin(sphericalPoint.z);
+        float cosPhi=std::cos(sphericalPoint.z);
+        glm::vec3 east(-sinTheta, cosTheta, 0.0f);
+        glm::vec3 north(-cosTheta*sinPhi, -sinTheta*sinPhi, cosPhi);
+        glm::vec3 wind=east*cells[i].airDirection.x+north*cells[i].airDirection.y;
+
+        //face axes from the neighbors either side, these follow the cell's own face over the seams
+        const uint32_t *neighbors=m_grid.neighbors(i);
+        glm::vec3 xAxis=m_grid.center(neighbors[neighborSlot(1, 0)])-m_grid.center(neighbors[neighborSlot(-1, 0)]);
+        glm::vec3 yAxis=m_grid.center(neighbors[neighborSlot(0, 1)])-m_grid.center(neighbors[neighborSlot(0, -1)]);
+
+        faceWind[i]=glm::vec2(glm::dot(wind, glm::normalize(xAxis)), glm::dot(wind, glm::normalize(yAxis)));
+
+        //build terrain
+        bool oceanPlate=(details.height<0.5f);
+        bool oceanPlate2=(details2.height<0.5f);
+
+        float plateScale;
+        float plate2Scale;
+        float terrainScale=curveScaleMap[i];
+
+        calculateCurve(cells[i].plateDistanceValue, plateScale, plate2Scale, (oceanPlate!=oceanPlate2)?0.7f:0.5f);
+
+        float genHeight=(m_heightMap[i]+1.0f)*0.05f;
+        float genTerrainScale=(m_terrainScaleMap[i]+1.0f)*0.2f+0.2f;
+
+        cells[i].heightBase=((details.height+genHeight)*plateScale)+(details2.height*plate2Scale)+(terrainScale*collision*genTerrainScale);
+        cells[i].heightBase=std::max(std::min(cells[i].heightBase, 1.0f), 0.0f);
+        cells[i].terrainScale=terrainScale;
+
+        cells[i].temperature=getTemperature(latitude);
+
+        float bandMoisture=weather.getMoisture(latLong);
+
+        cells[i].moistureCapacity=bandMoisture*0.5f;
+        if(cells[i].heightBase<0.5f)
+            moistureMap[i]=1.0f;
+        else
+            moistureMap[i]=(bandMoisture*0.9f)+(m_airCurrentMap[i]*0.1f);
+    }
+
+    progress.update(Stage::Moisture, 70);
+
+    for(size_t i=0; i<cellCount; i++)
+        moistureDeltaMap[i]=(cells[i].heightBase>0.5f)?0.0f:1.0f;
+
+    WORLDGEN_TRACE_ZONE("moisture");
+
+    for(int loop=0; loop<MoistureLoops; ++loop)
+    {
+        for(size_t i=0; i<cellCount; i++)
+        {
+            if((i%CancelBandCells==0) && progress.cancelled())
+                return false;
+
+            if(moistureMap[i]>0.0f)
+            {
+                float magnitude=glm::length(cells[i].airDirection);
+                float moistureCaptured=moistureDeltaMap[i]*cells[i].moistureCapacity*magnitude;
+
+                if(cells[i].heightBase>0.5f)
+                    moistureDeltaMap[i]=moistureDeltaMap[i]-moistureCaptured;
+
+                fillNeighbors(m_grid.neighbors(i), faceWind[i], moistureDeltaMap.data(), moistureCaptured);
+            }
+        }
+    }
+
+    for(size_t i=0; i<cellCount; i++)
+        cells[i].moisture=std::max(std::min(moistureMap[i]+moistureDeltaMap[i], 1.0f), 0.0f);
+
+    traceCellsProcessed().add((int64_t)cellCount);
+    return true;
+}
+
+
+void CubeSphereWorldGenerator::updateCornerHeights()
+{
+    WORLDGEN_TRACE_ZONE("updateCornerHeights");
+
+    size_t cellCount=m_influenceMap.size();
+
+    m_cornerHeights.resize(cellCount*CubeCornerCount);
+
+    for(size_t i=0; i<cellCount; ++i)
+    {
+        const uint32_t *neighbors=m_grid.neighbors(i);
+        float *cornerHeights=&m_cornerHeights[i*CubeCornerCount];
+
+        for(int corner=0; corner<CubeCornerCount; ++corner)
+        {
+            //only 3 cells meet at a cube corner, the repeated neighbor there is counted once so the cells on
+            //every face agree on the corner
+            uint32_t cornerCells[4]={(uint32_t)i, neighbors[CornerSlots[corner][0]], neighbors[CornerSlots[corner][1]], neighbors[CornerSlots[corner][2]]};
+            float height=0.0f;
+            int count=0;
+
+            for(int j=0; j<4; ++j)
+            {
+                bool repeated=false;
+
+                for(int k=0; k<j; ++k)
+                    repeated=repeated||(cornerCells[k]==cornerCells[j]);
+
+                if(!repeated)
+                {
+                    height+=m_influenceMap[cornerCells[j]].heightBase;
+                    count++;
+                }
+            }
+            cornerHeights[corner]=height/count;
+        }
+    }
+}
+
+
+unsigned int CubeSphereWorldGenerator::generateChunk(const glm::vec3 &startPos, const glm::ivec3 &chunkSize, void *buffer, size_t bufferSize, size_t lod)
+{
+    WORLDGEN_TRACE_ZONE("generateChunk");
+
+    //chunks are not built from the overview yet, as EquiRectWorldGenerator
+    return 0;
+}
+
+
+unsigned int CubeSphereWorldGenerator::generateRegion(const glm::vec3 &startPos, const glm::ivec3 &regionSize, void *buffer, size_t bufferSize, size_t lod)
+{
+    WORLDGEN_TRACE_ZONE("generateRegion");
+
+    //regions are not built from the overview yet, as EquiRectWorldGenerator
+    return 0;
+}
+
+
+int CubeSphereWorldGenerator::getBaseHeight(const glm::vec2 &pos)
+{
+    glm::ivec3 size=m_descriptors.getSize();
+    glm::vec2 mapPoint(pos.x/(float)size.x, pos.y/(float)size.y);
+    glm::vec3 direction;
+
+    projectPoint<Projections::Equirectangular, Projections::Cartesian>(mapPoint, direction);
+    return getSphereHeight(direction);
+}
+
+
+void CubeSphereWorldGenerator::getBaseHeights(const glm::vec2 *positions, int *heights, size_t count)
+{
+    WORLDGEN_TRACE_ZONE("getBaseHeights");
+
+    for(size_t i=0; i<count; ++i)
+        heights[i]=getBaseHeight(positions[i]);
+}
+
+
+int CubeSphereWorldGenerator::getSphereHeight(const glm::vec3 &direction) const
+{
+    glm::vec2 coords;
+    int face=m_grid.locate(direction, coords);
+    int faceSize=m_grid.faceSize();
+    int x=std::min(std::max((int)coords.x, 0), faceSize-1);
+    int y=std::min(std::max((int)coords.y, 0), faceSize-1);
+    float cellX=std::min(std::max(coords.x-x, 0.0f), 1.0f);
+    float cellY=std::min(std::max(coords.y-y, 0.0f), 1.0f);
+    const float *cornerHeights=&m_cornerHeights[m_grid.index(face, x, y)*CubeCornerCount];
+
+    float heightBase=bilinear(cornerHeights[0], cornerHeights[1], cornerHeights[2], cornerHeights[3], cellX, cellY);
+
+    return heightBase*(float)m_descriptors.getSize().z;
+}
+
+template bool CubeSphereWorldGenerator::load<StdFileIO>(WorldDescriptors *descriptors, const std::string &directory, Progress &progress);
+template bool CubeSphereWorldGenerator::save<StdFileIO>(const std::string &directory);
+
+}//namespace worldgen
@@ -1,18 +1,52 @@
 #include "worldgen/generators/equiRectWorldGenerator.h"
+#include "worldgen/maths/coordsSoA.h"
+#include "worldgen/tectonicCurves.h"
+#include "worldgen/plateBoundaries.h"
+#include "worldgen/plateSeeds.h"
+#include "worldgen/noiseNodes.h"
+#include "worldgen/io/stdFileIO.h"
+#include "worldgen/io/worldCache.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/hash.h"
+#include "worldgen/utils/trace.h"
 
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
-#include <glm/gtx/projection.hpp>
-
 #include <FastNoise/FastNoise.h>
 
+#include <cstring>
+#include <algorithm>
+
 namespace chrono=std::chrono;
 
 namespace worldgen
 {
 
+const char *plateAssignmentName(PlateAssignment assignment)
+{
+    switch(assignment)
+    {
+    case PlateAssignment::Noise:
+        return "noise";
+    case PlateAssignment::Seeded:
+        return "seeded";
+    }
+    return "unknown";
+}
+
+bool parsePlateAssignment(const std::string &name, PlateAssignment &assignment)
+{
+    if(name=="noise")
+        assignment=PlateAssignment::Noise;
+    else if(name=="seeded")
+        assignment=PlateAssignment::Seeded;
+    else
+        return false;
+    return true;
+}
+
 bool EquiRectDescriptors::load(const char *json)
 {
     if(strlen(json)<=0)
@@ -23,6 +57,9 @@ bool EquiRectDescriptors::load(const char *json)
     document.Parse(json);
     bool retValue=true;
     
+    //optional, worlds saved before it was stored keep the default
+    if(document.HasMember("seed"))
+        seed=document["seed"].GetInt();
     if(document.HasMember("noiseScale"))
         m_noiseScale=document["noiseScale"].GetFloat();
     else
@@ -48,6 +85,35 @@ bool EquiRectDescriptors::load(const char *json)
     else
         retValue=false;
 
+    //optional, added after the fields above
+    if(document.HasMember("plateCount"))
+        m_plateCount=document["plateCount"].GetInt();
+    if(document.HasMember("plateCountMin"))
+        m_plateCountMin=document["plateCountMin"].GetInt();
+    if(document.HasMember("plateCountMax"))
+        m_plateCountMax=document["plateCountMax"].GetInt();
+    if(document.HasMember("plateFrequency"))
+        m_plateFrequency=document["plateFrequency"].GetFloat();
+    if(document.HasMember("plateOctaves"))
+        m_plateOctaves=document["plateOctaves"].GetInt();
+    if(document.HasMember("plateLacunarity"))
+        m_plateLacunarity=document["plateLacunarity"].GetFloat();
+    if(document.HasMember("influenceGridSize"))
+    {
+        const rapidjson::Value &gridSize=document["influenceGridSize"];
+
+        if(gridSize.IsArray()&&(gridSize.Size()==2))
+        {
+            m_influenceGridSize.x=gridSize[0u].GetInt();
+            m_influenceGridSize.y=gridSize[1u].GetInt();
+        }
+    }
+    //optional, unknown names keep the default rather than failing the load
+    if(document.HasMember("simdLevel")&&document["simdLevel"].IsString())
+        parseSimdLevel(document["simdLevel"].GetString(), m_simdLevel);
+    if(document.HasMember("plateAssignment")&&document["plateAssignment"].IsString())
+        parsePlateAssignment(document["plateAssignment"].GetString(), m_plateAssignment);
+
     return retValue;
 }
 
@@ -60,12 +126,26 @@ bool EquiRectDescriptors::save(char *json, size_t &size)
 
     document.SetObject();
 
+    document.AddMember("seed", rapidjson::Value(seed).Move(), document.GetAllocator());
     document.AddMember("noiseScale", rapidjson::Value(m_noiseScale).Move(), document.GetAllocator());
     document.AddMember("continentFrequency", rapidjson::Value(m_continentFrequency).Move(), document.GetAllocator());
     document.AddMember("continentOctaves", rapidjson::Value(m_continentOctaves).Move(), document.GetAllocator());
     document.AddMember("continentLacunarity", rapidjson::Value(m_continentLacunarity).Move(), document.GetAllocator());
     document.AddMember("seaLevel", rapidjson::Value(m_seaLevel).Move(), document.GetAllocator());
     document.AddMember("continentalShelf", rapidjson::Value(m_continentalShelf).Move(), document.GetAllocator());
+    document.AddMember("plateCount", rapidjson::Value(m_plateCount).Move(), document.GetAllocator());
+    document.AddMember("plateCountMin", rapidjson::Value(m_plateCountMin).Move(), document.GetAllocator());
+    document.AddMember("plateCountMax", rapidjson::Value(m_plateCountMax).Move(), document.GetAllocator());
+    document.AddMember("plateFrequency", rapidjson::Value(m_plateFrequency).Move(), document.GetAllocator());
+    document.AddMember("plateOctaves", rapidjson::Value(m_plateOctaves).Move(), document.GetAllocator());
+    document.AddMember("plateLacunarity", rapidjson::Value(m_plateLacunarity).Move(), document.GetAllocator());
+
+    rapidjson::Value gridSize(rapidjson::kArrayType);
+
+    gridSize.PushBack(m_influenceGridSize.x, document.GetAllocator()).PushBack(m_influenceGridSize.y, document.GetAllocator());
+    document.AddMember("influenceGridSize", gridSize, document.GetAllocator());
+    document.AddMember("simdLevel", rapidjson::StringRef(simdLevelName(m_simdLevel)), document.GetAllocator());
+    document.AddMember("plateAssignment", rapidjson::StringRef(plateAssignmentName(m_plateAssignment)), document.GetAllocator());
 
     document.Accept(writer);
 
@@ -85,6 +165,139 @@ void EquiRectDescriptors::init(const WorldDescriptors &worldDescriptors)
     calculateInfluenceSize(worldDescriptors);
 }
 
+uint64_t EquiRectDescriptors::hash() const
+{
+    //field by field, hashing the struct bytes would pick up padding
+    Hash64 hash;
+
+    hash.add(seed);
+    hash.add(m_noiseScale);
+    hash.add(m_continentFrequency);
+    hash.add(m_continentOctaves);
+    hash.add(m_continentLacunarity);
+    hash.add(m_seaLevel);
+    hash.add(m_continentalShelf);
+    hash.add(m_plateCount);
+    hash.add(m_plateCountMin);
+    hash.add(m_plateCountMax);
+    hash.add(m_plateFrequency);
+    hash.add(m_plateOctaves);
+    hash.add(m_plateLacunarity);
+    hash.add(m_influenceSize.x).add(m_influenceSize.y);
+    hash.add(m_influenceGridSize.x).add(m_influenceGridSize.y);
+    //only seeded plates are added, noise plate worlds keep the keys they were cached with
+    if(m_plateAssignment!=PlateAssignment::Noise)
+        hash.add(m_plateAssignment);
+    //m_simdLevel is left out, it changes how fast the noise runs rather than what it produces
+    return hash.value();
+}
+
+void ShardManifest::partition(const glm::ivec2 &size, int worldSeed, int shardCount)
+{
+    influenceSize=size;
+    seed=worldSeed;
+
+    shardCount=std::max(std::min(shardCount, size.y), 1);
+
+    int rows=size.y/shardCount;
+    int extraRows=size.y%shardCount;
+    int rowBegin=0;
+
+    shards.resize(shardCount);
+    for(int i=0; i<shardCount; ++i)
+    {
+        int rowCount=rows+((i<extraRows)?1:0);
+
+        shards[i].index=i;
+        shards[i].rowBegin=rowBegin;
+        shards[i].rowEnd=rowBegin+rowCount;
+        rowBegin+=rowCount;
+    }
+}
+
+bool ShardManifest::load(const char *json)
+{
+    rapidjson::Document document;
+
+    document.Parse(json);
+
+    if(document.HasParseError()||!document.IsObject())
+        return false;
+
+    if(!document.HasMember("influenceSize")||!document.HasMember("seed")||!document.HasMember("shards"))
+        return false;
+
+    const rapidjson::Value &size=document["influenceSize"];
+    const rapidjson::Value &shardArray=document["shards"];
+
+    if(!size.IsArray()||(size.Size()!=2)||!shardArray.IsArray())
+        return false;
+
+    influenceSize.x=size[0u].GetInt();
+    influenceSize.y=size[1u].GetInt();
+    seed=document["seed"].GetInt();
+
+    shards.resize(shardArray.Size());
+    int nextRow=0;
+
+    for(rapidjson::SizeType i=0; i<shardArray.Size(); ++i)
+    {
+        const rapidjson::Value &shard=shardArray[i];
+
+        if(!shard.HasMember("rowBegin")||!shard.HasMember("rowEnd"))
+            return false;
+
+        shards[i].index=(int)i;
+        shards[i].rowBegin=shard["rowBegin"].GetInt();
+        shards[i].rowEnd=shard["rowEnd"].GetInt();
+
+        //shards have to tile the map in order for the merge to concatenate them
+        if((shards[i].rowBegin!=nextRow)||(shards[i].rowEnd<=shards[i].rowBegin))
+            return false;
+        nextRow=shards[i].rowEnd;
+    }
+
+    return (nextRow==influenceSize.y);
+}
+
+void ShardManifest::save(std::string &json) const
+{
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+
+    writer.StartObject();
+    writer.Key("influenceSize");
+    writer.StartArray();
+    writer.Int(influenceSize.x);
+    writer.Int(influenceSize.y);
+    writer.EndArray();
+    writer.Key("seed");
+    writer.Int(seed);
+    writer.Key("shards");
+    writer.StartArray();
+    for(const ShardRange &shard:shards)
+    {
+        writer.StartObject();
+        writer.Key("rowBegin");
+        writer.Int(shard.rowBegin);
+        writer.Key("rowEnd");
+        writer.Int(shard.rowEnd);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    json.assign(sb.GetString(), sb.GetSize());
+}
+
+std::string ShardManifest::shardFileName(int index)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "shard_%04d.bin", index);
+    return name;
+}
+
 //this is expecting cylindrical wrap
 std::vector<size_t> get2DCellNeighbors_eq(const glm::ivec2 &index, const glm::ivec2 &size)
 {
@@ -137,10 +350,55 @@ typedef std::chrono::high_resolution_clock clock;
 typedef std::chrono::high_resolution_clock::time_point time_point;
 typedef std::chrono::milliseconds ms;
 
-typedef FastNoise::CellularDistance::ReturnType CellularReturnType;
+//layers the generation stages declare as inputs/outputs
+enum GenerationLayerId:LayerId
+{
+    PositionsLayer,
+    HeightLayer,
+    TerrainScaleLayer,
+    NsAirCurrentLayer,
+    EwAirCurrentLayer,
+    PlateLayer,
+    BorderPlateLayer,
+    PlateDistanceLayer,
+    ContinentLayer,
+    InfluenceLayer,
+    LayerCount
+};
+
+//rows processed above and below each streamed band and then dropped, wrapping around the map as the
+//moisture sweep does (the first band's upper halo is the last rows of the map). The sweep moves moisture at
+//most one row up per loop (10 loops) and carries it down scaled by at most 0.5 per row, so what is cut off
+//at the halo changes moisture by less than 0.5^16 compared to a whole map generation.
+constexpr int StreamHaloRows=16;
+
+//map row of a band row, band rows outside the map are halo rows wrapped around it
+inline int wrapRow(int row, int rows)
+{
+    return ((row%rows)+rows)%rows;
+}
 
+//seeded plates: how far positions are pushed by the warp noise in seed spacings, and the warp noise
+//frequency relative to the plate frequency
+constexpr float PlateWarpAmplitude=0.3f;
+constexpr float PlateWarpFrequency=4.0f;
+
+//generation arena slots, all of them are fully written before being read
+enum ArenaSlot
+{
+    XPositionSlot,
+    YPositionSlot,
+    ZPositionSlot,
+    MoistureSlot,
+    MoistureDeltaSlot,
+    TectonicCurveSlot,
+    TectonicCurveScaleSlot,
+    PlateWarpXSlot,
+    PlateWarpYSlot,
+    PlateWarpZSlot,
+    ArenaSlotCount
+};
 
-thread_local ThreadStorage EquiRectWorldGenerator::m_threadStorage;
 
 //
 //std::vector<float> EquiRectWorldGenerator::heightMap;
@@ -164,26 +422,72 @@ thread_local ThreadStorage EquiRectWorldGenerator::m_threadStorage;
 //
 //std::unique_ptr<HastyNoise::VectorSet> EquiRectWorldGenerator::regionVectorSet;
 
+//one graph per noise stage, nothing is shared between them so stages never see each others settings
 class EquiRectWorldGenerator::Hidden
 {
 public:
-    Hidden()
+    Hidden():
+        m_plateSeedsKey(0)
     {}
 
-    FastNoise::SmartNode<FastNoise::OpenSimplex2> m_os2Noise;
+    void build(const EquiRectDescriptors &descriptors)
+    {
+        FastSIMD::eLevel simdLevel=(FastSIMD::eLevel)toFastSimdLevel(descriptors.m_simdLevel);
+
+        m_heightNoise=newFractalNoise(0.01f, false, simdLevel);
+        m_terrainScaleNoise=newFractalNoise(0.05f, false, simdLevel);
+        m_airCurrentNoise=newFractalNoise(0.01f, true, simdLevel);
+        m_plateNoise=newWarpedCellular(newCellularValue(0, simdLevel), descriptors.m_plateFrequency, simdLevel);
+        m_borderPlateNoise=newWarpedCellular(newCellularValue(1, simdLevel), descriptors.m_plateFrequency, simdLevel);
+        m_continentNoise=newWarpedCellular(newCellularValue(0, simdLevel), descriptors.m_continentFrequency, simdLevel);
+        m_plateWarpNoise=newFractalNoise(PlateWarpFrequency*descriptors.m_plateFrequency, false, simdLevel);
+    }
+
+    //seeds are only placed again when the count or seed changes
+    const PlateSeeds &plateSeeds(int count, int seed)
+    {
+        uint64_t key=Hash64().add(count).add(seed).value();
+
+        if(m_plateSeedsKey!=key)
+        {
+            m_plateSeeds.build((size_t)std::max(count, 1), seed, &ThreadPool::global());
+            m_plateSeedsKey=key;
+        }
+        return m_plateSeeds;
+    }
+
+    //level FastSIMD picked for the graphs, Auto until build
+    SimdLevel simdLevel() const
+    {
+        if(!m_heightNoise)
+            return SimdLevel::Auto;
+        return fromFastSimdLevel(m_heightNoise->GetSIMDLevel());
+    }
 
-    FastNoise::SmartNode<FastNoise::DomainScale> m_domainScale;
-    FastNoise::SmartNode<FastNoise::DomainWarpGradient> m_domainWarp;
-    FastNoise::SmartNode<FastNoise::DomainWarpFractalIndependant> m_domainWarpFractal;
-    FastNoise::SmartNode<FastNoise::FractalFBm> m_fractalFbmNoise;
+    FastNoise::SmartNode<> m_heightNoise;
+    FastNoise::SmartNode<> m_terrainScaleNoise;
+    FastNoise::SmartNode<> m_airCurrentNoise;
+    FastNoise::SmartNode<> m_plateNoise;
+    FastNoise::SmartNode<> m_borderPlateNoise;
+    FastNoise::SmartNode<> m_continentNoise;
+    FastNoise::SmartNode<> m_plateWarpNoise;
 
-    FastNoise::SmartNode<FastNoise::CellularValue> m_cellularNoise;
-    FastNoise::SmartNode<FastNoise::CellularDistance> m_cellularDistanceNoise;
+    PlateSeeds m_plateSeeds;
+    uint64_t m_plateSeedsKey;
 };
 
-EquiRectWorldGenerator::EquiRectWorldGenerator()
+EquiRectWorldGenerator::EquiRectWorldGenerator():
+    m_arena(ArenaSlotCount),
+    m_xPositions(nullptr),
+    m_yPositions(nullptr),
+    m_zPositions(nullptr),
+    m_positionCount(0),
+    m_ready(true),
+    m_layerRetention(LayerRetention::All),
+    m_streamBandRows(0)
 {
     m_hidden.reset(new Hidden());
+    invalidateStageCache();
 
     m_plateCount=16;
 //    initNoise();//make sure noise dlls are loaded
@@ -191,19 +495,38 @@ EquiRectWorldGenerator::EquiRectWorldGenerator()
 
 
 EquiRectWorldGenerator::~EquiRectWorldGenerator()
-{}
+{
+    //background tasks reference this generator (load) or need to finish writing (save)
+    waitReady();
+
+    std::unique_lock<std::mutex> lock(m_taskMutex);
+
+    for(std::shared_future<bool> &task:m_saveTasks)
+        task.wait();
+}
 
 
-void EquiRectWorldGenerator::create(WorldDescriptors *descriptors, Progress &progress)
+bool EquiRectWorldGenerator::create(WorldDescriptors *descriptors, Progress &progress)
 {
+    WORLDGEN_TRACE_ZONE("create");
+
     initialize(descriptors);
-    generateWorldOverview(progress);
+
+    if(!generateWorldOverview(progress))
+        return false;
+
+    progress.update(Stage::Neighbors, 80);
+    updateInfluenceNeighbors();
+    progress.update(Stage::Complete, 100, true);
+    return true;
 }
 
 
 void EquiRectWorldGenerator::initialize(WorldDescriptors *descriptors)
 {
     m_descriptors=*descriptors;
+    //loads replace the influence map without going through the stages
+    invalidateStageCache();
 
     bool loaded=m_descriptorValues.load(m_descriptors.getGeneratorArgs().c_str());
 
@@ -219,6 +542,9 @@ void EquiRectWorldGenerator::initialize(WorldDescriptors *descriptors)
     //    assert(m_descriptors!=nullptr);
 //    assert(m_descriptors.getChunkSize() == glm::ivec3(ChunkType::sizeX::value, ChunkType::sizeY::value, ChunkType::sizeZ::value));
     int seed=m_descriptorValues.seed;
+
+    m_continentSeed=seed;
+    m_plateSeed=seed+2;
 //    m_simdLevel=HastyNoise::GetFastestSIMD();
 
 //    m_continentPerlin=HastyNoise::CreateNoise(seed, m_simdLevel);
@@ -242,18 +568,6 @@ void EquiRectWorldGenerator::initialize(WorldDescriptors *descriptors)
 //
 //    m_cellularNoise->SetNoiseType(HastyNoise::NoiseType::Cellular);
 
-    m_hidden->m_os2Noise=FastNoise::New<FastNoise::OpenSimplex2>();
-
-    m_hidden->m_domainScale=FastNoise::New<FastNoise::DomainScale>();
-    m_hidden->m_domainWarp=FastNoise::New<FastNoise::DomainWarpGradient>();
-    m_hidden->m_domainWarpFractal=FastNoise::New<FastNoise::DomainWarpFractalIndependant>();
-    m_hidden->m_fractalFbmNoise=FastNoise::New<FastNoise::FractalFBm>();
-
-    m_hidden->m_cellularNoise=FastNoise::New<FastNoise::CellularValue>();
-    m_hidden->m_cellularDistanceNoise=FastNoise::New<FastNoise::CellularDistance>();
-
-    FastSIMD::eLevel simdLevel=m_hidden->m_cellularNoise->GetSIMDLevel();
-
     std::default_random_engine generator(seed);
     std::uniform_int_distribution<int> plateDistribution(m_descriptorValues.m_plateCountMin, m_descriptorValues.m_plateCountMax);
 
@@ -298,22 +612,51 @@ void EquiRectWorldGenerator::saveDescriptors(std::string &descriptors)
 template<typename _FileIO>
 bool EquiRectWorldGenerator::load(WorldDescriptors *descriptors, const std::string &directory, Progress &progress)
 {
+    WORLDGEN_TRACE_ZONE("load");
+
+    waitReady();
+
+    initialize(descriptors);
+    return loadOverview<_FileIO>(directory, progress, false);
+}
+
+
+template<typename _FileIO>
+bool EquiRectWorldGenerator::loadOverview(const std::string &directory, Progress &progress, bool buildPreview)
+{
+    WORLDGEN_TRACE_ZONE("loadOverview");
+
     typedef generic::io::fs<_FileIO> fs;
     std::string overviewFileName=directory+"/overview.bin";
 
     bool loaded=false;
 
-    initialize(descriptors);
+    progress.update(Stage::Loading, 0);
     if(fs::exists(overviewFileName))
         loaded=loadWorldOverview<_FileIO>(overviewFileName);
 
     if(!loaded)
     {
-        generateWorldOverview(progress);
+        if(buildPreview)
+        {
+            progress.update(Stage::Preview, 0);
+            //the preview reports the cancel, the maps of the previous world are not served for this one
+            if(!generatePreview(progress))
+            {
+                releaseGeneration();
+                return false;
+            }
+        }
+
+        if(!generateWorldOverview(progress))
+            return false;
+        progress.update(Stage::Neighbors, 80);
+        updateInfluenceNeighbors();
+        progress.update(Stage::Complete, 100, true);
         return false;
     }
     
-    progress.update("Normalize neighbors", 80, false);
+    progress.update(Stage::Neighbors, 80);
 
     std::string normalizeFileName=directory+"/normalize.bin";
 
@@ -325,482 +668,1294 @@ bool EquiRectWorldGenerator::load(WorldDescriptors *descriptors, const std::stri
     if(!normlizeLoaded)
     {
         updateInfluenceNeighbors();
-        saveNormalize<_FileIO>(normalizeFileName);
+        saveNormalize<_FileIO>(normalizeFileName, m_influenceNeighborMap);
+        progress.update(Stage::Complete, 100, true);
         return false;
     }
 
-    progress.update("Generating complete", 90, false);
+    //the neighbor map came from the file, the plate index is not stored
+    updatePlateIndex();
+    progress.update(Stage::Complete, 100, true);
 
     return true;
 }
 
 
 template<typename _FileIO>
-void EquiRectWorldGenerator::save(const std::string &directory)
+bool EquiRectWorldGenerator::save(const std::string &directory)
 {
-    typedef generic::io::fs<_FileIO> fs;
+    WORLDGEN_TRACE_ZONE("save");
 
-    if(!fs::exists(directory))
-        fs::create_directory(directory);
+    return writeOverview<_FileIO>(directory, m_descriptorValues.m_influenceSize, cacheKey(), m_influenceMap, m_influenceNeighborMap);
+}
 
-    std::string overviewFileName=directory+"/overview.bin";
 
-    saveWorldOverview<_FileIO>(overviewFileName);
+bool EquiRectWorldGenerator::loadOrCreate(WorldDescriptors *descriptors, WorldCache &cache, Progress &progress, bool *cacheHit)
+{
+    WORLDGEN_TRACE_ZONE("loadOrCreate");
+
+    typedef generic::io::fs<StdFileIO> fs;
+
+    waitReady();
+
+    initialize(descriptors);
+
+    uint64_t key=cacheKey();
+    std::string directory=cache.find(key);
+
+    if(cacheHit)
+        *cacheHit=false;
+
+    if(!directory.empty())
+    {
+        progress.update(Stage::Loading, 0);
+
+        if(loadWorldOverview<StdFileIO>(directory+"/overview.bin"))
+        {
+            progress.update(Stage::Neighbors, 80);
+
+            if(!loadNormalize<StdFileIO>(directory+"/normalize.bin"))
+                updateInfluenceNeighbors();
+            else
+                updatePlateIndex();
+
+            if(cacheHit)
+                *cacheHit=true;
+            progress.update(Stage::Complete, 100, true);
+            return true;
+        }
+    }
+
+    if(!generateWorldOverview(progress))
+        return false;
+
+    progress.update(Stage::Neighbors, 80);
+    updateInfluenceNeighbors();
+
+    progress.update(Stage::Saving, 90);
+
+    //the descriptors are only for inspecting the cache, the key is what identifies the entry
+    std::string staging=cache.stage(key);
+    std::string descriptorsJson;
+
+    saveDescriptors(descriptorsJson);
+
+    bool saved=save<StdFileIO>(staging);
+
+    if(saved)
+    {
+        typename fs::Type *file=fs::open(staging+"/descriptors.json", "wb");
+
+        if(file)
+        {
+            fs::write(descriptorsJson.data(), 1, descriptorsJson.size(), file);
+            fs::close(file);
+        }
+        cache.publish(key, staging);
+    }
+    else
+        cache.abandon(staging);
+
+    progress.update(Stage::Complete, 100, true);
+    return true;
 }
 
 
-void EquiRectWorldGenerator::generateWorldOverview(Progress &progress)
+uint64_t EquiRectWorldGenerator::cacheKey() const
 {
-
-    generatePlates(progress);
-    //    generateContinents();
+    const glm::ivec3 &size=m_descriptors.getSize();
+    Hash64 hash;
+
+    hash.add(EquiRectWorldFormatVersion);
+    hash.add(std::string(typeName()));
+    hash.add(size.x).add(size.y).add(size.z);
+    hash.add(m_descriptorValues.hash());
+    //mapgen changes these without going through the descriptors
+    hash.add(m_plateSeed).add(m_continentSeed);
+    return hash.value();
 }
 
 
 template<typename _FileIO>
-bool EquiRectWorldGenerator::loadWorldOverview(const std::string &fileName)
+std::shared_future<bool> EquiRectWorldGenerator::loadAsync(WorldDescriptors *descriptors, const std::string &directory, Progress &progress)
 {
-    typedef generic::io::fs<_FileIO> fs;
+    //only one load in flight, the previous one owns the maps until it completes
+    waitReady();
+
+    initialize(descriptors);
 
-    fs::Type *file=fs::open(fileName, "rb");
+    //The task is stored before anyone can see m_ready cleared. waitReady takes the same lock, so a caller
+    //that finds the generator not ready always gets this task and never an old or empty future.
+    std::unique_lock<std::mutex> lock(m_taskMutex);
 
-    if(!file)
-        return false;
+    std::atomic_store(&m_preview, std::shared_ptr<const OverviewPreview>());
+    m_ready.store(false, std::memory_order_release);
 
-    EquiRectWorldGeneratorHeader header;
-    
-    size_t readSize=fs::read(&header, 1, sizeof(EquiRectWorldGeneratorHeader), file);
+    m_loadTask=std::async(std::launch::async, [this, directory, &progress]()
+        {
+            bool loaded=loadOverview<_FileIO>(directory, progress, true);
 
-    if(readSize != sizeof(EquiRectWorldGeneratorHeader))
-        return false;
+            //set even when cancelled so waiters are released, getBaseHeight checks for the empty maps
+            m_ready.store(true, std::memory_order_release);
+            return loaded;
+        }).share();
 
-    if(header.marker != EquiRectWorldGeneratorHeader_Marker)
-        return false;
+    return m_loadTask;
+}
 
-    if(header.cellSize!=sizeof(InfluenceCell))
-        return false;
 
-    size_t influenceMapSize=header.x*header.y;
+template<typename _FileIO>
+std::shared_future<bool> EquiRectWorldGenerator::saveAsync(const std::string &directory)
+{
+    waitReady();
 
-    if(header.size!=influenceMapSize*sizeof(InfluenceCell))
-        return false;
+    //copy on the calling thread so the generator can keep serving while the write happens
+    std::shared_ptr<OverviewPreview> neighbors=std::make_shared<OverviewPreview>();
+    std::shared_ptr<InfluenceMap> influenceMap=std::make_shared<InfluenceMap>(m_influenceMap);
 
-    m_influenceMap.resize(influenceMapSize);
+    neighbors->influenceSize=m_descriptorValues.m_influenceSize;
+    neighbors->influenceGridSize=m_descriptorValues.m_influenceGridSize;
+    neighbors->influenceNeighborMap=m_influenceNeighborMap;
 
-    readSize=fs::read(m_influenceMap.data(), sizeof(InfluenceCell), influenceMapSize, file);
-    fs::close(file);
+    uint64_t descriptorKey=cacheKey();
 
-    return (readSize == influenceMapSize);
+    std::shared_future<bool> task=std::async(std::launch::async, [directory, descriptorKey, neighbors, influenceMap]()
+        {
+            return writeOverview<_FileIO>(directory, neighbors->influenceSize, descriptorKey, *influenceMap, neighbors->influenceNeighborMap);
+        }).share();
+
+    std::unique_lock<std::mutex> lock(m_taskMutex);
+
+    //drop completed saves, pending ones are waited on in the destructor
+    m_saveTasks.erase(std::remove_if(m_saveTasks.begin(), m_saveTasks.end(), [](const std::shared_future<bool> &saveTask)
+        {
+            return saveTask.wait_for(std::chrono::seconds(0))==std::future_status::ready;
+        }), m_saveTasks.end());
+    m_saveTasks.push_back(task);
+
+    return task;
 }
 
 
 template<typename _FileIO>
-void EquiRectWorldGenerator::saveWorldOverview(const std::string &fileName)
+bool EquiRectWorldGenerator::writeOverview(const std::string &directory, const glm::ivec2 &influenceSize, uint64_t descriptorKey, const InfluenceMap &influenceMap, const std::vector<float> &influenceNeighborMap)
 {
     typedef generic::io::fs<_FileIO> fs;
 
-    fs::Type *file=fs::open(fileName, "wb");
+    if(!fs::exists(directory))
+        fs::create_directory(directory);
 
-    if(!file)
-        return;
+    std::string overviewFileName=directory+"/overview.bin";
 
-    EquiRectWorldGeneratorHeader header;
+    if(!saveWorldOverview<_FileIO>(overviewFileName, influenceSize, descriptorKey, influenceMap))
+        return false;
 
-    header.marker=EquiRectWorldGeneratorHeader_Marker;
-    header.version=1;
-    header.x=m_descriptorValues.m_influenceSize.x;
-    header.y=m_descriptorValues.m_influenceSize.y;
-    header.cellSize=sizeof(InfluenceCell);
-    header.size=header.x*header.y*sizeof(InfluenceCell);
+    if(influenceNeighborMap.empty())
+        return true;
+
+    std::string normalizeFileName=directory+"/normalize.bin";
 
-    assert(m_influenceMap.size()==(header.x*header.y));
+    return saveNormalize<_FileIO>(normalizeFileName, influenceNeighborMap);
+}
 
-    fs::write(&header, sizeof(EquiRectWorldGeneratorHeader), 1, file);
-    fs::write(m_influenceMap.data(), sizeof(InfluenceCell), m_influenceMap.size(), file);
-    fs::close(file);
+
+//file order of the shard layers, see ShardLayerCount
+void getShardLayers(GenerationLayers &generationLayers, LayerBuffer *layers[ShardLayerCount])
+{
+    layers[0]=&generationLayers.heightMap;
+    layers[1]=&generationLayers.terrainScale;
+    layers[2]=&generationLayers.nsAirCurrent;
+    layers[3]=&generationLayers.ewAirCurrent;
+    layers[4]=&generationLayers.plateMap;
+    layers[5]=&generationLayers.plate2Map;
+    layers[6]=&generationLayers.continentMap;
 }
 
 
 template<typename _FileIO>
-bool EquiRectWorldGenerator::loadNormalize(const std::string &fileName)
+bool EquiRectWorldGenerator::generateShard(const ShardRange &range, const std::string &directory, Progress &progress)
 {
+    WORLDGEN_TRACE_ZONE("generateShard");
+
     typedef generic::io::fs<_FileIO> fs;
 
-    fs::Type *file=fs::open(fileName, "rb");
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
 
-    if(!file)
+    if((range.rowBegin<0)||(range.rowEnd>influenceSize.y)||(range.rowBegin>=range.rowEnd))
         return false;
 
-    NormalizeHeader header;
+    if(!generateNoiseLayers(range.rowBegin, range.rowEnd, progress))
+    {
+        releaseGeneration();
+        progress.update(Stage::Cancelled, 0, true);
+        return false;
+    }
 
-    size_t readSize=fs::read(&header, 1, sizeof(NormalizeHeader), file);
+    progress.update(Stage::Saving, 90);
 
-    if(readSize != sizeof(NormalizeHeader))
-        return false;
+    if(!fs::exists(directory))
+        fs::create_directory(directory);
+
+    std::string fileName=directory+"/"+ShardManifest::shardFileName(range.index);
+    typename fs::Type *file=fs::open(fileName, "wb");
 
-    if(header.marker != EquiRectWorldGeneratorHeader_Marker)
+    if(!file)
         return false;
 
-    m_influenceNeighborMap.resize(header.size);
+    LayerBuffer *layers[ShardLayerCount];
 
-    readSize=fs::read(m_influenceNeighborMap.data(), sizeof(float), header.size, file);
+    getShardLayers(m_layers, layers);
+    size_t bandSize=(size_t)influenceSize.x*(range.rowEnd-range.rowBegin);
+
+    ShardHeader header;
+
+    header.marker=EquiRectWorldGeneratorHeader_Marker;
+    header.version=EquiRectWorldFormatVersion;
+    header.descriptorKey=cacheKey();
+    header.index=range.index;
+    header.rowBegin=range.rowBegin;
+    header.rowEnd=range.rowEnd;
+    header.width=influenceSize.x;
+    header.layerCount=ShardLayerCount;
+    header.size=bandSize*ShardLayerCount*sizeof(float);
+
+    bool written=(fs::write(&header, sizeof(ShardHeader), 1, file)==1);
+
+    for(size_t i=0; written&&(i<ShardLayerCount); ++i)
+        written=(fs::write(layers[i]->data(), sizeof(float), bandSize, file)==bandSize);
     fs::close(file);
 
-    return (readSize == header.size);
+    releaseGeneration();
+    progress.update(Stage::Complete, 100, true);
+    return written;
 }
 
 
 template<typename _FileIO>
-void EquiRectWorldGenerator::saveNormalize(const std::string &fileName)
+bool EquiRectWorldGenerator::mergeShards(const ShardManifest &manifest, const std::string &directory, Progress &progress)
 {
+    WORLDGEN_TRACE_ZONE("mergeShards");
+
     typedef generic::io::fs<_FileIO> fs;
 
-    fs::Type *file=fs::open(fileName, "wb");
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
 
-    if(!file)
-        return;
+    //a manifest built for other descriptors would concatenate into the wrong world
+    if((manifest.influenceSize!=influenceSize)||(manifest.seed!=m_descriptorValues.seed))
+        return false;
 
-    NormalizeHeader header;
+    size_t mapSize=(size_t)influenceSize.x*influenceSize.y;
+    LayerBuffer *layers[ShardLayerCount];
 
-    header.marker=EquiRectWorldGeneratorHeader_Marker;
-    header.version=1;
-    header.size=m_influenceNeighborMap.size();
+    getShardLayers(m_layers, layers);
+    //layers come from the shards, nothing cached from a previous generation applies
+    invalidateStageCache();
 
-    fs::write(&header, sizeof(NormalizeHeader), 1, file);
-    fs::write(m_influenceNeighborMap.data(), sizeof(float), m_influenceNeighborMap.size(), file);
-    fs::close(file);
+    StageGraph graph;
+
+    //shards carry no plate distance, a band only sees the borders inside its rows so it is measured over the
+    //merged plates
+    graph.add("loadShards", {}, {HeightLayer, TerrainScaleLayer, NsAirCurrentLayer, EwAirCurrentLayer, PlateLayer, BorderPlateLayer, ContinentLayer},
+        [&]()
+        {
+            progress.update(Stage::Loading, 0);
+
+            for(size_t i=0; i<ShardLayerCount; ++i)
+                layers[i]->resize(mapSize);
+
+            for(const ShardRange &range:manifest.shards)
+            {
+                if(progress.cancelled())
+                    return false;
+
+                std::string fileName=directory+"/"+ShardManifest::shardFileName(range.index);
+                typename fs::Type *file=fs::open(fileName, "rb");
+
+                if(!file)
+                    return false;
+
+                size_t bandSize=(size_t)influenceSize.x*(range.rowEnd-range.rowBegin);
+                size_t offset=(size_t)influenceSize.x*range.rowBegin;
+                ShardHeader header;
+
+                bool valid=(fs::read(&header, 1, sizeof(ShardHeader), file)==sizeof(ShardHeader));
+
+                valid=valid&&(header.marker==EquiRectWorldGeneratorHeader_Marker);
+                valid=valid&&(header.version==EquiRectWorldFormatVersion);
+                valid=valid&&(header.descriptorKey==cacheKey())&&(header.index==(unsigned int)range.index);
+                valid=valid&&(header.rowBegin==(unsigned int)range.rowBegin)&&(header.rowEnd==(unsigned int)range.rowEnd);
+                valid=valid&&(header.width==(unsigned int)influenceSize.x)&&(header.layerCount==ShardLayerCount);
+
+                for(size_t i=0; valid&&(i<ShardLayerCount); ++i)
+                    valid=(fs::read(layers[i]->data()+offset, sizeof(float), bandSize, file)==bandSize);
+                fs::close(file);
+
+                if(!valid)
+                    return false;
+
+                progress.update(Stage::Loading, 40*range.rowEnd/influenceSize.y);
+            }
+            return true;
+        });
+    graph.add("plateDistance", {PlateLayer}, {PlateDistanceLayer}, [this, &influenceSize, &progress]()
+        {
+            return generatePlateDistance(0, influenceSize.y, nullptr, progress);
+        });
+    graph.add("processing", {HeightLayer, TerrainScaleLayer, NsAirCurrentLayer, EwAirCurrentLayer, PlateLayer, BorderPlateLayer, PlateDistanceLayer, ContinentLayer},
+        {InfluenceLayer}, [this, &progress]() { return processPlates(progress); });
+
+    bool complete=graph.run(nullptr);
+
+    m_stageTimings=graph.timings();
+
+    if(!complete)
+    {
+        releaseGeneration();
+        if(progress.cancelled())
+            progress.update(Stage::Cancelled, 0, true);
+        return false;
+    }
+
+    applyLayerRetention();
+
+    progress.update(Stage::Neighbors, 80);
+    updateInfluenceNeighbors();
+    progress.update(Stage::Complete, 100, true);
+    return true;
 }
 
 
-void EquiRectWorldGenerator::generatePlates(Progress &progress)
+bool EquiRectWorldGenerator::waitReady(std::chrono::milliseconds timeout)
 {
+    std::shared_future<bool> task;
 
-    std::vector<WeatherCell> weatherCells=
     {
-//        {"South Polar Cell"  , rads(-75.0f), rads(30.0f), 0.65f, { 0.0f,  1.0f}, {-1.0f,  0.0f}},
-//        {"South Ferrell Cell", rads(-45.0f), rads(30.0f), 0.75f , { 1.0f,  0.0f}, { 0.0f, -1.0f}},
-//        {"South Hadley Cell" , rads(-15.0f), rads(30.0f), 0.95f , { 0.0f,  1.0f}, {-1.0f,  0.0f}},
-//        {"Noth Hadley Cell"  , rads(15.0f) , rads(30.0f), 0.95f , {-1.0f,  0.0f}, { 0.0f, -1.0f}},
-//        {"North Ferrell Cell", rads(45.0f) , rads(30.0f), 0.74f , { 0.0f,  1.0f}, { 1.0f,  0.0f}},
-//        {"North Polar Cell"  , rads(75.0f) , rads(30.0f), 0.65f, {-1.0f,  0.0f}, { 0.0f, -1.0f}}
-        {"South Polar Cell"  , rads(-90.0f), rads(-60.0f), 0.65f, { 0.0f,  1.0f}, {-1.0f,  0.0f}},
-        {"South Ferrell Cell", rads(-60.0f), rads(-30.0f), 0.75f , { 1.0f,  0.0f}, { 0.0f, -1.0f}},
-        {"South Hadley Cell" , rads(-30.0f), rads(0.0f), 0.95f , { 0.0f,  1.0f}, {-1.0f,  0.0f}},
-        {"Noth Hadley Cell"  , rads(0.0f) , rads(30.0f), 0.95f , {-1.0f,  0.0f}, { 0.0f, -1.0f}},
-        {"North Ferrell Cell", rads(30.0f) , rads(60.0f), 0.74f , { 0.0f,  1.0f}, { 1.0f,  0.0f}},
-        {"North Polar Cell"  , rads(60.0f) , rads(90.0f), 0.65f, {-1.0f,  0.0f}, { 0.0f, -1.0f}}
+        std::unique_lock<std::mutex> lock(m_taskMutex);
+        task=m_loadTask;
+    }
 
-    };
+    if(task.valid())
+        task.wait_for(timeout);
 
+    return isReady();
+}
+
+
+void EquiRectWorldGenerator::waitReady()
+{
+    std::shared_future<bool> task;
+
+    {
+        std::unique_lock<std::mutex> lock(m_taskMutex);
+        task=m_loadTask;
+    }
+
+    if(task.valid())
+        task.wait();
+}
+
+
+bool EquiRectWorldGenerator::generatePreview(Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("generatePreview");
+
+    //same world at a fraction of the influence resolution, frequencies scale with the sphere radius
+    EquiRectWorldGenerator previewGenerator;
+
+    previewGenerator.initialize(&m_descriptors);
+    previewGenerator.m_plateSeed=m_plateSeed;
+    previewGenerator.m_continentSeed=m_continentSeed;
+    previewGenerator.m_plateCount=m_plateCount;
+
+    EquiRectDescriptors &previewDescriptors=previewGenerator.m_descriptorValues;
+
+    previewDescriptors=m_descriptorValues;
+    previewDescriptors.m_influenceSize=glm::max(m_descriptorValues.m_influenceSize/PreviewScale, glm::ivec2(1, 1));
+    previewDescriptors.m_influenceGridSize=m_descriptorValues.m_influenceGridSize*PreviewScale;
+    previewDescriptors.m_plateFrequency=m_descriptorValues.m_plateFrequency*PreviewScale;
+    previewDescriptors.m_continentFrequency=m_descriptorValues.m_continentFrequency*PreviewScale;
+
+    if(!previewGenerator.generateWorldOverview(progress))
+        return false;
+    previewGenerator.updateInfluenceNeighbors();
+
+    std::shared_ptr<OverviewPreview> preview=std::make_shared<OverviewPreview>();
+
+    preview->influenceSize=previewDescriptors.m_influenceSize;
+    preview->influenceGridSize=previewDescriptors.m_influenceGridSize;
+    preview->influenceNeighborMap=std::move(previewGenerator.m_influenceNeighborMap);
+
+    std::atomic_store(&m_preview, std::shared_ptr<const OverviewPreview>(preview));
+    return true;
+}
+
+
+bool EquiRectWorldGenerator::generateWorldOverview(Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("generateWorldOverview");
+
+    if(!generatePlates(progress))
+    {
+        releaseGeneration();
+        progress.update(Stage::Cancelled, 0, true);
+        return false;
+    }
+    //    generateContinents();
+
+    applyLayerRetention();
+    return true;
+}
+
+
+size_t EquiRectWorldGenerator::estimateGenerationMemory() const
+{
+    //float layers plus the arena positions and moisture buffers, seeded plates add the warped positions
+    const size_t layerCount=(m_descriptorValues.m_plateAssignment==PlateAssignment::Seeded)?18:15;
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
+    size_t mapSize=(size_t)influenceSize.x*influenceSize.y;
+    size_t outputSize=mapSize*(sizeof(InfluenceCell)+NeighborCount*sizeof(float));
+
+    if(m_streamBandRows>0)
+    {
+        //working set is one band plus halo, with its own influence cells before they are copied out
+        size_t bandSize=(size_t)influenceSize.x*std::min(m_streamBandRows+2*StreamHaloRows, influenceSize.y);
+
+        return outputSize+bandSize*(layerCount*sizeof(float)+sizeof(InfluenceCell));
+    }
+    return outputSize+mapSize*layerCount*sizeof(float);
+}
+
+
+size_t EquiRectWorldGenerator::estimateShardMemory(const ShardRange &range) const
+{
+    //noise layers plus the x/y/z positions for the shard rows, and the warped positions for seeded plates
+    size_t mapSize=(size_t)m_descriptorValues.m_influenceSize.x*(range.rowEnd-range.rowBegin);
+    size_t positionCount=(m_descriptorValues.m_plateAssignment==PlateAssignment::Seeded)?6:3;
+
+    return mapSize*(ShardLayerCount+positionCount)*sizeof(float);
+}
+
+
+GenerationLayers EquiRectWorldGenerator::takeLayers()
+{
+    GenerationLayers layers;
+
+    std::swap(layers, m_layers);
+    invalidateStageCache();
+    return layers;
+}
+
+
+void EquiRectWorldGenerator::releaseGeneration()
+{
+    //swap with empties so the memory is actually returned
+    m_layers=GenerationLayers();
+    invalidateStageCache();
+    m_arena.release();
+    m_xPositions=nullptr;
+    m_yPositions=nullptr;
+    m_zPositions=nullptr;
+    m_positionCount=0;
+    InfluenceMap().swap(m_influenceMap);
+    std::vector<float>().swap(m_influenceNeighborMap);
+    m_plateIndex.clear();
+
+    m_plateCount=0;
+}
+
+
+void releaseLayer(LayerBuffer &layer)
+{
+    LayerBuffer().swap(layer);
+}
+
+
+void EquiRectWorldGenerator::applyLayerRetention()
+{
+    if(m_layerRetention==LayerRetention::All)
+        return;
+
+    //nothing the viewer shows, dropping these only costs the stage cache for them
+    releaseLayer(m_layers.terrainScale);
+    releaseLayer(m_layers.nsAirCurrent);
+    releaseLayer(m_layers.ewAirCurrent);
+    m_layerKeys[TerrainScaleLayer]=0;
+    m_layerKeys[NsAirCurrentLayer]=0;
+    m_layerKeys[EwAirCurrentLayer]=0;
+
+    m_arena.release();
+    m_xPositions=nullptr;
+    m_yPositions=nullptr;
+    m_zPositions=nullptr;
+    m_positionCount=0;
+    m_layerKeys[PositionsLayer]=0;
+
+    if(m_layerRetention==LayerRetention::Debug)
+        return;
+
+    releaseLayer(m_layers.heightMap);
+    releaseLayer(m_layers.plateMap);
+    releaseLayer(m_layers.plate2Map);
+    releaseLayer(m_layers.plateDistance);
+    releaseLayer(m_layers.continentMap);
+    releaseLayer(m_layers.plateScaleMap);
+    releaseLayer(m_layers.plate2ScaleMap);
+    //the scale maps belong to the influence stage, a later generation has to rerun all of it
+    invalidateStageCache();
+}
+
+
+std::vector<LayerMemory> EquiRectWorldGenerator::getMemoryUsage() const
+{
+    auto layerBytes=[](const LayerBuffer &layer) { return layer.capacity()*sizeof(float); };
+
+    return
+    {
+        {"height", layerBytes(m_layers.heightMap)},
+        {"terrainScale", layerBytes(m_layers.terrainScale)},
+        {"nsAirCurrent", layerBytes(m_layers.nsAirCurrent)},
+        {"ewAirCurrent", layerBytes(m_layers.ewAirCurrent)},
+        {"plates", layerBytes(m_layers.plateMap)},
+        {"borderPlates", layerBytes(m_layers.plate2Map)},
+        {"plateDistance", layerBytes(m_layers.plateDistance)},
+        {"continents", layerBytes(m_layers.continentMap)},
+        {"plateScale", layerBytes(m_layers.plateScaleMap)},
+        {"borderPlateScale", layerBytes(m_layers.plate2ScaleMap)},
+        {"arena", m_arena.reservedBytes()},
+        {"influenceMap", m_influenceMap.capacity()*sizeof(InfluenceCell)},
+        {"influenceNeighbors", m_influenceNeighborMap.capacity()*sizeof(float)}
+    };
+}
+
+
+SimdLevel EquiRectWorldGenerator::getSimdLevel() const
+{
+    return m_hidden->simdLevel();
+}
+
+
+bool EquiRectWorldGenerator::generateNoise(const FastNoise::Generator *node, float *output, int seed, Progress &progress) const
+{
+    WORLDGEN_TRACE_ZONE("generateNoise");
+
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
+    //positions only cover the rows being generated when running a shard
+    size_t mapSize=m_positionCount;
+    size_t bandSize=(size_t)influenceSize.x*std::max(1, CancelBandPoints/influenceSize.x);
+
+    //noise is per position so generating in row bands is identical to a single pass
+    for(size_t start=0; start<mapSize; start+=bandSize)
+    {
+        if(progress.cancelled())
+            return false;
+
+        int count=(int)std::min(bandSize, mapSize-start);
+
+        node->GenPositionArray3D(output+start, count, m_xPositions+start, m_yPositions+start, m_zPositions+start,
+            0.0f, 0.0f, 0.0f, seed);
+    }
+    return true;
+}
+
+
+template<typename _FileIO>
+bool EquiRectWorldGenerator::loadWorldOverview(const std::string &fileName)
+{
+    typedef generic::io::fs<_FileIO> fs;
+
+    typename fs::Type *file=fs::open(fileName, "rb");
+
+    if(!file)
+        return false;
+
+    EquiRectWorldGeneratorHeader header;
+    
+    size_t readSize=fs::read(&header, 1, sizeof(EquiRectWorldGeneratorHeader), file);
+    bool valid=(readSize == sizeof(EquiRectWorldGeneratorHeader));
+
+    valid=valid&&(header.marker == EquiRectWorldGeneratorHeader_Marker);
+    valid=valid&&(header.version == EquiRectWorldFormatVersion);
+    //written for other descriptors, regenerate rather than serve a stale world
+    valid=valid&&(header.descriptorKey == cacheKey());
+    valid=valid&&(header.cellSize==sizeof(InfluenceCell));
+
+    size_t influenceMapSize=(size_t)header.x*header.y;
+
+    valid=valid&&(header.size==influenceMapSize*sizeof(InfluenceCell));
+
+    if(!valid)
+    {
+        fs::close(file);
+        return false;
+    }
+
+    m_influenceMap.resize(influenceMapSize);
+
+    readSize=fs::read(m_influenceMap.data(), sizeof(InfluenceCell), influenceMapSize, file);
+    fs::close(file);
+
+    return (readSize == influenceMapSize);
+}
+
+
+template<typename _FileIO>
+bool EquiRectWorldGenerator::saveWorldOverview(const std::string &fileName, const glm::ivec2 &influenceSize, uint64_t descriptorKey, const InfluenceMap &influenceMap)
+{
+    typedef generic::io::fs<_FileIO> fs;
+
+    typename fs::Type *file=fs::open(fileName, "wb");
+
+    if(!file)
+        return false;
+
+    EquiRectWorldGeneratorHeader header;
+
+    header.marker=EquiRectWorldGeneratorHeader_Marker;
+    header.version=EquiRectWorldFormatVersion;
+    header.x=influenceSize.x;
+    header.y=influenceSize.y;
+    header.cellSize=sizeof(InfluenceCell);
+    header.size=header.x*header.y*sizeof(InfluenceCell);
+    header.descriptorKey=descriptorKey;
+
+    assert(influenceMap.size()==(header.x*header.y));
+
+    fs::write(&header, sizeof(EquiRectWorldGeneratorHeader), 1, file);
+    size_t written=fs::write(influenceMap.data(), sizeof(InfluenceCell), influenceMap.size(), file);
+    fs::close(file);
+
+    return (written==influenceMap.size());
+}
+
+
+template<typename _FileIO>
+bool EquiRectWorldGenerator::loadNormalize(const std::string &fileName)
+{
+    typedef generic::io::fs<_FileIO> fs;
+
+    typename fs::Type *file=fs::open(fileName, "rb");
+
+    if(!file)
+        return false;
+
+    NormalizeHeader header;
+
+    size_t readSize=fs::read(&header, 1, sizeof(NormalizeHeader), file);
+    bool valid=(readSize == sizeof(NormalizeHeader));
+
+    valid=valid&&(header.marker == EquiRectWorldGeneratorHeader_Marker);
+    //from another overview (or a truncated write), the map has to cover every influence cell
+    valid=valid&&((size_t)header.size == m_influenceMap.size()*NeighborCount);
+
+    if(!valid)
+    {
+        fs::close(file);
+        return false;
+    }
+
+    m_influenceNeighborMap.resize(header.size);
+
+    readSize=fs::read(m_influenceNeighborMap.data(), sizeof(float), header.size, file);
+    fs::close(file);
+
+    return (readSize == header.size);
+}
+
+
+template<typename _FileIO>
+bool EquiRectWorldGenerator::saveNormalize(const std::string &fileName, const std::vector<float> &influenceNeighborMap)
+{
+    typedef generic::io::fs<_FileIO> fs;
+
+    typename fs::Type *file=fs::open(fileName, "wb");
+
+    if(!file)
+        return false;
+
+    NormalizeHeader header;
+
+    header.marker=EquiRectWorldGeneratorHeader_Marker;
+    header.version=1;
+    header.size=influenceNeighborMap.size();
+
+    fs::write(&header, sizeof(NormalizeHeader), 1, file);
+    size_t written=fs::write(influenceNeighborMap.data(), sizeof(float), influenceNeighborMap.size(), file);
+    fs::close(file);
+
+    return (written==influenceNeighborMap.size());
+}
+
+
+//Per plate values needed before any influence cell can be finished. Kept by plate value rather than
+//index so the map can be gathered in bands without knowing every plate up front.
+struct PlateStatistics
+{
+    //gathers rows [rowBegin, rowEnd), bands have to be added in row order
+    void add(const float *plateMap, const float *plate2Map, const float *plateDistanceMap, int width, int rowBegin, int rowEnd);
+
+    size_t plateIndex(float value) const { return index_sorted(plates, value); }
+
+    std::vector<float> plates;
+    std::vector<float> minDistance;
+    std::vector<float> maxDistance;
+    std::vector<glm::ivec2> minPoint;
+    //plate/border plate values found next to each other, border values that are never a plate are dropped
+    //when resolved to indices
+    std::vector<std::pair<float, float>> neighbors;
+};
+
+
+void PlateStatistics::add(const float *plateMap, const float *plate2Map, const float *plateDistanceMap, int width, int rowBegin, int rowEnd)
+{
+    size_t count=(size_t)width*(rowEnd-rowBegin);
+    float last=-2.0f;
+    size_t lastIndex=0;
+    std::pair<float, float> lastNeighbor(-2.0f, -2.0f);
+    glm::ivec2 point={0, rowBegin};
+
+    for(size_t i=0; i<count; i++)
+    {
+        if(plateMap[i]!=last)
+        {
+            last=plateMap[i];
+            lastIndex=index_sorted(plates, last);
+
+            if(lastIndex==std::numeric_limits<size_t>::max())
+            {
+                //insert may reallocate, begin() has to be taken after it
+                std::vector<float>::iterator inserted=insert_sorted(plates, last);
+
+                lastIndex=inserted-plates.begin();
+                minDistance.insert(minDistance.begin()+lastIndex, 2.0f);
+                maxDistance.insert(maxDistance.begin()+lastIndex, -2.0f);
+                minPoint.insert(minPoint.begin()+lastIndex, glm::ivec2(0, 0));
+            }
+        }
+
+        std::pair<float, float> neighbor(last, plate2Map[i]);
+
+        if((neighbor.first!=neighbor.second)&&(neighbor!=lastNeighbor))
+        {
+            if(!contains_sorted(neighbors, neighbor))
+                insert_sorted(neighbors, neighbor);
+            lastNeighbor=neighbor;
+        }
+
+        //strict compares keep the first point in row order, same for every band split
+        if(plateDistanceMap[i]<minDistance[lastIndex])
+        {
+            minDistance[lastIndex]=plateDistanceMap[i];
+            minPoint[lastIndex]=point;
+        }
+
+        if(plateDistanceMap[i]>maxDistance[lastIndex])
+            maxDistance[lastIndex]=plateDistanceMap[i];
+
+        point.x++;
+        if(point.x>=width)
+        {
+            point.x=0;
+            point.y++;
+        }
+    }
+}
+
+
+bool EquiRectWorldGenerator::generatePlates(Progress &progress)
+{
+    if(m_streamBandRows>0)
+        return generateStreamed(progress);
+
+    StageGraph graph;
+
+    uint64_t noiseKey=addNoiseStages(graph, 0, m_descriptorValues.m_influenceSize.y, progress);
+    //weather bands and plate jitter are seeded, everything else processing uses comes from the noise layers
+    uint64_t processingKey=Hash64().add(noiseKey).add(m_descriptorValues.seed).add(m_plateSeed).value();
+
+    if(m_layerKeys[InfluenceLayer]!=processingKey)
+    {
+        m_layerKeys[InfluenceLayer]=0;
+        graph.add("processing", {HeightLayer, TerrainScaleLayer, NsAirCurrentLayer, EwAirCurrentLayer, PlateLayer, BorderPlateLayer, PlateDistanceLayer, ContinentLayer},
+            {InfluenceLayer}, [this, processingKey, &progress]()
+            {
+                if(!processPlates(progress))
+                    return false;
+
+                m_layerKeys[InfluenceLayer]=processingKey;
+                return true;
+            });
+    }
+
+    bool complete=graph.run(&ThreadPool::global());
+
+    m_stageTimings=graph.timings();
+    return complete;
+}
+
+
+bool EquiRectWorldGenerator::generateStreamed(Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("generateStreamed");
+
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
+    size_t influenceMapSize=(size_t)influenceSize.x*influenceSize.y;
+    int bandRows=std::min(m_streamBandRows, influenceSize.y);
+
+    //layers only ever hold a band here, nothing from an earlier generation applies
+    invalidateStageCache();
+    m_hidden->build(m_descriptorValues);
+    m_stageTimings.clear();
+
+    progress.update(Stage::WeatherBands, 5);
+    PerturbedWeatherBands weather(m_plateSeed+10, influenceSize, getWeatherCells(), m_descriptorValues.m_simdLevel);
+
+    //boundary pass, a cell's closest plate border can be in any band so the distances need every border first.
+    //One bit per cell, the plate layer itself is dropped with each band.
+    PlateBoundaries boundaries;
+
+    boundaries.reset(influenceSize.x, influenceSize.y);
+
+    for(int rowBegin=0; rowBegin<influenceSize.y; rowBegin+=bandRows)
+    {
+        int rowEnd=std::min(rowBegin+bandRows, influenceSize.y);
+
+        if(!generateCoordinates(rowBegin, rowEnd, progress)||!generatePlateLayers(false, progress))
+            return false;
+
+        boundaries.addRows(m_layers.plateMap.data(), rowBegin, rowEnd);
+        progress.update(Stage::TectonicPlates, 5+10*rowEnd/influenceSize.y);
+    }
+
+    //reduction pass, every plate has to be known before any cell can be finished. Only the three plate
+    //layers are needed and no halo, they are generated again with the rest in the second pass.
+    PlateStatistics statistics;
+
+    for(int rowBegin=0; rowBegin<influenceSize.y; rowBegin+=bandRows)
+    {
+        int rowEnd=std::min(rowBegin+bandRows, influenceSize.y);
+
+        if(!generateCoordinates(rowBegin, rowEnd, progress)||!generatePlateLayers(true, progress)||
+            !generatePlateDistance(rowBegin, rowEnd, &boundaries, progress))
+            return false;
+
+        statistics.add(m_layers.plateMap.data(), m_layers.plate2Map.data(), m_layers.plateDistance.data(), influenceSize.x, rowBegin, rowEnd);
+        progress.update(Stage::TectonicPlates, 15+15*rowEnd/influenceSize.y);
+    }
+
+    std::vector<PlateInfo> plateDetails;
+
+    buildPlateDetails(statistics, plateDetails);
+
+    m_influenceMap.resize(influenceMapSize);
+
+    std::vector<InfluenceCell> bandCells;
+
+    for(int rowBegin=0; rowBegin<influenceSize.y; rowBegin+=bandRows)
+    {
+        int rowEnd=std::min(rowBegin+bandRows, influenceSize.y);
+        int haloBegin=rowBegin-StreamHaloRows;
+        int haloEnd=rowEnd+StreamHaloRows;
+        StageGraph graph;
+
+        //a band whose halos meet around the map is the whole map
+        if(haloEnd-haloBegin>=influenceSize.y)
+        {
+            haloBegin=0;
+            haloEnd=influenceSize.y;
+        }
+
+        addNoiseStages(graph, haloBegin, haloEnd, progress, &boundaries);
+
+        bool complete=graph.run(&ThreadPool::global());
+
+        m_stageTimings.insert(m_stageTimings.end(), graph.timings().begin(), graph.timings().end());
+
+        if(!complete)
+            return false;
+
+        bandCells.resize((size_t)influenceSize.x*(haloEnd-haloBegin));
+
+        if(!processInfluenceRows(weather, statistics, plateDetails, haloBegin, haloEnd, bandCells.data(), progress))
+            return false;
+
+        //halo rows belong to the neighboring bands
+        std::copy(bandCells.begin()+(size_t)influenceSize.x*(rowBegin-haloBegin), bandCells.begin()+(size_t)influenceSize.x*(rowEnd-haloBegin),
+            m_influenceMap.begin()+(size_t)influenceSize.x*rowBegin);
+    }
+
+    m_plateCount=statistics.plates.size();
+
+    //band sized layers are of no use to anyone, only the influence map is kept
+    m_layers=GenerationLayers();
+    m_arena.release();
+    m_xPositions=nullptr;
+    m_yPositions=nullptr;
+    m_zPositions=nullptr;
+    m_positionCount=0;
+    invalidateStageCache();
+    return true;
+}
+
+
+bool EquiRectWorldGenerator::generateNoiseLayers(int rowBegin, int rowEnd, Progress &progress)
+{
+    StageGraph graph;
+
+    addNoiseStages(graph, rowBegin, rowEnd, progress, nullptr, false);
+
+    bool complete=graph.run(&ThreadPool::global());
+
+    m_stageTimings=graph.timings();
+    return complete;
+}
+
+
+uint64_t EquiRectWorldGenerator::addNoiseStages(StageGraph &graph, int rowBegin, int rowEnd, Progress &progress, const PlateBoundaries *boundaries,
+    bool plateDistance)
+{
+    struct NoiseStage
+    {
+        const char *name;
+        LayerId layer;
+        Stage stage;
+        int percent;
+        const FastNoise::Generator *generator;
+        LayerBuffer *output;
+        int seed;
+        float frequency;//0 for the fixed scale graphs
+    };
+
+    //frequencies can change between generations (mapgen edits the descriptors), the graphs are fixed from here on
+    m_hidden->build(m_descriptorValues);
+
+    const float plateFrequency=m_descriptorValues.m_plateFrequency;
+    const float continentFrequency=m_descriptorValues.m_continentFrequency;
+
+    std::vector<NoiseStage> stages=
+    {
+        {"height", HeightLayer, Stage::HeightMap, 15, m_hidden->m_heightNoise.get(), &m_layers.heightMap, m_plateSeed, 0.0f},
+        {"terrainScale", TerrainScaleLayer, Stage::Terrain, 20, m_hidden->m_terrainScaleNoise.get(), &m_layers.terrainScale, m_plateSeed, 0.0f},
+        {"nsAirCurrent", NsAirCurrentLayer, Stage::AirCurrents, 25, m_hidden->m_airCurrentNoise.get(), &m_layers.nsAirCurrent, m_plateSeed+3, 0.0f},
+        {"ewAirCurrent", EwAirCurrentLayer, Stage::AirCurrents, 25, m_hidden->m_airCurrentNoise.get(), &m_layers.ewAirCurrent, m_plateSeed+4, 0.0f},
+        {"plates", PlateLayer, Stage::TectonicPlates, 30, m_hidden->m_plateNoise.get(), &m_layers.plateMap, m_plateSeed, plateFrequency},
+        {"borderPlates", BorderPlateLayer, Stage::TectonicPlates, 30, m_hidden->m_borderPlateNoise.get(), &m_layers.plate2Map, m_plateSeed, plateFrequency},
+        {"continents", ContinentLayer, Stage::Continents, 45, m_hidden->m_continentNoise.get(), &m_layers.continentMap, m_continentSeed, continentFrequency}
+    };
+
+    //seeded plates make both plate layers in one stage of their own
+    const bool seededPlates=(m_descriptorValues.m_plateAssignment==PlateAssignment::Seeded);
+
+    if(seededPlates)
+    {
+        stages.erase(std::remove_if(stages.begin(), stages.end(), [](const NoiseStage &stage)
+            {
+                return (stage.layer==PlateLayer)||(stage.layer==BorderPlateLayer);
+            }), stages.end());
+    }
+
+    //a layer whose key matches the one it was generated with is reused, only the changed passes run
+    uint64_t coordinatesKey=Hash64().add(m_descriptorValues.m_influenceSize).add(rowBegin).add(rowEnd).value();
+    std::vector<uint64_t> keys(stages.size());
+    Hash64 noiseKey;
+    bool coordinatesNeeded=false;
+    uint64_t platesKey=0;
+
+    for(size_t i=0; i<stages.size(); ++i)
+    {
+        const NoiseStage &stage=stages[i];
+
+        keys[i]=Hash64().add(coordinatesKey).add(stage.layer).add(stage.seed).add(stage.frequency).value();
+        noiseKey.add(keys[i]);
+
+        if(m_layerKeys[stage.layer]!=keys[i])
+            coordinatesNeeded=true;
+        if(stage.layer==PlateLayer)
+            platesKey=keys[i];
+    }
+
+    if(seededPlates)
+    {
+        platesKey=Hash64().add(coordinatesKey).add(PlateLayer).add(m_plateSeed).add(m_descriptorValues.m_plateCount).add(plateFrequency).value();
+        noiseKey.add(platesKey);
+
+        if((m_layerKeys[PlateLayer]!=platesKey)||(m_layerKeys[BorderPlateLayer]!=platesKey))
+            coordinatesNeeded=true;
+    }
+
+    //band local and whole map boundaries give different distances near the band edges
+    uint64_t plateDistanceKey=Hash64().add(platesKey).add(PlateDistanceLayer).add(boundaries!=nullptr).value();
+
+    if(plateDistance)
+        noiseKey.add(plateDistanceKey);
+
+    size_t bandMapSize=(size_t)m_descriptorValues.m_influenceSize.x*(rowEnd-rowBegin);
+
+    if(coordinatesNeeded && (m_layerKeys[PositionsLayer]!=coordinatesKey))
+    {
+        m_layerKeys[PositionsLayer]=0;
+        graph.add("coordinates", {}, {PositionsLayer}, [this, rowBegin, rowEnd, coordinatesKey, &progress]()
+            {
+                if(!generateCoordinates(rowBegin, rowEnd, progress))
+                    return false;
+
+                m_layerKeys[PositionsLayer]=coordinatesKey;
+                return true;
+            });
+    }
+
+    //every noise pass only reads the positions and writes its own layer
+    for(size_t i=0; i<stages.size(); ++i)
+    {
+        const NoiseStage &stage=stages[i];
+        uint64_t key=keys[i];
+
+        if(m_layerKeys[stage.layer]==key)
+            continue;
+
+        m_layerKeys[stage.layer]=0;
+        graph.add(stage.name, {PositionsLayer}, {stage.layer}, [this, stage, key, bandMapSize, &progress]()
+            {
+                progress.update(stage.stage, stage.percent);
+                stage.output->resize(bandMapSize);
+
+                if(!generateNoise(stage.generator, stage.output->data(), stage.seed, progress))
+                    return false;
+
+                m_layerKeys[stage.layer]=key;
+                return true;
+            });
+    }
+
+    if(seededPlates && ((m_layerKeys[PlateLayer]!=platesKey)||(m_layerKeys[BorderPlateLayer]!=platesKey)))
+    {
+        m_layerKeys[PlateLayer]=0;
+        m_layerKeys[BorderPlateLayer]=0;
+        graph.add("seededPlates", {PositionsLayer}, {PlateLayer, BorderPlateLayer}, [this, platesKey, &progress]()
+            {
+                progress.update(Stage::TectonicPlates, 30);
+
+                if(!generatePlateLayers(true, progress))
+                    return false;
+
+                m_layerKeys[PlateLayer]=platesKey;
+                m_layerKeys[BorderPlateLayer]=platesKey;
+                return true;
+            });
+    }
+
+    if(plateDistance && (m_layerKeys[PlateDistanceLayer]!=plateDistanceKey))
+    {
+        m_layerKeys[PlateDistanceLayer]=0;
+        graph.add("plateDistance", {PlateLayer}, {PlateDistanceLayer}, [this, rowBegin, rowEnd, boundaries, plateDistanceKey, &progress]()
+            {
+                progress.update(Stage::TectonicPlates, 35);
+
+                if(!generatePlateDistance(rowBegin, rowEnd, boundaries, progress))
+                    return false;
+
+                m_layerKeys[PlateDistanceLayer]=plateDistanceKey;
+                return true;
+            });
+    }
+
+    return noiseKey.value();
+}
+
+
+bool EquiRectWorldGenerator::generatePlateDistance(int rowBegin, int rowEnd, const PlateBoundaries *boundaries, Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("generatePlateDistance");
+
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
+    size_t bandMapSize=(size_t)influenceSize.x*(rowEnd-rowBegin);
+    PlateBoundaries bandBoundaries;
+
+    assert(m_layers.plateMap.size()==bandMapSize);
+
+    if(progress.cancelled())
+        return false;
+
+    //without the whole map's boundaries only the ones inside the band are known
+    if(!boundaries)
+    {
+        bandBoundaries.reset(influenceSize.x, influenceSize.y);
+        bandBoundaries.addRows(m_layers.plateMap.data(), rowBegin, rowEnd);
+        boundaries=&bandBoundaries;
+    }
+
+    m_layers.plateDistance.resize(bandMapSize);
+
+    //streamed halo rows outside the map are measured as the rows they wrap to, one call per run of map rows
+    for(int row=rowBegin; row<rowEnd;)
+    {
+        int mapRow=wrapRow(row, influenceSize.y);
+        int runEnd=std::min(rowEnd, row+(influenceSize.y-mapRow));
+
+        boundaryDistance(*boundaries, mapRow, mapRow+(runEnd-row), m_layers.plateDistance.data()+(size_t)influenceSize.x*(row-rowBegin),
+            &ThreadPool::global());
+        row=runEnd;
+    }
+
+    //1 on the border falling towards the plate centers, the per plate range is normalized in processing
+    const float height=(float)influenceSize.y;
+    float *distance=m_layers.plateDistance.data();
+
+    for(size_t i=0; i<bandMapSize; ++i)
+        distance[i]=1.0f-std::min(distance[i], height)/height;
+
+    return !progress.cancelled();
+}
+
+
+bool EquiRectWorldGenerator::generatePlateLayers(bool borderPlates, Progress &progress)
+{
+    m_layers.plateMap.resize(m_positionCount);
+    m_layers.plate2Map.resize(m_positionCount);
+
+    if(m_descriptorValues.m_plateAssignment!=PlateAssignment::Seeded)
+    {
+        if(!generateNoise(m_hidden->m_plateNoise.get(), m_layers.plateMap.data(), m_plateSeed, progress))
+            return false;
+        return !borderPlates||generateNoise(m_hidden->m_borderPlateNoise.get(), m_layers.plate2Map.data(), m_plateSeed, progress);
+    }
+
+    WORLDGEN_TRACE_ZONE("seededPlates");
+
+    const PlateSeeds &seeds=m_hidden->plateSeeds(m_descriptorValues.m_plateCount, m_plateSeed);
+    float *warpX=m_arena.get<float>(PlateWarpXSlot, m_positionCount);
+    float *warpY=m_arena.get<float>(PlateWarpYSlot, m_positionCount);
+    float *warpZ=m_arena.get<float>(PlateWarpZSlot, m_positionCount);
+
+    if(!generateNoise(m_hidden->m_plateWarpNoise.get(), warpX, m_plateSeed+5, progress)||
+        !generateNoise(m_hidden->m_plateWarpNoise.get(), warpY, m_plateSeed+6, progress)||
+        !generateNoise(m_hidden->m_plateWarpNoise.get(), warpZ, m_plateSeed+7, progress))
+        return false;
+
+    //positions are on a sphere of half the map width, the warp is scaled to the seed spacing so plate
+    //borders are ragged by the same amount whatever the plate count
+    float radius=m_descriptorValues.m_influenceSize.x/2.0f;
+    float amplitude=PlateWarpAmplitude*seeds.spacing();
+
+    for(size_t i=0; i<m_positionCount; ++i)
+    {
+        warpX[i]=m_xPositions[i]/radius+amplitude*warpX[i];
+        warpY[i]=m_yPositions[i]/radius+amplitude*warpY[i];
+        warpZ[i]=m_zPositions[i]/radius+amplitude*warpZ[i];
+    }
+
+    seeds.assign(warpX, warpY, warpZ, m_positionCount, m_layers.plateMap.data(), m_layers.plate2Map.data(), &ThreadPool::global());
+    return !progress.cancelled();
+}
+
+
+void EquiRectWorldGenerator::invalidateStageCache()
+{
+    m_layerKeys.assign(LayerCount, 0);
+}
+
+
+bool EquiRectWorldGenerator::generateCoordinates(int rowBegin, int rowEnd, Progress &progress)
+{
 	glm::ivec2 influenceSize=m_descriptorValues.m_influenceSize;
-    int influenceMapSize=influenceSize.x*influenceSize.y;
-    int alignedMapSize=influenceSize.x*influenceSize.y;// HastyNoise::AlignedSize(influenceSize.x*influenceSize.y, m_simdLevel);
-	glm::ivec2 size=m_descriptors.getSize();
+    size_t bandMapSize=(size_t)influenceSize.x*(rowEnd-rowBegin);
 
-    progress.update("Generating weather bands", 0, false);
-//    WeatherBands weather(weatherCells);
-    PerturbedWeatherBands weather(m_plateSeed+10, influenceSize, weatherCells);
-
-    chrono::high_resolution_clock::time_point time1;
-    chrono::high_resolution_clock::time_point time2;
-
-    std::vector<float> &plateMap=plateMap_noise;
-    std::vector<float> &plate2Map=plate2Map_noise;
-    std::vector<float> &plateDistanceMap=plateDistance_noise;
-    std::vector<float> &continentMap=continentMap_noise;
-    std::vector<float> &heightMap=heightMap_noise;
-    std::vector<float> terrainScaleMap;
-    std::vector<float> i;
-    std::vector<float> nsAirCurrent;
-    std::vector<float> ewAirCurrent;
-    std::vector<PlateInfo> plateDetails;
-    std::vector<float> moistureMap;
-    std::vector<float> moistureMap2;
-    std::vector<float> moistureDeltaMap;
+    progress.update(Stage::Allocating, 5);
 
-    time1=chrono::high_resolution_clock::now();
-
-    progress.update("Allocating resources", 5, false);
+//    m_influenceVectorSet=std::make_unique<HastyNoise::VectorSet>(m_simdLevel);
+//    m_influenceVectorSet->SetSize(alignedMapSize);
+    m_xPositions=m_arena.get<float>(XPositionSlot, bandMapSize);
+    m_yPositions=m_arena.get<float>(YPositionSlot, bandMapSize);
+    m_zPositions=m_arena.get<float>(ZPositionSlot, bandMapSize);
+    m_positionCount=bandMapSize;
 
-    plateMap.resize(alignedMapSize);
-    plate2Map.resize(alignedMapSize);
-    plateScaleMap.resize(alignedMapSize);
-    plate2ScaleMap.resize(alignedMapSize);
-    plateDistanceMap.resize(alignedMapSize);
-    continentMap.resize(alignedMapSize);
-    heightMap.resize(alignedMapSize);
-    terrainScaleMap.resize(alignedMapSize);
-    moistureMap.resize(alignedMapSize);
-    moistureMap2.resize(alignedMapSize);
-    moistureDeltaMap.resize(alignedMapSize);
+    progress.update(Stage::Coordinates, 10);
+    if(progress.cancelled())
+        return false;
 
-    nsAirCurrent.resize(alignedMapSize);
-    ewAirCurrent.resize(alignedMapSize);
+    //streamed halo rows outside the map are the rows they wrap to
+    std::vector<float> rows;
 
-    m_influenceMap.resize(influenceMapSize);
+    rows.reserve(rowEnd-rowBegin);
+    for(int row=rowBegin; row<rowEnd; ++row)
+        rows.push_back((float)wrapRow(row, influenceSize.y));
 
-//    m_influenceVectorSet=std::make_unique<HastyNoise::VectorSet>(m_simdLevel);
-//    m_influenceVectorSet->SetSize(alignedMapSize);
-    m_xPositions.resize(alignedMapSize);
-    m_yPositions.resize(alignedMapSize);
-    m_zPositions.resize(alignedMapSize);
+    //fastnoise treats x and y in reverse, need to change
+    getSphericalCoords(influenceSize.x, influenceSize.y, influenceSize.x, rows.data(), rows.size(), (float)(influenceSize.x/2.0f),
+        m_yPositions, m_xPositions, m_zPositions);
+    return true;
+}
 
 
-    time2=chrono::high_resolution_clock::now();
-    allocationTime=chrono::duration_cast<chrono::milliseconds>(time2-time1).count();
+bool EquiRectWorldGenerator::processPlates(Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("processPlates");
 
-    progress.update("Generating coordinates", 10, false);
-    glm::vec3 mapPos;
-    size_t index=0;
-    mapPos.z=(float)(influenceSize.x/2.0f);
-    for(int y=0; y<influenceSize.y; y++)
-    {
-        mapPos.y=y;
-        for(int x=0; x<influenceSize.x; x++)
-        {
-            mapPos.x=x;
-            glm::vec3 pos=getSphericalCoords(influenceSize.x, influenceSize.y, mapPos);
-
-            //fastnoise treats x and y in reverse, need to change
-            m_xPositions[index]=pos.y;//*m_descriptorValues.m_plateFrequency;
-            m_yPositions[index]=pos.x;//*m_descriptorValues.m_plateFrequency;
-            m_zPositions[index]=pos.z;//*m_descriptorValues.m_plateFrequency;
-            index++;
-        }
-    }
+	glm::ivec2 influenceSize=m_descriptorValues.m_influenceSize;
+    size_t influenceMapSize=(size_t)influenceSize.x*influenceSize.y;
 
-    time1=chrono::high_resolution_clock::now();
-    coordsTime=chrono::duration_cast<chrono::milliseconds>(time1-time2).count();
-
-    progress.update("Generating heightmap", 15, false);
-//height map
-    m_hidden->m_domainScale->SetSource(m_hidden->m_os2Noise);
-    m_hidden->m_fractalFbmNoise->SetSource(m_hidden->m_domainScale);
-
-    m_hidden->m_domainScale->SetScale(0.01f);
-    m_hidden->m_fractalFbmNoise->SetGain(0.5f);
-    m_hidden->m_fractalFbmNoise->SetOctaveCount(4);
-    m_hidden->m_fractalFbmNoise->SetLacunarity(2.0f);
-    m_hidden->m_fractalFbmNoise->GenPositionArray3D(heightMap.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed);
-
-    progress.update("Generating terrain", 20, false);
-
-    m_hidden->m_domainScale->SetScale(0.05f);
-    m_hidden->m_fractalFbmNoise->SetGain(0.5f);
-    m_hidden->m_fractalFbmNoise->SetOctaveCount(4);
-    m_hidden->m_fractalFbmNoise->SetLacunarity(2.0f);
-    m_hidden->m_fractalFbmNoise->GenPositionArray3D(terrainScaleMap.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed);
-
-    progress.update("Generating air currents", 25, false);
-
-    m_hidden->m_domainWarp->SetSource(m_hidden->m_domainScale);
-    m_hidden->m_fractalFbmNoise->SetSource(m_hidden->m_domainWarp);
-
-    m_hidden->m_domainScale->SetScale(0.01f);
-    m_hidden->m_domainWarp->SetWarpAmplitude(0.5f);
-    m_hidden->m_domainWarp->SetWarpFrequency(1.0f);
-    m_hidden->m_fractalFbmNoise->SetGain(0.5f);
-    m_hidden->m_fractalFbmNoise->SetOctaveCount(4);
-    m_hidden->m_fractalFbmNoise->SetLacunarity(2.0f);
-    m_hidden->m_fractalFbmNoise->GenPositionArray3D(nsAirCurrent.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed+3);
-
-
-//    m_continentPerlin->SetSeed(m_plateSeed+4);
-//    m_continentPerlin->FillSet(ewAirCurrent.data(), m_influenceVectorSet.get());
-    m_hidden->m_fractalFbmNoise->GenPositionArray3D(ewAirCurrent.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed+4);
-
-    progress.update("Generating tectonic plates", 30, false);
-
-//plate map
-    m_hidden->m_cellularNoise->SetDistanceFunction(FastNoise::DistanceFunction::Hybrid);
-    m_hidden->m_cellularNoise->SetValueIndex(0);
-    m_hidden->m_domainWarp->SetSource(m_hidden->m_cellularNoise);
-    m_hidden->m_domainWarp->SetWarpAmplitude(0.5f);
-    m_hidden->m_domainWarp->SetWarpFrequency(1.0f);
-    m_hidden->m_domainWarpFractal->SetSource(m_hidden->m_domainWarp);
-    m_hidden->m_domainWarpFractal->SetGain(0.5f);
-    m_hidden->m_domainWarpFractal->SetOctaveCount(5);
-    m_hidden->m_domainWarpFractal->SetLacunarity(2.0f);
-    m_hidden->m_domainScale->SetSource(m_hidden->m_domainWarpFractal);
-    m_hidden->m_domainScale->SetScale(m_descriptorValues.m_plateFrequency);
-
-    m_hidden->m_domainScale->GenPositionArray3D(plateMap.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed);
-//    m_hidden->m_cellularNoise->GenPositionArray3D(plateMap.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-//        0.0f, 0.0f, 0.0f, m_plateSeed);
-//    m_hidden->m_cellularNoise->FillSet(plateMap.data(), m_influenceVectorSet.get());
-
-//Border plate Map
-    m_hidden->m_cellularNoise->SetValueIndex(1);
-    m_hidden->m_domainScale->GenPositionArray3D(plate2Map.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed);
-
-    time2=chrono::high_resolution_clock::now();
-    cellularPlateTime=chrono::duration_cast<chrono::milliseconds>(time2-time1).count();
-
-    progress.update("Generating tectonic plates", 35, false);
-
-//Distance Map
-    //going to generate twice as I want the distance value as well, will mod HastyNoise later to produce both (as it has already done the work)
-    m_hidden->m_cellularDistanceNoise->SetDistanceFunction(FastNoise::DistanceFunction::Hybrid);
-    m_hidden->m_cellularDistanceNoise->SetReturnType(CellularReturnType::Index0Div1);//gives distance to border
-    m_hidden->m_cellularDistanceNoise->SetDistanceIndex0(0);
-    m_hidden->m_cellularDistanceNoise->SetDistanceIndex1(1);
-//    m_hidden->m_cellularDistanceNoise->FillSet(plateDistanceMap.data(), m_influenceVectorSet.get());
-//    m_hidden->m_domainScale->SetSource(m_hidden->m_cellularDistanceNoise);
-    m_hidden->m_domainWarp->SetSource(m_hidden->m_cellularDistanceNoise);
-
-    m_hidden->m_domainScale->GenPositionArray3D(plateDistanceMap.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_plateSeed);
-
-    time1=chrono::high_resolution_clock::now();
-    cellularDistanceTime=chrono::duration_cast<chrono::milliseconds>(time1-time2).count();
-
-
-    time2=chrono::high_resolution_clock::now();
-    cellularPlate2Time=chrono::duration_cast<chrono::milliseconds>(time2-time1).count();
-
-    progress.update("Generating continents", 45, false);
-//continent map
-    m_hidden->m_cellularNoise->SetValueIndex(0);
-    m_hidden->m_domainWarp->SetSource(m_hidden->m_cellularNoise);
-    m_hidden->m_domainScale->SetScale(m_descriptorValues.m_continentFrequency);
-//    m_hidden->m_cellularDistanceNoise->SetSeed(m_continentSeed);
-//    m_hidden->m_cellularDistanceNoise->SetFrequency(m_descriptorValues.m_continentFrequency);
-//    m_hidden->m_cellularDistanceNoise->FillSet(continentMap.data(), m_influenceVectorSet.get());
-    m_hidden->m_domainScale->GenPositionArray3D(continentMap.data(), influenceMapSize, m_xPositions.data(), m_yPositions.data(), m_zPositions.data(),
-        0.0f, 0.0f, 0.0f, m_continentSeed);
-
-    time1=chrono::high_resolution_clock::now();
+    assert(m_layers.plateMap.size()==influenceMapSize);
 
-    float last=-2.0f;
-    std::vector<float> plates;
+    progress.update(Stage::WeatherBands, 47);
+//    WeatherBands weather(weatherCells);
+    PerturbedWeatherBands weather(m_plateSeed+10, influenceSize, getWeatherCells(), m_descriptorValues.m_simdLevel);
 
-    //find and index all plates
-    for(size_t i=0; i<influenceMapSize; i++)
-    {
-        if(plateMap[i]==last)
-            continue;
-        else if(contains_sorted(plates, plateMap[i]))
-        {
-            last=plateMap[i];
-            continue;
-        }
+    if(progress.cancelled())
+        return false;
 
-        insert_sorted(plates, plateMap[i]);
-        last=plateMap[i];
-    }
+    PlateStatistics statistics;
+    std::vector<PlateInfo> plateDetails;
 
-    last=-2.0f;
-    size_t lastIndex=0;
-    float last2=-2.0f;
-    size_t last2Index=0;
-    glm::ivec2 point={0, 0};
+    statistics.add(m_layers.plateMap.data(), m_layers.plate2Map.data(), m_layers.plateDistance.data(), influenceSize.x, 0, influenceSize.y);
 
-    //setup plates
-    std::default_random_engine generator(m_descriptorValues.seed);
-    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
-    std::uniform_real_distribution<float> distributionNorm(0.0f, 1.0f);
-    std::vector<float> jitter;
-    std::vector<float> plateMinDistance;
-    std::vector<float> plateMaxDistance;
-    std::vector<glm::ivec2> plateMinPoint;
-    std::vector<int> plateNeighbors;
-    std::vector<int> plateCollisions;
-
-    plateDetails.resize(plates.size());
-    plateNeighbors.resize(plates.size()*plates.size(), 0);
-    plateMinDistance.resize(plates.size(), 2.0f);
-    plateMaxDistance.resize(plates.size(), -2.0f);
-    plateMinPoint.resize(plates.size());
-
-    glm::vec3 zAxis(0.0f, 0.0f, 1.0f);
-
-    progress.update("Generating height map", 50, false);
-
-    for(size_t i=0; i<influenceMapSize; i++)
-    {
-        if(plateMap[i]!=last)
-        {
-            lastIndex=index_sorted(plates, plateMap[i]);
-            last=plateMap[i];
-        }
+    if(progress.cancelled())
+        return false;
 
-        if(plate2Map[i]!=last2)
-        {
-            last2Index=index_sorted(plates, plate2Map[i]);
+    progress.update(Stage::TectonicZones, 55);
+    buildPlateDetails(statistics, plateDetails);
 
-            if(last2Index==std::numeric_limits<size_t>::max())
-            {
-                //plate we haven't seen, setting to current plate
-                last2Index=lastIndex;
-                last2=plateMap[i];
-            }
-            else
-                last2=plate2Map[i];
-        }
+    m_influenceMap.resize(influenceMapSize);
 
-        if(lastIndex!=last2Index)
-        {
-            size_t neighborIndex=lastIndex*plates.size()+last2Index;
+    if(!processInfluenceRows(weather, statistics, plateDetails, 0, influenceSize.y, m_influenceMap.data(), progress))
+        return false;
 
-            if(!plateNeighbors[neighborIndex])
-                plateNeighbors[neighborIndex]=1;
-        }
+    m_plateCount=statistics.plates.size();
 
-        if(plateDistanceMap[i]<plateMinDistance[lastIndex])
-        {
-            plateMinDistance[lastIndex]=plateDistanceMap[i];
-            plateMinPoint[lastIndex]=point;
-        }
+//    updateInfluenceNeighbors();
+    return true;
+}
 
-        if(plateDistanceMap[i]>plateMaxDistance[lastIndex])
-            plateMaxDistance[lastIndex]=plateDistanceMap[i];
 
-        assert(last2Index<plates.size());
+void EquiRectWorldGenerator::buildPlateDetails(const PlateStatistics &statistics, std::vector<PlateInfo> &plateDetails) const
+{
+    WORLDGEN_TRACE_ZONE("buildPlateDetails");
 
-        m_influenceMap[i].tectonicPlate=lastIndex;
-        m_influenceMap[i].borderPlate=last2Index;
-        m_influenceMap[i].plateHeight=(last)*0.1f+0.5f;
-        m_influenceMap[i].plateValue=last;
-        m_influenceMap[i].plateDistanceValue=plateDistanceMap[i];
-        m_influenceMap[i].continentValue=continentMap[i];
+	glm::ivec2 influenceSize=m_descriptorValues.m_influenceSize;
 
-//        glm::vec2 airDirection(ewAirCurrent[i], nsAirCurrent[i]);
-//        
-//        m_influenceMap[i].airDirection=glm::normalize(airDirection);
-        m_influenceMap[i].airDirection.x=ewAirCurrent[i];
-        m_influenceMap[i].airDirection.y=nsAirCurrent[i];
+    //setup plates
+    plateDetails.resize(statistics.plates.size());
 
-        plateDetails[lastIndex].points.emplace_back(point.x, point.y);
+    //pairs are sorted so each plate gets its neighbors in index order
+    for(const std::pair<float, float> &neighbor:statistics.neighbors)
+    {
+        size_t borderIndex=statistics.plateIndex(neighbor.second);
 
-        point.x++;
-        if(point.x>=influenceSize.x)
-        {
-            point.x=0;
-            point.y++;
-        }
+        if(borderIndex!=std::numeric_limits<size_t>::max())
+            plateDetails[statistics.plateIndex(neighbor.first)].neighbors.push_back(borderIndex);
     }
 
-    progress.update("Generating tectonic zones", 55, false);
-
     for(size_t i=0; i<plateDetails.size(); i++)
     {
         PlateInfo &details=plateDetails[i];
 
-        details.value=plates[i];
-        details.point=plateMinPoint[i];
+        details.value=statistics.plates[i];
+        details.point=statistics.minPoint[i];
 
         glm::vec2 mapPoint;
         glm::vec3 point;
 
         //we want plate heights to be 0.5 to -0.5
 //        details.height=(distributionNorm(generator))*0.3f+0.3f;
-        details.height=(plates[i])*0.1f+0.5f;
+        details.height=(statistics.plates[i])*0.1f+0.5f;
         if(details.height<0.5f)
             details.height=details.height-0.05f;
 
@@ -810,87 +1965,105 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
 
         projectPoint<Projections::Equirectangular, Projections::Cartesian>(mapPoint, point);
         details.point3d=point;
+    }
 
-        glm::vec3 direction;
-        glm::vec2 tangentPlaneCoords;
+    initPlateMotion(plateDetails, m_descriptorValues.seed);
+}
 
-        //generate drift vector, building on x/y plane that will be rotate to the point
-        //tanget to the sphere
-        tangentPlaneCoords.x=distribution(generator);
-        tangentPlaneCoords.y=distribution(generator);
-        tangentPlaneCoords=glm::normalize(tangentPlaneCoords);
 
-        details.driftDirection=tangentPlaneCoords;
-        rotateTangetVectorToPoint(point, tangentPlaneCoords, details.direction);
+bool EquiRectWorldGenerator::processInfluenceRows(PerturbedWeatherBands &weather, const PlateStatistics &statistics, std::vector<PlateInfo> &plateDetails,
+    int rowBegin, int rowEnd, InfluenceCell *cells, Progress &progress)
+{
+    WORLDGEN_TRACE_ZONE("processInfluenceRows");
 
-//        //cross with z axis for a rotation vector to align with the z axis
-//        glm::vec3 rotationVector=glm::cross(zAxis, point);
-//
-//        if(glm::length2(rotationVector)==0.0f)
-//        {//already aligned to z axis
-//            details.direction=glm::vec3(tangentPlaneCoords.x, tangentPlaneCoords.y, 0.0f);
-//        }
-//        else
-//        {
-//            //get angle to rotate vector to position
-//            float theta=acos(glm::dot(point, zAxis));
-//            glm::mat4 rotationMat=glm::rotate(theta, rotationVector);
-//
-//            details.direction=rotationMat*glm::vec4(tangentPlaneCoords.x, tangentPlaneCoords.y, 0.0f, 1.0f);
-//        }
+	glm::ivec2 influenceSize=m_descriptorValues.m_influenceSize;
+    //layers, cells and the moisture buffers all cover just the rows given
+    glm::ivec2 bandSize(influenceSize.x, rowEnd-rowBegin);
+    size_t cellCount=(size_t)bandSize.x*bandSize.y;
+
+    assert(m_layers.plateMap.size()==cellCount);
+
+    LayerBuffer &plateMap=m_layers.plateMap;
+    LayerBuffer &plate2Map=m_layers.plate2Map;
+    LayerBuffer &plateDistanceMap=m_layers.plateDistance;
+    LayerBuffer &continentMap=m_layers.continentMap;
+    LayerBuffer &heightMap=m_layers.heightMap;
+    LayerBuffer &terrainScaleMap=m_layers.terrainScale;
+    LayerBuffer &nsAirCurrent=m_layers.nsAirCurrent;
+    LayerBuffer &ewAirCurrent=m_layers.ewAirCurrent;
+    //both are written for every cell before they are read
+    float *moistureMap=m_arena.get<float>(MoistureSlot, cellCount);
+    float *moistureDeltaMap=m_arena.get<float>(MoistureDeltaSlot, cellCount);
+
+    m_layers.plateScaleMap.resize(cellCount);
+    m_layers.plate2ScaleMap.resize(cellCount);
 
-        size_t neighborIndex=i*plateDetails.size();
-        for(size_t j=0; j<plateDetails.size(); j++)
-        {
-            if(plateNeighbors[neighborIndex+j])
-                details.neighbors.push_back(j);
-        }
-    }
+    float last=-2.0f;
+    size_t lastIndex=0;
+    float last2=-2.0f;
+    size_t last2Index=0;
 
-    const float invsqrt2=0.5f/sqrt(2.0f);
+    progress.update(Stage::PlateHeight, 50);
 
-    for(size_t i=0; i<plateDetails.size(); i++)
+    for(size_t i=0; i<cellCount; i++)
     {
-        PlateInfo &details=plateDetails[i];
-        size_t neighborIndex=plateDetails.size()*i;
+        if((i%bandSize.x==0) && progress.cancelled())
+            return false;
+
+        if(plateMap[i]!=last)
+        {
+            lastIndex=statistics.plateIndex(plateMap[i]);
+            last=plateMap[i];
+        }
 
-        for(size_t j=0; j<details.neighbors.size(); j++)
+        if(plate2Map[i]!=last2)
         {
-            //this is working on the vector in between the center points, it is actually be better to rotate the 
-            //vector to the point being worked on and solve from there. Skipping shear for the moment.
-            PlateInfo &details2=plateDetails[details.neighbors[j]];
+            last2Index=statistics.plateIndex(plate2Map[i]);
 
-            glm::vec3 collisionVector=details2.point3d-details.point3d;
+            if(last2Index==std::numeric_limits<size_t>::max())
+            {
+                //plate we haven't seen, setting to current plate
+                last2Index=lastIndex;
+                last2=plateMap[i];
+            }
+            else
+                last2=plate2Map[i];
+        }
 
-            glm::vec3 direction=glm::proj(details.direction, collisionVector);
-            glm::vec3 direction2=glm::proj(details2.direction, collisionVector);
-            
-            float pointDistance=glm::distance(details2.point3d, details.point3d);
-            float directionDistance=glm::distance((details2.point3d+direction2), (details.point3d+direction));
+        assert(lastIndex<statistics.plates.size());
+        assert(last2Index<statistics.plates.size());
 
-            float collision=(pointDistance-directionDistance)*invsqrt2; //scale to 0.0 to 1.0
+        cells[i].tectonicPlate=lastIndex;
+        cells[i].borderPlate=last2Index;
+        cells[i].plateHeight=(last)*0.1f+0.5f;
+        cells[i].plateValue=last;
+        cells[i].plateDistanceValue=plateDistanceMap[i];
+        cells[i].continentValue=continentMap[i];
 
-            assert(collision<=1.0f);
-            collision=std::min(collision, 1.0f);//make sure between 0.0 and 1.0
-            details.neighborCollisions.push_back(collision);
-        }
+//        glm::vec2 airDirection(ewAirCurrent[i], nsAirCurrent[i]);
+//        
+//        cells[i].airDirection=glm::normalize(airDirection);
+        cells[i].airDirection.x=ewAirCurrent[i];
+        cells[i].airDirection.y=nsAirCurrent[i];
     }
 
+    progress.update(Stage::InfluenceMap, 60);
 
-    progress.update("Generating influence map", 60, false);
+    //boundary type of every cell first so the terrain curves are evaluated for the whole band in one pass
+    TectonicCurve *curveMap=m_arena.get<TectonicCurve>(TectonicCurveSlot, cellCount);
+    float *curveScaleMap=m_arena.get<float>(TectonicCurveScaleSlot, cellCount);
 
-    point={0, 0};
-    for(size_t i=0; i<influenceMapSize; i++)
+    for(size_t i=0; i<cellCount; i++)
     {
-        size_t &index=m_influenceMap[i].tectonicPlate;
-        size_t &borderIndex=m_influenceMap[i].borderPlate;
+        size_t index=cells[i].tectonicPlate;
+        size_t borderIndex=cells[i].borderPlate;
 
-        PlateInfo &details=plateDetails[index];
-        PlateInfo &details2=plateDetails[borderIndex];
+        const PlateInfo &details=plateDetails[index];
+        const PlateInfo &details2=plateDetails[borderIndex];
 
-        float collision;
+        float collision=0.0f;
 
-        if(!details.neighbors.empty())
+        if((index!=borderIndex) && !details.neighbors.empty())
         {
             size_t neighborIndex=0;
 
@@ -902,12 +2075,37 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
             
             collision=details.neighborCollisions[neighborIndex];
         }
-        else
-            collision=0.0f;
 
-        //normalize distance
-        m_influenceMap[i].plateDistanceValue=(plateDistanceMap[i]-plateMinDistance[index])/(plateMaxDistance[index]-plateMinDistance[index]);
-//        m_influenceMap[i].heightBase=0.0f;
+        //normalize distance, a plate that is nothing but border has no range
+        float distanceRange=statistics.maxDistance[index]-statistics.minDistance[index];
+
+        cells[i].plateDistanceValue=(distanceRange>0.0f)?(plateDistanceMap[i]-statistics.minDistance[index])/distanceRange:1.0f;
+        cells[i].collision=collision;
+
+        curveMap[i]=tectonicCurve(collision, (details.height<0.5f), (details2.height<0.5f));
+        curveScaleMap[i]=cells[i].plateDistanceValue;
+    }
+
+    if(progress.cancelled())
+        return false;
+
+    tectonicCurveTable().evaluate(curveMap, curveScaleMap, curveScaleMap, cellCount);
+
+    glm::ivec2 point={0, wrapRow(rowBegin, influenceSize.y)};
+    for(size_t i=0; i<cellCount; i++)
+    {
+        if((point.x==0) && progress.cancelled())
+            return false;
+
+        size_t &index=cells[i].tectonicPlate;
+        size_t &borderIndex=cells[i].borderPlate;
+
+        PlateInfo &details=plateDetails[index];
+        PlateInfo &details2=plateDetails[borderIndex];
+
+        //magnitude, the curve carries the direction
+        float collision=std::abs(cells[i].collision);
+//        cells[i].heightBase=0.0f;
 
 //build per pixel direction
         glm::vec3 sphericalPoint;
@@ -922,8 +2120,8 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
         rotateTangetVectorToPoint(cartPoint, details.driftDirection, direction);
 
         projectVector(direction, sphericalPoint, sphericalDirection);
-        m_influenceMap[i].direction.x=sphericalDirection.y;
-        m_influenceMap[i].direction.y=sphericalDirection.z;
+        cells[i].direction.x=sphericalDirection.y;
+        cells[i].direction.y=sphericalDirection.z;
 
 //air currents determined by banding and random vectors from before
         glm::vec2 latLong(sphericalPoint.y, sphericalPoint.z);
@@ -934,12 +2132,12 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
         if(sphericalPoint.z<0.0f)
             dir=-1.0f;
 
-        m_influenceMap[i].weatherCell=weather.getCellIndex(latLong);
-        m_influenceMap[i].weatherBand=weather.getBandIndex(latLong);
+        cells[i].weatherCell=weather.getCellIndex(latLong);
+        cells[i].weatherBand=weather.getBandIndex(latLong);
 
         bandDirection=weather.getWindDirection(latLong);
-        m_influenceMap[i].airDirection=bandDirection;
-//        m_influenceMap[i].airDirection=(bandDirection+m_influenceMap[i].airDirection)/2.0f;
+        cells[i].airDirection=bandDirection;
+//        cells[i].airDirection=(bandDirection+cells[i].airDirection)/2.0f;
 
 //build terrain
         bool oceanPlate=(details.height<0.5f);
@@ -947,56 +2145,41 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
 
         float plateScale;
         float plate2Scale;
-        float terrainScale=0.0f;
+        float terrainScale=curveScaleMap[i];
 
 		if((oceanPlate && !oceanPlate2) || (!oceanPlate&&oceanPlate2))
-			calculateCurve(m_influenceMap[i].plateDistanceValue, plateScale, plate2Scale, 0.7f);
+			calculateCurve(cells[i].plateDistanceValue, plateScale, plate2Scale, 0.7f);
 		else
-			calculateCurve(m_influenceMap[i].plateDistanceValue, plateScale, plate2Scale, 0.5f);
+			calculateCurve(cells[i].plateDistanceValue, plateScale, plate2Scale, 0.5f);
         
-        plateScaleMap[i]=plateScale;
-        plate2ScaleMap[i]=plate2Scale;
+        m_layers.plateScaleMap[i]=plateScale;
+        m_layers.plate2ScaleMap[i]=plate2Scale;
 //        if(i>51450)
 //            i=i;
 
-        if(index != borderIndex)
-        {
-            m_influenceMap[i].collision=collision;
-
-            if(collision<0.0f) //divergent boundary
-            {
-                collision=-(collision);//reverse negative as following is expecting collision to be a magnitude
-                terrainScale=calculateDivergentCurve(m_influenceMap[i].plateDistanceValue, oceanPlate, oceanPlate2);
-            }
-            else if(collision>0.0f) //convergent boundary
-                terrainScale=calculateConvergentCurve(m_influenceMap[i].plateDistanceValue, oceanPlate, oceanPlate2);
-        }
-        else
-            m_influenceMap[i].collision=0.0f;
-
         float genHeight=(heightMap[i]+1.0f)*0.05f;
         float genTerrainScale=(terrainScaleMap[i]+1.0f)*0.2f+0.2f;
 
-        m_influenceMap[i].heightBase=((details.height+genHeight)*plateScale)+(details2.height*plate2Scale)+(terrainScale*collision*genTerrainScale);// *0.4f);
+        cells[i].heightBase=((details.height+genHeight)*plateScale)+(details2.height*plate2Scale)+(terrainScale*collision*genTerrainScale);// *0.4f);
         
-        m_influenceMap[i].terrainScale=terrainScale;
+        cells[i].terrainScale=terrainScale;
 
-		if(m_influenceMap[i].heightBase>1.0f)
-			m_influenceMap[i].heightBase=1.0f;
-		if(m_influenceMap[i].heightBase<0.0f)
-			m_influenceMap[i].heightBase=0.0f;
+		if(cells[i].heightBase>1.0f)
+			cells[i].heightBase=1.0f;
+		if(cells[i].heightBase<0.0f)
+			cells[i].heightBase=0.0f;
 
 //temperature
-        m_influenceMap[i].temperature=getTemperature(latitude);
+        cells[i].temperature=getTemperature(latitude);
 
 //moisture
         float bandMoisture=weather.getMoisture(latLong);
 
-        m_influenceMap[i].moistureCapacity=bandMoisture*0.5f;
-        if(m_influenceMap[i].heightBase<0.5)
+        cells[i].moistureCapacity=bandMoisture*0.5f;
+        if(cells[i].heightBase<0.5)
             moistureMap[i]=1.0f;
-        //        if(m_influenceMap[i].heightBase<0.5)
-        //            moistureMap[i]=1.0f*(m_influenceMap[i].heightBase-0.25f)/0.25f;
+        //        if(cells[i].heightBase<0.5)
+        //            moistureMap[i]=1.0f*(cells[i].heightBase-0.25f)/0.25f;
         else
             moistureMap[i]=(bandMoisture*0.9)+(nsAirCurrent[i]*0.1f);// *0.5f;
 
@@ -1005,55 +2188,72 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
         {
             point.x=0;
             point.y++;
+            if(point.y>=influenceSize.y)
+                point.y=0;
         }
     }
 
-    progress.update("Generating moisture", 70, false);
+    progress.update(Stage::Moisture, 70);
 //    std::vector<float> *mapPointer1=&moistureMap;
 //    std::vector<float> *mapPointer2=&moistureMap2;
-    std::vector<float> &map1=moistureMap;
-    for(size_t i=0; i<influenceMapSize; i++)
+    float *map1=moistureMap;
+    for(size_t i=0; i<cellCount; i++)
     {
-        if(m_influenceMap[i].heightBase>0.5f)
+        if(cells[i].heightBase>0.5f)
             moistureDeltaMap[i]=0.0f;
         else
             moistureDeltaMap[i]=1.0f;
     }
 
     glm::ivec2 lowerImageBound(0, 0);
-    glm::ivec2 upperImageBound(influenceSize.x-1, influenceSize.y-1);
+    glm::ivec2 upperImageBound(bandSize.x-1, bandSize.y-1);
 
 
     size_t breakX=186;
     size_t breakY=168;
-    size_t breakIndex=breakY*influenceSize.x+breakX;
+    size_t breakIndex=breakY*bandSize.x+breakX;
     size_t loops=10;
 
     std::vector<float> floodScale={0.25f, 0.5f, 0.25f};
+    WORLDGEN_TRACE_ZONE("moisture");
+
+    //the sweep is in place so row order matters, rows go in map order and moisture moves between map rows
+    //wrapping as for the whole map. A band holding map row 0 after wrapped halo rows starts there, moisture
+    //moved to rows outside the band is dropped.
+    int mapRowBegin=wrapRow(rowBegin, influenceSize.y);
+    int firstMapRow=wrapRow(-rowBegin, influenceSize.y);
+    size_t sweepStart=(firstMapRow<bandSize.y)?firstMapRow:0;
+
     for(size_t loop=0; loop<loops; ++loop)
     {
 //        std::vector<float> &map1=*mapPointer1;
 //        std::vector<float> &map2=*mapPointer2;
 
-        size_t i=0;
-        for(size_t y=0; y<influenceSize.y; y++)
+        for(size_t row=0; row<bandSize.y; row++)
         {
-            for(size_t x=0; x<influenceSize.x; x++)
+            if(progress.cancelled())
+                return false;
+
+            size_t y=(sweepStart+row)%bandSize.y;
+            int mapY=wrapRow(mapRowBegin+(int)y, influenceSize.y);
+            size_t i=y*bandSize.x;
+
+            for(size_t x=0; x<bandSize.x; x++)
             {
                 if((x==breakX)&&(y>=breakY))
                     x=x;
 
                 if(map1[i]>0.0f)
                 {
-                    glm::vec2 &airDirection=m_influenceMap[i].airDirection;
+                    glm::vec2 &airDirection=cells[i].airDirection;
                     float magnitude=glm::length(airDirection);
                     float moisture=moistureDeltaMap[i];// map1[i];
-                    float moistureCaptured=moisture*m_influenceMap[i].moistureCapacity*magnitude;
+                    float moistureCaptured=moisture*cells[i].moistureCapacity*magnitude;
 
-                    if(m_influenceMap[i].heightBase>0.5f)
+                    if(cells[i].heightBase>0.5f)
                         moistureDeltaMap[i]=moistureDeltaMap[i]-moistureCaptured;
 
-                    fillPoints(glm::vec2(x, y), airDirection, moistureDeltaMap, influenceSize, moistureCaptured);
+                    fillPoints(glm::ivec2((int)x, mapY), airDirection, moistureDeltaMap, influenceSize, moistureCaptured, mapRowBegin, bandSize.y);
 //                    const std::array<glm::ivec2, 3> &floodPoints=getFloodPoints(airDirection);
                 }
                 ++i;
@@ -1061,7 +2261,7 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
         }
 
         //remove moisture that was moved
-//        for(size_t i=0; i<influenceMapSize; i++)
+//        for(size_t i=0; i<cellCount; i++)
 //        {
 //            if(i==breakIndex)
 //                i=i;
@@ -1073,19 +2273,14 @@ void EquiRectWorldGenerator::generatePlates(Progress &progress)
 //        std::swap(mapPointer1, mapPointer2);
     }
 
-    for(size_t i=0; i<influenceMapSize; i++)
+    for(size_t i=0; i<cellCount; i++)
     {
 //        std::vector<float> &map=*mapPointer1;
         
-        m_influenceMap[i].moisture=std::max(std::min(map1[i]+moistureDeltaMap[i], 1.0f), 0.0f);
+        cells[i].moisture=std::max(std::min(map1[i]+moistureDeltaMap[i], 1.0f), 0.0f);
     }
-
-    time2=chrono::high_resolution_clock::now();
-    processingTime=chrono::duration_cast<chrono::milliseconds>(time2-time1).count();
-
-    m_plateCount=plates.size();
-
-//    updateInfluenceNeighbors();
+    traceCellsProcessed().add((int64_t)cellCount);
+    return true;
 }
 
 
@@ -1135,6 +2330,8 @@ inline int getBlockType<true>(int z, size_t columnHeight, size_t stride)
 
 unsigned int EquiRectWorldGenerator::generateChunk(const glm::vec3 &startPos, const glm::ivec3 &chunkSize, void *buffer, size_t bufferSize, size_t lod)
 {
+    WORLDGEN_TRACE_ZONE("generateChunk");
+
 //    if(!m_threadStorage.vectorSet)
 //        m_threadStorage.vectorSet=std::make_unique<HastyNoise::VectorSet>(m_simdLevel);
 //    
@@ -1261,6 +2458,8 @@ unsigned int EquiRectWorldGenerator::generateChunk(const glm::vec3 &startPos, co
 
 unsigned int EquiRectWorldGenerator::generateRegion(const glm::vec3 &startPos, const glm::ivec3 &regionSize, void *buffer, size_t bufferSize, size_t lod)
 {
+    WORLDGEN_TRACE_ZONE("generateRegion");
+
 //    if(!m_threadStorage.regionVectorSet)
 //        m_threadStorage.regionVectorSet=std::make_unique<HastyNoise::VectorSet>(m_simdLevel);
 //
@@ -1335,18 +2534,64 @@ unsigned int EquiRectWorldGenerator::generateRegion(const glm::vec3 &startPos, c
 
 int EquiRectWorldGenerator::getBaseHeight(const glm::vec2 &pos)
 {
-    glm::ivec2 influenceIPos=glm::ivec2(pos)/m_descriptorValues.m_influenceGridSize;
-    glm::vec2 influenceOffset=pos-glm::vec2(influenceIPos*m_descriptorValues.m_influenceGridSize);
-    size_t influenceIndex=((influenceIPos.y*m_descriptorValues.m_influenceSize.x)+influenceIPos.x);
-    float *neighborHeight=&m_influenceNeighborMap[influenceIndex*NeighborCount];
+    glm::ivec3 size=m_descriptors.getSize();
+
+    if(!isReady())
+    {
+        std::shared_ptr<const OverviewPreview> preview=std::atomic_load(&m_preview);
+
+        if(preview)
+            return sampleBaseHeight(preview->influenceNeighborMap, preview->influenceSize, preview->influenceGridSize, size.z, pos);
+
+        //no preview yet, wait on the full data
+        waitReady();
+    }
+
+    return sampleBaseHeight(m_influenceNeighborMap, m_descriptorValues.m_influenceSize, m_descriptorValues.m_influenceGridSize, size.z, pos);
+}
+
+
+void EquiRectWorldGenerator::getBaseHeights(const glm::vec2 *positions, int *heights, size_t count)
+{
+    WORLDGEN_TRACE_ZONE("getBaseHeights");
 
-    glm::vec2 influencePos=influenceOffset/glm::vec2(m_descriptorValues.m_influenceGridSize);
     glm::ivec3 size=m_descriptors.getSize();
 
-    float scale=1.0f/3.0f;
+    if(!isReady())
+    {
+        std::shared_ptr<const OverviewPreview> preview=std::atomic_load(&m_preview);
+
+        if(preview)
+        {
+            for(size_t i=0; i<count; ++i)
+                heights[i]=sampleBaseHeight(preview->influenceNeighborMap, preview->influenceSize, preview->influenceGridSize, size.z, positions[i]);
+            return;
+        }
+
+        waitReady();
+    }
+
+    for(size_t i=0; i<count; ++i)
+        heights[i]=sampleBaseHeight(m_influenceNeighborMap, m_descriptorValues.m_influenceSize, m_descriptorValues.m_influenceGridSize, size.z, positions[i]);
+}
+
+
+int EquiRectWorldGenerator::sampleBaseHeight(const std::vector<float> &influenceNeighborMap, const glm::ivec2 &influenceSize, const glm::ivec2 &influenceGridSize, int worldHeight, const glm::vec2 &pos)
+{
+    //a cancelled or failed load releases the maps
+    if(influenceNeighborMap.empty())
+        return 0;
+
+    glm::ivec2 influenceIPos=glm::ivec2(pos)/influenceGridSize;
+    glm::vec2 influenceOffset=pos-glm::vec2(influenceIPos*influenceGridSize);
+    size_t influenceIndex=((influenceIPos.y*influenceSize.x)+influenceIPos.x);
+    const float *neighborHeight=&influenceNeighborMap[influenceIndex*NeighborCount];
+
+    glm::vec2 influencePos=influenceOffset/glm::vec2(influenceGridSize);
+
     float heightBase=bi_lerp(neighborHeight[0], neighborHeight[1], neighborHeight[2], neighborHeight[3], influencePos.x, influencePos.y);
 
-    return heightBase*(float)size.z;
+    return heightBase*(float)worldHeight;
 }
 
 //
@@ -1448,6 +2693,8 @@ void EquiRectWorldGenerator::buildHeightMap(const glm::vec3 &startPos, const glm
 
 void EquiRectWorldGenerator::updateInfluenceNeighbors()
 {
+    WORLDGEN_TRACE_ZONE("updateInfluenceNeighbors");
+
     if(m_influenceNeighborMap.size()/NeighborCount!= m_influenceMap.size())
         m_influenceNeighborMap.resize(m_influenceMap.size()*NeighborCount);
 
@@ -1480,7 +2727,195 @@ void EquiRectWorldGenerator::updateInfluenceNeighbors()
         }
     }
 
+    updatePlateIndex();
+}
+
+
+void EquiRectWorldGenerator::updatePlateIndex()
+{
+    WORLDGEN_TRACE_ZONE("updatePlateIndex");
+
+    glm::ivec2 influenceSize=m_descriptorValues.m_influenceSize;
+
+    if(m_descriptorValues.m_plateAssignment==PlateAssignment::Seeded)
+    {
+        //the raster took the closest seed to each warped position, the index holds the seeds themselves and
+        //queries are warped the same way (see warpPlatePoints)
+        m_hidden->build(m_descriptorValues);
+
+        const PlateSeeds &seeds=m_hidden->plateSeeds(m_descriptorValues.m_plateCount, m_plateSeed);
+        std::vector<float> values;
+        std::vector<uint32_t> valuePlates;
+        float last=-2.0f;
+
+        //plate values to tectonicPlate, seeds no cell ended up closest to are left out like the raster does
+        for(const InfluenceCell &cell:m_influenceMap)
+        {
+            if(cell.plateValue==last)
+                continue;
+
+            last=cell.plateValue;
+            if(std::find(values.begin(), values.end(), last)==values.end())
+            {
+                values.push_back(last);
+                valuePlates.push_back((uint32_t)cell.tectonicPlate);
+            }
+        }
+
+        std::vector<glm::vec3> points;
+        std::vector<uint32_t> plates;
+
+        for(size_t i=0; i<seeds.size(); ++i)
+        {
+            size_t value=std::find(values.begin(), values.end(), seeds.values()[i])-values.begin();
+
+            if(value<values.size())
+            {
+                points.push_back(seeds.positions()[i]);
+                plates.push_back(valuePlates[value]);
+            }
+        }
+
+        if(points.empty())
+            m_plateIndex.clear();
+        else
+            m_plateIndex.build(points, plates);
+        return;
+    }
+
+    std::vector<float> minDistance;
+    std::vector<glm::ivec2> minPoint;
+
+    //same points as PlateStatistics, the first cell in row order with the lowest plate distance
+    for(int y=0; y<influenceSize.y; ++y)
+    {
+        for(int x=0; x<influenceSize.x; ++x)
+        {
+            const InfluenceCell &cell=m_influenceMap[(size_t)y*influenceSize.x+x];
+            size_t plate=cell.tectonicPlate;
+
+            if(plate>=minDistance.size())
+            {
+                minDistance.resize(plate+1, 2.0f);
+                minPoint.resize(plate+1, glm::ivec2(0, 0));
+            }
+
+            if(cell.plateDistanceValue<minDistance[plate])
+            {
+                minDistance[plate]=cell.plateDistanceValue;
+                minPoint[plate]=glm::ivec2(x, y);
+            }
+        }
+    }
+
+    std::vector<glm::vec3> points(minPoint.size());
+
+    for(size_t i=0; i<minPoint.size(); ++i)
+    {
+        glm::vec2 mapPoint((float)minPoint[i].x/(float)influenceSize.x, (float)minPoint[i].y/(float)influenceSize.y);
+
+        projectPoint<Projections::Equirectangular, Projections::Cartesian>(mapPoint, points[i]);
+    }
+
+    if(points.empty())
+        m_plateIndex.clear();
+    else
+        m_plateIndex.build(points);
+}
+
+
+glm::vec3 EquiRectWorldGenerator::worldToSphere(const glm::vec2 &pos) const
+{
+    glm::vec2 mapSize=glm::vec2(m_descriptorValues.m_influenceSize*m_descriptorValues.m_influenceGridSize);
+    glm::vec2 mapPoint=pos/mapSize;
+    glm::vec3 point;
+
+    projectPoint<Projections::Equirectangular, Projections::Cartesian>(mapPoint, point);
+    return point;
+}
+
+
+void EquiRectWorldGenerator::warpPlatePoints(const glm::vec2 *positions, size_t count, glm::vec3 *points) const
+{
+    const glm::ivec2 &influenceSize=m_descriptorValues.m_influenceSize;
+    glm::vec2 gridSize=glm::vec2(m_descriptorValues.m_influenceGridSize);
+    float radius=influenceSize.x/2.0f;
+    float amplitude=PlateWarpAmplitude*m_hidden->m_plateSeeds.spacing();
+    std::vector<float> x(count), y(count), z(count);
+    std::vector<float> warpX(count), warpY(count), warpZ(count);
+
+    //same coordinates generateCoordinates gives a cell, with x and y swapped for fastnoise
+    for(size_t i=0; i<count; ++i)
+    {
+        glm::vec2 cell=positions[i]/gridSize;
+        glm::vec3 point=getSphericalCoords(influenceSize.x, influenceSize.y, glm::vec3(cell.x, cell.y, radius));
+
+        x[i]=point.y;
+        y[i]=point.x;
+        z[i]=point.z;
+    }
+
+    const FastNoise::Generator *warpNoise=m_hidden->m_plateWarpNoise.get();
+
+    warpNoise->GenPositionArray3D(warpX.data(), (int)count, x.data(), y.data(), z.data(), 0.0f, 0.0f, 0.0f, m_plateSeed+5);
+    warpNoise->GenPositionArray3D(warpY.data(), (int)count, x.data(), y.data(), z.data(), 0.0f, 0.0f, 0.0f, m_plateSeed+6);
+    warpNoise->GenPositionArray3D(warpZ.data(), (int)count, x.data(), y.data(), z.data(), 0.0f, 0.0f, 0.0f, m_plateSeed+7);
+
+    for(size_t i=0; i<count; ++i)
+        points[i]=glm::vec3(x[i]/radius+amplitude*warpX[i], y[i]/radius+amplitude*warpY[i], z[i]/radius+amplitude*warpZ[i]);
+}
+
+
+PlateQuery EquiRectWorldGenerator::getPlate(const glm::vec2 &pos)
+{
+    if(!isReady())
+        waitReady();
+
+    if(m_plateIndex.empty())
+        return PlateQuery{0, 0};
+
+    if(m_descriptorValues.m_plateAssignment==PlateAssignment::Seeded)
+    {
+        glm::vec3 point;
+
+        warpPlatePoints(&pos, 1, &point);
+        return m_plateIndex.nearest2(point);
+    }
+    return m_plateIndex.nearest2(worldToSphere(pos));
+}
+
+
+void EquiRectWorldGenerator::getPlates(const glm::vec2 *positions, PlateQuery *queries, size_t count, ThreadPool *pool)
+{
+    WORLDGEN_TRACE_ZONE("getPlates");
+
+    if(!isReady())
+        waitReady();
+
+    if(m_plateIndex.empty())
+    {
+        std::fill(queries, queries+count, PlateQuery{0, 0});
+        return;
+    }
+
+    std::vector<glm::vec3> points(count);
+
+    if(m_descriptorValues.m_plateAssignment==PlateAssignment::Seeded)
+        warpPlatePoints(positions, count, points.data());
+    else
+    {
+        for(size_t i=0; i<count; ++i)
+            points[i]=worldToSphere(positions[i]);
+    }
+    m_plateIndex.nearest2(points.data(), count, queries, pool);
 }
 
+template bool EquiRectWorldGenerator::load<StdFileIO>(WorldDescriptors *descriptors, const std::string &directory, Progress &progress);
+template bool EquiRectWorldGenerator::save<StdFileIO>(const std::string &directory);
+template std::shared_future<bool> EquiRectWorldGenerator::loadAsync<StdFileIO>(WorldDescriptors *descriptors, const std::string &directory, Progress &progress);
+template std::shared_future<bool> EquiRectWorldGenerator::saveAsync<StdFileIO>(const std::string &directory);
+template bool EquiRectWorldGenerator::generateShard<StdFileIO>(const ShardRange &range, const std::string &directory, Progress &progress);
+template bool EquiRectWorldGenerator::mergeShards<StdFileIO>(const ShardManifest &manifest, const std::string &directory, Progress &progress);
+
 }//namespace worldgen
 
@@ -0,0 +1,189 @@
+#include "worldgen/io/worldCache.h"
+
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <cstdio>
+
+namespace worldgen
+{
+
+namespace filesystem=std::filesystem;
+
+namespace
+{
+
+const char *StagingDirectory=".staging";
+
+bool isKeyName(const std::string &name)
+{
+    if(name.size()!=16)
+        return false;
+
+    return std::all_of(name.begin(), name.end(), [](char c) { return ((c>='0')&&(c<='9'))||((c>='a')&&(c<='f')); });
+}
+
+uint64_t directorySize(const filesystem::path &path)
+{
+    std::error_code error;
+    uint64_t size=0;
+
+    for(filesystem::recursive_directory_iterator iter(path, error), end; !error&&(iter!=end); iter.increment(error))
+    {
+        if(iter->is_regular_file(error))
+            size+=iter->file_size(error);
+    }
+    return size;
+}
+
+}//namespace
+
+WorldCache::WorldCache(const std::string &root, uint64_t maxBytes):
+    m_root(root),
+    m_maxBytes(maxBytes),
+    m_stagingIndex(0)
+{
+    std::random_device random;
+
+    m_token=((uint64_t)random()<<32)|random();
+}
+
+std::string WorldCache::keyName(uint64_t key)
+{
+    char name[17];
+
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return name;
+}
+
+std::string WorldCache::entryDirectory(uint64_t key) const
+{
+    return m_root+"/"+keyName(key);
+}
+
+std::string WorldCache::find(uint64_t key)
+{
+    std::string directory=entryDirectory(key);
+    std::error_code error;
+
+    if(!filesystem::is_directory(directory, error))
+        return std::string();
+
+    //the directory time is the lru stamp
+    filesystem::last_write_time(directory, filesystem::file_time_type::clock::now(), error);
+    return directory;
+}
+
+std::string WorldCache::stage(uint64_t key)
+{
+    uint64_t index;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        index=m_stagingIndex++;
+    }
+
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s-%016llx-%llu", keyName(key).c_str(), (unsigned long long)m_token, (unsigned long long)index);
+
+    std::string directory=m_root+"/"+StagingDirectory+"/"+name;
+    std::error_code error;
+
+    filesystem::remove_all(directory, error);
+    filesystem::create_directories(directory, error);
+    return directory;
+}
+
+std::string WorldCache::publish(uint64_t key, const std::string &stagingDirectory)
+{
+    std::string directory=entryDirectory(key);
+    std::error_code error;
+
+    filesystem::rename(stagingDirectory, directory, error);
+
+    if(error)
+    {
+        //lost the race to another bake of the same key, entries are content addressed so theirs is as good
+        abandon(stagingDirectory);
+
+        if(!filesystem::is_directory(directory, error))
+            return std::string();
+    }
+
+    filesystem::last_write_time(directory, filesystem::file_time_type::clock::now(), error);
+    trim(key);
+    return directory;
+}
+
+void WorldCache::abandon(const std::string &stagingDirectory)
+{
+    std::error_code error;
+
+    filesystem::remove_all(stagingDirectory, error);
+}
+
+void WorldCache::trim(uint64_t keep)
+{
+    if(m_maxBytes==0)
+        return;
+
+    struct Entry
+    {
+        filesystem::path path;
+        filesystem::file_time_type used;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    std::error_code error;
+    uint64_t total=0;
+    std::string keepName=keyName(keep);
+
+    for(filesystem::directory_iterator iter(m_root, error), end; !error&&(iter!=end); iter.increment(error))
+    {
+        std::string name=iter->path().filename().string();
+
+        if(!iter->is_directory(error)||!isKeyName(name))
+            continue;
+
+        Entry entry;
+
+        entry.path=iter->path();
+        entry.used=filesystem::last_write_time(entry.path, error);
+        entry.size=directorySize(entry.path);
+        total+=entry.size;
+
+        if((keep!=0)&&(name==keepName))
+            continue;
+        entries.push_back(entry);
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used<b.used; });
+
+    for(const Entry &entry:entries)
+    {
+        if(total<=m_maxBytes)
+            break;
+
+        filesystem::remove_all(entry.path, error);
+        if(!error)
+            total-=entry.size;
+    }
+}
+
+uint64_t WorldCache::size() const
+{
+    std::error_code error;
+    uint64_t total=0;
+
+    for(filesystem::directory_iterator iter(m_root, error), end; !error&&(iter!=end); iter.increment(error))
+    {
+        if(iter->is_directory(error)&&isKeyName(iter->path().filename().string()))
+            total+=directorySize(iter->path());
+    }
+    return total;
+}
+
+}//namespace worldgen
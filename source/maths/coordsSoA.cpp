@@ -0,0 +1,183 @@
+#include "worldgen/maths/coordsSoA.h"
+#include "worldgen/maths/fastMath.h"
+
+#include <vector>
+#include <cmath>
+
+namespace worldgen
+{
+
+namespace
+{
+
+constexpr float pi=3.14159265358979f;
+constexpr float halfPi=1.57079632679490f;
+constexpr float twoPi=6.28318530717959f;
+
+}//namespace
+
+//outputs never alias the inputs, __restrict lets the compiler vectorize without runtime overlap checks
+void equirectangularToSpherical(const float *__restrict u, const float *__restrict v, float *__restrict theta, float *__restrict phi, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        theta[i]=twoPi*u[i];
+        phi[i]=halfPi-(pi*v[i]);
+    }
+}
+
+void sphericalToEquirectangular(const float *__restrict theta, const float *__restrict phi, float *__restrict u, float *__restrict v, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        u[i]=theta[i]/twoPi;
+        v[i]=(halfPi-phi[i])/pi;
+    }
+}
+
+void sphericalToCartesian(const float *__restrict radius, const float *__restrict theta, const float *__restrict phi, float *__restrict x, float *__restrict y, float *__restrict z, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float sinTheta, cosTheta;
+        float sinPhi, cosPhi;
+
+        fastSinCos(theta[i], sinTheta, cosTheta);
+        fastSinCos(phi[i], sinPhi, cosPhi);
+
+        float d=radius[i]*cosPhi;
+
+        x[i]=d*cosTheta;
+        y[i]=d*sinTheta;
+        z[i]=radius[i]*sinPhi;
+    }
+}
+
+void sphericalToCartesian(float radius, const float *__restrict theta, const float *__restrict phi, float *__restrict x, float *__restrict y, float *__restrict z, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float sinTheta, cosTheta;
+        float sinPhi, cosPhi;
+
+        fastSinCos(theta[i], sinTheta, cosTheta);
+        fastSinCos(phi[i], sinPhi, cosPhi);
+
+        float d=radius*cosPhi;
+
+        x[i]=d*cosTheta;
+        y[i]=d*sinTheta;
+        z[i]=radius*sinPhi;
+    }
+}
+
+void cartesianToSpherical(const float *__restrict x, const float *__restrict y, const float *__restrict z, float *__restrict radius, float *__restrict theta, float *__restrict phi, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float d=std::sqrt((x[i]*x[i])+(y[i]*y[i]));
+        float azimuth=fastAtan2(y[i], x[i]);
+
+        radius[i]=std::sqrt((d*d)+(z[i]*z[i]));
+        theta[i]=(azimuth<0.0f)?azimuth+twoPi:azimuth;
+        phi[i]=fastAtan2(z[i], d);
+    }
+}
+
+void equirectangularToCartesian(const float *__restrict u, const float *__restrict v, float radius, float *__restrict x, float *__restrict y, float *__restrict z, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float sinTheta, cosTheta;
+        float sinPhi, cosPhi;
+
+        fastSinCos(twoPi*u[i], sinTheta, cosTheta);
+        fastSinCos(halfPi-(pi*v[i]), sinPhi, cosPhi);
+
+        float d=radius*cosPhi;
+
+        x[i]=d*cosTheta;
+        y[i]=d*sinTheta;
+        z[i]=radius*sinPhi;
+    }
+}
+
+void cartesianToEquirectangular(const float *__restrict x, const float *__restrict y, const float *__restrict z, float *__restrict u, float *__restrict v, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float d=std::sqrt((x[i]*x[i])+(y[i]*y[i]));
+        float azimuth=fastAtan2(y[i], x[i]);
+
+        u[i]=((azimuth<0.0f)?azimuth+twoPi:azimuth)/twoPi;
+        v[i]=(halfPi-fastAtan2(z[i], d))/pi;
+    }
+}
+
+void cartesianToStereographic(const float *__restrict x, const float *__restrict y, const float *__restrict z, float *__restrict sx, float *__restrict sy, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float d=(1.0f-z[i]);
+
+        sx[i]=x[i]/d;
+        sy[i]=y[i]/d;
+    }
+}
+
+void stereographicToCartesian(const float *__restrict sx, const float *__restrict sy, float *__restrict x, float *__restrict y, float *__restrict z, size_t count)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        float d=(1.0f+sx[i]*sx[i]+sy[i]*sy[i]);
+
+        x[i]=(2.0f*sx[i])/d;
+        y[i]=(2.0f*sy[i])/d;
+        z[i]=(-2.0f+d)/d;
+    }
+}
+
+void getSphericalCoords(size_t width, size_t height, size_t columns, const float *__restrict rows, size_t rowCount, float radius,
+    float *__restrict x, float *__restrict y, float *__restrict z)
+{
+    std::vector<float> cosTheta(columns);
+    std::vector<float> sinTheta(columns);
+
+    //same operations as getSphericalCoords so the grid is bit identical to it
+    for(size_t column=0; column<columns; ++column)
+    {
+        float theta=twoPi*((float)column/width);
+
+        cosTheta[column]=std::cos(theta);
+        sinTheta[column]=std::sin(theta);
+    }
+
+    size_t index=0;
+
+    for(size_t row=0; row<rowCount; ++row)
+    {
+        float phi=halfPi-(pi*(rows[row]/height));
+        float rowZ=radius*std::sin(phi);
+        float d=radius*std::cos(phi);
+
+        for(size_t column=0; column<columns; ++column)
+        {
+            x[index+column]=d*cosTheta[column];
+            y[index+column]=d*sinTheta[column];
+            z[index+column]=rowZ;
+        }
+        index+=columns;
+    }
+}
+
+void getSphericalCoords(size_t width, size_t height, int rowBegin, int rowEnd, float radius, float *x, float *y, float *z)
+{
+    std::vector<float> rows;
+
+    for(int row=rowBegin; row<rowEnd; ++row)
+        rows.push_back((float)row);
+
+    getSphericalCoords(width, height, width, rows.data(), rows.size(), radius, x, y, z);
+}
+
+}//namespace worldgen
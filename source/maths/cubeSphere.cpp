@@ -0,0 +1,232 @@
+#include "worldgen/maths/cubeSphere.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace worldgen
+{
+
+namespace
+{
+
+constexpr float QuarterPi=0.785398163397448f;
+
+//outward normal and the face's x and y axes, x cross y is the normal
+struct CubeFaceFrame
+{
+    glm::vec3 normal;
+    glm::vec3 xAxis;
+    glm::vec3 yAxis;
+};
+
+const CubeFaceFrame CubeFaces[CubeFaceCount]=
+{
+    {{ 1.0f,  0.0f,  0.0f}, { 0.0f,  1.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}},
+    {{-1.0f,  0.0f,  0.0f}, { 0.0f, -1.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}},
+    {{ 0.0f,  1.0f,  0.0f}, {-1.0f,  0.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}},
+    {{ 0.0f, -1.0f,  0.0f}, { 1.0f,  0.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}},
+    {{ 0.0f,  0.0f,  1.0f}, { 0.0f,  1.0f,  0.0f}, {-1.0f,  0.0f,  0.0f}},
+    {{ 0.0f,  0.0f, -1.0f}, { 0.0f,  1.0f,  0.0f}, { 1.0f,  0.0f,  0.0f}}
+};
+
+//face whose normal is the given axis, axis is one of the face normals
+int faceOfAxis(const glm::vec3 &axis)
+{
+    if(axis.x!=0.0f)
+        return (axis.x>0.0f)?0:1;
+    if(axis.y!=0.0f)
+        return (axis.y>0.0f)?2:3;
+    return (axis.z>0.0f)?4:5;
+}
+
+//solid angle of the gnomonic rectangle from the face center to (x, y), x and y are tangents
+double cornerSolidAngle(double x, double y)
+{
+    return std::atan2(x*y, std::sqrt(1.0+x*x+y*y));
+}
+
+}//namespace
+
+CubeSphereGrid::CubeSphereGrid():
+    m_faceSize(0),
+    m_tileSize(1),
+    m_tilesPerRow(0)
+{
+}
+
+void CubeSphereGrid::build(int faceSize, int tileSize)
+{
+    m_tileSize=std::max(tileSize, 1);
+    m_faceSize=std::max((faceSize+m_tileSize-1)/m_tileSize, 1)*m_tileSize;
+    m_tilesPerRow=m_faceSize/m_tileSize;
+
+    size_t count=(size_t)CubeFaceCount*m_faceSize*m_faceSize;
+
+    m_centers.resize(count);
+    m_neighbors.resize(count*CellNeighborCount);
+
+    for(int face=0; face<CubeFaceCount; ++face)
+    {
+        for(int y=0; y<m_faceSize; ++y)
+        {
+            for(int x=0; x<m_faceSize; ++x)
+            {
+                size_t cellIndex=index(face, x, y);
+                uint32_t *neighbors=&m_neighbors[cellIndex*CellNeighborCount];
+                int i=0;
+
+                m_centers[cellIndex]=direction(face, (float)x+0.5f, (float)y+0.5f);
+
+                for(int dy=-1; dy<=1; ++dy)
+                {
+                    for(int dx=-1; dx<=1; ++dx)
+                    {
+                        if((dx!=0)||(dy!=0))
+                            neighbors[i++]=neighbor(face, x, y, dx, dy);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CubeSphereGrid::clear()
+{
+    m_faceSize=0;
+    m_tilesPerRow=0;
+    m_centers.clear();
+    m_neighbors.clear();
+}
+
+size_t CubeSphereGrid::index(int face, int x, int y) const
+{
+    size_t tile=(size_t)(y/m_tileSize)*m_tilesPerRow+(x/m_tileSize);
+    size_t tileCell=(size_t)(y%m_tileSize)*m_tileSize+(x%m_tileSize);
+
+    return ((size_t)face*m_faceSize*m_faceSize)+tile*m_tileSize*m_tileSize+tileCell;
+}
+
+CubeCell CubeSphereGrid::cell(size_t index) const
+{
+    size_t faceCells=(size_t)m_faceSize*m_faceSize;
+    size_t tileCells=(size_t)m_tileSize*m_tileSize;
+    size_t faceIndex=index%faceCells;
+    size_t tile=faceIndex/tileCells;
+    size_t tileCell=faceIndex%tileCells;
+    CubeCell cell;
+
+    cell.face=(int)(index/faceCells);
+    cell.x=(int)((tile%m_tilesPerRow)*m_tileSize+tileCell%m_tileSize);
+    cell.y=(int)((tile/m_tilesPerRow)*m_tileSize+tileCell/m_tileSize);
+    return cell;
+}
+
+glm::vec3 CubeSphereGrid::direction(int face, float x, float y) const
+{
+    const CubeFaceFrame &frame=CubeFaces[face];
+    //face coordinates to angles from the face center, -pi/4 to pi/4 across the face
+    float u=std::tan(QuarterPi*(2.0f*x/m_faceSize-1.0f));
+    float v=std::tan(QuarterPi*(2.0f*y/m_faceSize-1.0f));
+
+    return glm::normalize(frame.normal+u*frame.xAxis+v*frame.yAxis);
+}
+
+glm::vec2 CubeSphereGrid::faceCoords(int face, const glm::vec3 &direction) const
+{
+    const CubeFaceFrame &frame=CubeFaces[face];
+    float along=glm::dot(direction, frame.normal);
+    float u=std::atan2(glm::dot(direction, frame.xAxis), along)/QuarterPi;
+    float v=std::atan2(glm::dot(direction, frame.yAxis), along)/QuarterPi;
+
+    return glm::vec2((u+1.0f)*0.5f*m_faceSize, (v+1.0f)*0.5f*m_faceSize);
+}
+
+int CubeSphereGrid::locate(const glm::vec3 &direction, glm::vec2 &coords) const
+{
+    glm::vec3 magnitude(std::abs(direction.x), std::abs(direction.y), std::abs(direction.z));
+    int face;
+
+    //ties on the edges go to x, then y
+    if((magnitude.x>=magnitude.y)&&(magnitude.x>=magnitude.z))
+        face=(direction.x>=0.0f)?0:1;
+    else if(magnitude.y>=magnitude.z)
+        face=(direction.y>=0.0f)?2:3;
+    else
+        face=(direction.z>=0.0f)?4:5;
+
+    coords=faceCoords(face, direction);
+    return face;
+}
+
+size_t CubeSphereGrid::cellIndex(const glm::vec3 &direction) const
+{
+    glm::vec2 coords;
+    int face=locate(direction, coords);
+    int x=std::min(std::max((int)coords.x, 0), m_faceSize-1);
+    int y=std::min(std::max((int)coords.y, 0), m_faceSize-1);
+
+    return index(face, x, y);
+}
+
+uint32_t CubeSphereGrid::neighbor(int face, int x, int y, int dx, int dy) const
+{
+    int nx=x+dx;
+    int ny=y+dy;
+    bool outX=(nx<0)||(nx>=m_faceSize);
+    bool outY=(ny<0)||(ny>=m_faceSize);
+
+    if(!outX&&!outY)
+        return (uint32_t)index(face, nx, ny);
+
+    //Across an edge: the point on the edge in line with the neighbor is on both faces at the same angle, so
+    //the cell next to the edge on the other face is found from that point rather than from the neighbor's
+    //center, which would drift up to half a cell off the row near the corners. Past a cube corner (both out)
+    //the cell over the x edge is used, there is no diagonal cell there.
+    const CubeFaceFrame &frame=CubeFaces[face];
+    glm::vec3 edgePoint;
+    glm::vec3 axis;
+
+    if(outX)
+    {
+        float along=(float)std::min(std::max(ny, 0), m_faceSize-1)+0.5f;
+
+        edgePoint=direction(face, (nx<0)?0.0f:(float)m_faceSize, along);
+        axis=(nx<0)?-frame.xAxis:frame.xAxis;
+    }
+    else
+    {
+        edgePoint=direction(face, (float)nx+0.5f, (ny<0)?0.0f:(float)m_faceSize);
+        axis=(ny<0)?-frame.yAxis:frame.yAxis;
+    }
+
+    int otherFace=faceOfAxis(axis);
+    glm::vec2 coords=faceCoords(otherFace, edgePoint);
+    int otherX=std::min(std::max((int)std::floor(coords.x), 0), m_faceSize-1);
+    int otherY=std::min(std::max((int)std::floor(coords.y), 0), m_faceSize-1);
+
+    return (uint32_t)index(otherFace, otherX, otherY);
+}
+
+float CubeSphereGrid::area(size_t index) const
+{
+    CubeCell cubeCell=cell(index);
+    double scale=2.0/m_faceSize;
+    double x0=std::tan(QuarterPi*(scale*cubeCell.x-1.0));
+    double x1=std::tan(QuarterPi*(scale*(cubeCell.x+1)-1.0));
+    double y0=std::tan(QuarterPi*(scale*cubeCell.y-1.0));
+    double y1=std::tan(QuarterPi*(scale*(cubeCell.y+1)-1.0));
+
+    return (float)(cornerSolidAngle(x1, y1)-cornerSolidAngle(x0, y1)-cornerSolidAngle(x1, y0)+cornerSolidAngle(x0, y0));
+}
+
+void CubeSphereGrid::positions(float radius, float *x, float *y, float *z) const
+{
+    for(size_t i=0; i<m_centers.size(); ++i)
+    {
+        x[i]=m_centers[i].x*radius;
+        y[i]=m_centers[i].y*radius;
+        z[i]=m_centers[i].z*radius;
+    }
+}
+
+}//namespace worldgen
@@ -0,0 +1,60 @@
+#include "worldgen/noiseNodes.h"
+
+namespace worldgen
+{
+
+FastNoise::SmartNode<> newFractalNoise(float scale, bool warp, FastSIMD::eLevel simdLevel)
+{
+    FastNoise::SmartNode<FastNoise::OpenSimplex2> os2Noise=FastNoise::New<FastNoise::OpenSimplex2>(simdLevel);
+    FastNoise::SmartNode<FastNoise::DomainScale> domainScale=FastNoise::New<FastNoise::DomainScale>(simdLevel);
+    FastNoise::SmartNode<FastNoise::FractalFBm> fractalFbmNoise=FastNoise::New<FastNoise::FractalFBm>(simdLevel);
+
+    domainScale->SetSource(os2Noise);
+    domainScale->SetScale(scale);
+
+    if(warp)
+    {
+        FastNoise::SmartNode<FastNoise::DomainWarpGradient> domainWarp=FastNoise::New<FastNoise::DomainWarpGradient>(simdLevel);
+
+        domainWarp->SetSource(domainScale);
+        domainWarp->SetWarpAmplitude(0.5f);
+        domainWarp->SetWarpFrequency(1.0f);
+        fractalFbmNoise->SetSource(domainWarp);
+    }
+    else
+        fractalFbmNoise->SetSource(domainScale);
+
+    fractalFbmNoise->SetGain(0.5f);
+    fractalFbmNoise->SetOctaveCount(4);
+    fractalFbmNoise->SetLacunarity(2.0f);
+    return fractalFbmNoise;
+}
+
+FastNoise::SmartNode<> newWarpedCellular(const FastNoise::SmartNode<> &cellular, float frequency, FastSIMD::eLevel simdLevel)
+{
+    FastNoise::SmartNode<FastNoise::DomainWarpGradient> domainWarp=FastNoise::New<FastNoise::DomainWarpGradient>(simdLevel);
+    FastNoise::SmartNode<FastNoise::DomainWarpFractalIndependant> domainWarpFractal=FastNoise::New<FastNoise::DomainWarpFractalIndependant>(simdLevel);
+    FastNoise::SmartNode<FastNoise::DomainScale> domainScale=FastNoise::New<FastNoise::DomainScale>(simdLevel);
+
+    domainWarp->SetSource(cellular);
+    domainWarp->SetWarpAmplitude(0.5f);
+    domainWarp->SetWarpFrequency(1.0f);
+    domainWarpFractal->SetSource(domainWarp);
+    domainWarpFractal->SetGain(0.5f);
+    domainWarpFractal->SetOctaveCount(5);
+    domainWarpFractal->SetLacunarity(2.0f);
+    domainScale->SetSource(domainWarpFractal);
+    domainScale->SetScale(frequency);
+    return domainScale;
+}
+
+FastNoise::SmartNode<> newCellularValue(int valueIndex, FastSIMD::eLevel simdLevel)
+{
+    FastNoise::SmartNode<FastNoise::CellularValue> cellularNoise=FastNoise::New<FastNoise::CellularValue>(simdLevel);
+
+    cellularNoise->SetDistanceFunction(FastNoise::DistanceFunction::Hybrid);
+    cellularNoise->SetValueIndex(valueIndex);
+    return cellularNoise;
+}
+
+}//namespace worldgen
@@ -1,19 +1,22 @@
 #include "worldgen/perturbedWeather.h"
+#include "worldgen/maths/coordsSoA.h"
+
 #include <fastnoise/FastNoise.h>
 
 namespace worldgen
 {
 
-PerturbedWeatherBands::PerturbedWeatherBands(int seed, const glm::ivec2 &size, std::vector<WeatherCell> cells):
+PerturbedWeatherBands::PerturbedWeatherBands(int seed, const glm::ivec2 &size, std::vector<WeatherCell> cells, SimdLevel simdLevel):
     WeatherBands(cells),
     m_size(size)
 {
 //        size_t simdLevel=HastyNoise::GetFastestSIMD();
 //        std::unique_ptr<HastyNoise::NoiseSIMD> noise=HastyNoise::CreateNoise(seed, simdLevel);
-    FastNoise::SmartNode<FastNoise::OpenSimplex2> noise=FastNoise::New<FastNoise::OpenSimplex2>();
-    FastNoise::SmartNode<FastNoise::DomainScale> noiseScale=FastNoise::New<FastNoise::DomainScale>();
-    FastNoise::SmartNode<FastNoise::DomainWarpGradient> noiseWarp=FastNoise::New<FastNoise::DomainWarpGradient>();
-    FastNoise::SmartNode<FastNoise::DomainWarpFractalIndependant> noiseWarpFractal=FastNoise::New<FastNoise::DomainWarpFractalIndependant>();
+    FastSIMD::eLevel fastSimdLevel=(FastSIMD::eLevel)toFastSimdLevel(simdLevel);
+    FastNoise::SmartNode<FastNoise::OpenSimplex2> noise=FastNoise::New<FastNoise::OpenSimplex2>(fastSimdLevel);
+    FastNoise::SmartNode<FastNoise::DomainScale> noiseScale=FastNoise::New<FastNoise::DomainScale>(fastSimdLevel);
+    FastNoise::SmartNode<FastNoise::DomainWarpGradient> noiseWarp=FastNoise::New<FastNoise::DomainWarpGradient>(fastSimdLevel);
+    FastNoise::SmartNode<FastNoise::DomainWarpFractalIndependant> noiseWarpFractal=FastNoise::New<FastNoise::DomainWarpFractalIndependant>(fastSimdLevel);
 
     glm::ivec2 noiseSize(size.x, m_cells.size()-1);
 //        int noiseVectorSize=HastyNoise::AlignedSize(noiseSize.x*noiseSize.y, simdLevel);
@@ -34,28 +37,13 @@ PerturbedWeatherBands::PerturbedWeatherBands(int seed, const glm::ivec2 &size, s
 
     size_t mapSize=size.x*size.y;
 
-    glm::vec3 mapPos;
-    size_t index=0;
-    mapPos.z=(float)(noiseSize.x/2.0f);
+    std::vector<float> rows(noiseSize.y);
+
     for(int y=0; y<noiseSize.y; y++)
-    {
-        mapPos.y=(size.y/2)-floor(m_cells[y].upperLatitude*((float)size.y/glm::pi<float>()));
-        for(int x=0; x<noiseSize.x; x++)
-        {
-            mapPos.x=x;
-            glm::vec3 pos=getSphericalCoords(size.x, size.y, mapPos);
-
-            //fastnoise treats x and y in reverse
-            xPos[index]=pos.y;
-            yPos[index]=pos.x;
-            zPos[index]=pos.z;
-
-//                noiseSet->xSet[index]=pos.y;
-//                noiseSet->ySet[index]=pos.x;
-//                noiseSet->zSet[index]=pos.z;
-            index++;
-        }
-    }
+        rows[y]=(size.y/2)-floor(m_cells[y].upperLatitude*((float)size.y/glm::pi<float>()));
+
+    //fastnoise treats x and y in reverse
+    getSphericalCoords(size.x, size.y, noiseSize.x, rows.data(), rows.size(), (float)(noiseSize.x/2.0f), yPos.data(), xPos.data(), zPos.data());
 
 
 //        noise->SetNoiseType(HastyNoise::NoiseType::Perlin);
@@ -250,4 +238,24 @@ float PerturbedWeatherBands::getMoisture(const glm::vec2 &coord)
     }
 }
 
+std::vector<WeatherCell> getWeatherCells()
+{
+    return
+    {
+//        {"South Polar Cell"  , rads(-75.0f), rads(30.0f), 0.65f, { 0.0f,  1.0f}, {-1.0f,  0.0f}},
+//        {"South Ferrell Cell", rads(-45.0f), rads(30.0f), 0.75f , { 1.0f,  0.0f}, { 0.0f, -1.0f}},
+//        {"South Hadley Cell" , rads(-15.0f), rads(30.0f), 0.95f , { 0.0f,  1.0f}, {-1.0f,  0.0f}},
+//        {"Noth Hadley Cell"  , rads(15.0f) , rads(30.0f), 0.95f , {-1.0f,  0.0f}, { 0.0f, -1.0f}},
+//        {"North Ferrell Cell", rads(45.0f) , rads(30.0f), 0.74f , { 0.0f,  1.0f}, { 1.0f,  0.0f}},
+//        {"North Polar Cell"  , rads(75.0f) , rads(30.0f), 0.65f, {-1.0f,  0.0f}, { 0.0f, -1.0f}}
+        {"South Polar Cell"  , rads(-90.0f), rads(-60.0f), 0.65f, { 0.0f,  1.0f}, {-1.0f,  0.0f}},
+        {"South Ferrell Cell", rads(-60.0f), rads(-30.0f), 0.75f , { 1.0f,  0.0f}, { 0.0f, -1.0f}},
+        {"South Hadley Cell" , rads(-30.0f), rads(0.0f), 0.95f , { 0.0f,  1.0f}, {-1.0f,  0.0f}},
+        {"Noth Hadley Cell"  , rads(0.0f) , rads(30.0f), 0.95f , {-1.0f,  0.0f}, { 0.0f, -1.0f}},
+        {"North Ferrell Cell", rads(30.0f) , rads(60.0f), 0.74f , { 0.0f,  1.0f}, { 1.0f,  0.0f}},
+        {"North Polar Cell"  , rads(60.0f) , rads(90.0f), 0.65f, {-1.0f,  0.0f}, { 0.0f, -1.0f}}
+
+    };
+}
+
 }//namespace worldgen
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "worldgen/plateBoundaries.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/trace.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace worldgen
+{
+
+namespace
+{
+
+//columns per column pass task, rows of a block are written contiguously
+constexpr size_t ColumnGrain=64;
+constexpr size_t RowGrain=8;
+
+constexpr double Pi=3.14159265358979323846;
+
+//Lower envelope of the parabolas w2*(p-q)^2+g[q] over sites q with a finite g, evaluated at every p in
+//[queryBegin, queryBegin+queryCount). Doubles, near the poles g/w2 outgrows what a float resolves.
+class LowerEnvelope
+{
+public:
+    void resize(size_t sites)
+    {
+        m_sites.resize(sites);
+        m_bounds.resize(sites+1);
+    }
+
+    void evaluate(const double *g, size_t siteCount, double w2, size_t queryBegin, size_t queryCount, double *out)
+    {
+        const double infinity=std::numeric_limits<double>::infinity();
+        size_t count=0;
+
+        for(size_t q=0; q<siteCount; ++q)
+        {
+            if(g[q]==infinity)
+                continue;
+
+            double s=-infinity;
+
+            while(count>0)
+            {
+                size_t p=m_sites[count-1];
+
+                s=((g[q]+w2*q*q)-(g[p]+w2*p*p))/(2.0*w2*((double)q-(double)p));
+                if(s>m_bounds[count-1])
+                    break;
+                --count;
+                s=-infinity;
+            }
+
+            m_sites[count]=q;
+            m_bounds[count]=s;
+            ++count;
+        }
+
+        if(count==0)
+        {
+            std::fill(out, out+queryCount, infinity);
+            return;
+        }
+
+        size_t j=0;
+
+        for(size_t i=0; i<queryCount; ++i)
+        {
+            double p=(double)(queryBegin+i);
+
+            while((j+1<count)&&(m_bounds[j+1]<p))
+                ++j;
+
+            double delta=p-(double)m_sites[j];
+
+            out[i]=w2*delta*delta+g[m_sites[j]];
+        }
+    }
+
+private:
+    std::vector<size_t> m_sites;
+    //m_bounds[i] is where parabola i starts being the lowest
+    std::vector<double> m_bounds;
+};
+
+}//namespace
+
+PlateBoundaries::PlateBoundaries():
+    m_width(0),
+    m_height(0),
+    m_columnWords(0),
+    m_lastRowIndex(-1)
+{
+}
+
+void PlateBoundaries::reset(int width, int height)
+{
+    m_width=width;
+    m_height=height;
+    m_columnWords=((size_t)height+63)/64;
+    m_bits.assign((size_t)width*m_columnWords, 0);
+    std::vector<float>().swap(m_lastRow);
+    m_lastRowIndex=-1;
+}
+
+void PlateBoundaries::addRows(const float *plateMap, int rowBegin, int rowEnd)
+{
+    for(int y=rowBegin; y<rowEnd; ++y)
+    {
+        const float *row=plateMap+(size_t)(y-rowBegin)*m_width;
+        const float *above=nullptr;
+
+        //only against the row just added, never the one left from before a reset and never above row 0
+        if((m_lastRowIndex>=0)&&(y==m_lastRowIndex+1))
+            above=(y==rowBegin)?m_lastRow.data():row-m_width;
+
+        for(int x=0; x<m_width; ++x)
+        {
+            //x wraps, y stops at the poles
+            int right=(x+1<m_width)?x+1:0;
+
+            if(row[x]!=row[right])
+            {
+                mark(x, y);
+                mark(right, y);
+            }
+
+            if(above&&(row[x]!=above[x]))
+            {
+                mark(x, y);
+                mark(x, y-1);
+            }
+        }
+        m_lastRowIndex=y;
+    }
+
+    if(rowEnd>rowBegin)
+    {
+        const float *lastRow=plateMap+(size_t)(rowEnd-1-rowBegin)*m_width;
+
+        m_lastRow.assign(lastRow, lastRow+m_width);
+    }
+}
+
+int PlateBoundaries::previous(int x, int y) const
+{
+    const uint64_t *column=&m_bits[(size_t)x*m_columnWords];
+    int wordIndex=y>>6;
+    //bits at or below y in its word
+    uint64_t bits=column[wordIndex]&(~(uint64_t)0>>(63-(y&63)));
+
+    while(true)
+    {
+        if(bits)
+        {
+            int highest=63;
+
+            while(!((bits>>highest)&1))
+                --highest;
+            return (wordIndex<<6)+highest;
+        }
+        if(wordIndex==0)
+            return -1;
+        bits=column[--wordIndex];
+    }
+}
+
+int PlateBoundaries::next(int x, int y) const
+{
+    const uint64_t *column=&m_bits[(size_t)x*m_columnWords];
+    size_t wordIndex=(size_t)(y>>6);
+    //bits at or above y in its word
+    uint64_t bits=column[wordIndex]&(~(uint64_t)0<<(y&63));
+
+    while(true)
+    {
+        if(bits)
+        {
+            int lowest=0;
+
+            while(!((bits>>lowest)&1))
+                ++lowest;
+            return std::min((int)(wordIndex<<6)+lowest, m_height);
+        }
+        if(++wordIndex>=m_columnWords)
+            return m_height;
+        bits=column[wordIndex];
+    }
+}
+
+void boundaryDistance(const PlateBoundaries &boundaries, int rowBegin, int rowEnd, float *distance, ThreadPool *pool)
+{
+    WORLDGEN_TRACE_ZONE("boundaryDistance");
+
+    const int width=boundaries.width();
+    const int height=boundaries.height();
+    const float infinity=std::numeric_limits<float>::infinity();
+
+    //squared distance to the closest boundary in the same column, the bitmap covers the rows outside the band
+    parallelFor(pool, 0, width, ColumnGrain, [&](size_t begin, size_t end)
+        {
+            std::vector<int> closest(end-begin);
+
+            for(size_t x=begin; x<end; ++x)
+                closest[x-begin]=boundaries.previous((int)x, rowBegin);
+
+            for(int y=rowBegin; y<rowEnd; ++y)
+            {
+                float *row=distance+(size_t)(y-rowBegin)*width;
+
+                for(size_t x=begin; x<end; ++x)
+                {
+                    int &above=closest[x-begin];
+
+                    if(boundaries.boundary((int)x, y))
+                        above=y;
+                    row[x]=(above>=0)?(float)(y-above):infinity;
+                }
+            }
+
+            for(size_t x=begin; x<end; ++x)
+                closest[x-begin]=boundaries.next((int)x, rowEnd-1);
+
+            for(int y=rowEnd-1; y>=rowBegin; --y)
+            {
+                float *row=distance+(size_t)(y-rowBegin)*width;
+
+                for(size_t x=begin; x<end; ++x)
+                {
+                    int &below=closest[x-begin];
+
+                    if(boundaries.boundary((int)x, y))
+                        below=y;
+
+                    float d=std::min(row[x], (below<height)?(float)(below-y):infinity);
+
+                    row[x]=d*d;
+                }
+            }
+        });
+
+    //Wrapping in x: a cell's closest boundary is at most half the width away, so the sites are the row
+    //extended by half the width on either side and the queries are the middle.
+    const size_t half=((size_t)width+1)/2;
+    const size_t siteCount=(size_t)width+2*half;
+
+    parallelFor(pool, rowBegin, rowEnd, RowGrain, [&](size_t begin, size_t end)
+        {
+            LowerEnvelope envelope;
+            std::vector<double> sites(siteCount);
+            std::vector<double> result(width);
+
+            envelope.resize(siteCount);
+
+            for(size_t y=begin; y<end; ++y)
+            {
+                float *row=distance+(y-rowBegin)*width;
+                //cosine of the latitude at the row's center, never 0
+                double scale=std::sin(Pi*((double)y+0.5)/height);
+
+                for(size_t i=0; i<siteCount; ++i)
+                    sites[i]=row[(i+width-half)%width];
+
+                envelope.evaluate(sites.data(), siteCount, scale*scale, half, width, result.data());
+
+                for(int x=0; x<width; ++x)
+                    row[x]=(float)std::sqrt(result[x]);
+            }
+        });
+}
+
+}//namespace worldgen
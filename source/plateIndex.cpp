@@ -0,0 +1,227 @@
+#include "worldgen/plateIndex.h"
+#include "worldgen/utils/threadPool.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+namespace worldgen
+{
+
+namespace
+{
+
+constexpr size_t QueryGrain=4096;
+
+inline glm::vec3 normalized(const glm::vec3 &point)
+{
+    float length=std::sqrt(point.x*point.x+point.y*point.y+point.z*point.z);
+
+    //a zero point is put on the pole rather than turning into nans
+    return (length>0.0f)?glm::vec3(point.x/length, point.y/length, point.z/length):glm::vec3(0.0f, 0.0f, 1.0f);
+}
+
+inline float distance2(const glm::vec3 &a, const glm::vec3 &b)
+{
+    float dx=a.x-b.x;
+    float dy=a.y-b.y;
+    float dz=a.z-b.z;
+
+    return dx*dx+dy*dy+dz*dz;
+}
+
+}//namespace
+
+PlateIndex::PlateIndex()
+{
+}
+
+void PlateIndex::build(const std::vector<PlateInfo> &plates)
+{
+    std::vector<glm::vec3> points(plates.size());
+
+    for(size_t i=0; i<plates.size(); ++i)
+        points[i]=plates[i].point3d;
+    build(points);
+}
+
+void PlateIndex::build(const std::vector<glm::vec3> &points)
+{
+    std::vector<uint32_t> plates(points.size());
+
+    std::iota(plates.begin(), plates.end(), 0);
+    build(points, plates);
+}
+
+void PlateIndex::build(const std::vector<glm::vec3> &points, const std::vector<uint32_t> &plates)
+{
+    assert(plates.size()==points.size());
+
+    m_points.resize(points.size());
+    m_plates=plates;
+    m_axes.assign(points.size(), 0);
+
+    for(size_t i=0; i<points.size(); ++i)
+        m_points[i]=normalized(points[i]);
+
+    buildRange(0, m_points.size());
+}
+
+void PlateIndex::clear()
+{
+    m_points.clear();
+    m_plates.clear();
+    m_axes.clear();
+}
+
+void PlateIndex::buildRange(size_t begin, size_t end)
+{
+    if(end-begin<2)
+        return;
+
+    //split on the axis the points spread furthest along
+    glm::vec3 low=m_points[begin];
+    glm::vec3 high=m_points[begin];
+
+    for(size_t i=begin+1; i<end; ++i)
+    {
+        for(int axis=0; axis<3; ++axis)
+        {
+            low[axis]=std::min(low[axis], m_points[i][axis]);
+            high[axis]=std::max(high[axis], m_points[i][axis]);
+        }
+    }
+
+    glm::vec3 extent=high-low;
+    uint8_t axis=(extent.x>=extent.y)?((extent.x>=extent.z)?0:2):((extent.y>=extent.z)?1:2);
+    size_t median=(begin+end)/2;
+
+    //points and their plates move together, sorted through an index range
+    std::vector<size_t> order(end-begin);
+
+    std::iota(order.begin(), order.end(), begin);
+    std::nth_element(order.begin(), order.begin()+(median-begin), order.end(), [&](size_t a, size_t b)
+        {
+            //plate breaks ties so the tree does not depend on the nth_element implementation
+            if(m_points[a][axis]!=m_points[b][axis])
+                return m_points[a][axis]<m_points[b][axis];
+            return m_plates[a]<m_plates[b];
+        });
+
+    std::vector<glm::vec3> points(end-begin);
+    std::vector<uint32_t> plates(end-begin);
+
+    for(size_t i=0; i<order.size(); ++i)
+    {
+        points[i]=m_points[order[i]];
+        plates[i]=m_plates[order[i]];
+    }
+    std::copy(points.begin(), points.end(), m_points.begin()+begin);
+    std::copy(plates.begin(), plates.end(), m_plates.begin()+begin);
+
+    m_axes[median]=axis;
+    buildRange(begin, median);
+    buildRange(median+1, end);
+}
+
+void PlateIndex::search(const glm::vec3 &position, size_t begin, size_t end, uint32_t *closest, float *distances) const
+{
+    while(begin<end)
+    {
+        size_t median=(begin+end)/2;
+        const glm::vec3 &point=m_points[median];
+        float distance=distance2(position, point);
+        uint32_t plate=m_plates[median];
+
+        //equal distances go to the lower plate index, the same answer whatever order the tree visits them in
+        if((distance<distances[0])||((distance==distances[0])&&(plate<closest[0])))
+        {
+            closest[1]=closest[0];
+            distances[1]=distances[0];
+            closest[0]=plate;
+            distances[0]=distance;
+        }
+        else if((distance<distances[1])||((distance==distances[1])&&(plate<closest[1])))
+        {
+            closest[1]=plate;
+            distances[1]=distance;
+        }
+
+        if(end-begin==1)
+            return;
+
+        float delta=position[m_axes[median]]-point[m_axes[median]];
+        bool lowerFirst=(delta<0.0f);
+
+        //near side first, the far side only while the splitting plane is closer than the second best
+        if(lowerFirst)
+            search(position, begin, median, closest, distances);
+        else
+            search(position, median+1, end, closest, distances);
+
+        if(delta*delta>distances[1])
+            return;
+
+        //far side as the loop, saves a level of recursion
+        if(lowerFirst)
+            begin=median+1;
+        else
+            end=median;
+    }
+}
+
+uint32_t PlateIndex::nearest(const glm::vec3 &position) const
+{
+    return nearest2(position).plate;
+}
+
+PlateQuery PlateIndex::nearest2(const glm::vec3 &position) const
+{
+    const float infinity=std::numeric_limits<float>::infinity();
+    uint32_t closest[2]={std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max()};
+    float distances[2]={infinity, infinity};
+
+    search(normalized(position), 0, m_points.size(), closest, distances);
+
+    PlateQuery query;
+
+    query.plate=closest[0];
+    query.borderPlate=(closest[1]!=std::numeric_limits<uint32_t>::max())?closest[1]:closest[0];
+    return query;
+}
+
+void PlateIndex::nearest(const glm::vec3 *positions, size_t count, uint32_t *plates, ThreadPool *pool) const
+{
+    parallelFor(pool, 0, count, QueryGrain, [&](size_t begin, size_t end)
+        {
+            for(size_t i=begin; i<end; ++i)
+                plates[i]=nearest2(positions[i]).plate;
+        });
+}
+
+void PlateIndex::nearest2(const glm::vec3 *positions, size_t count, PlateQuery *queries, ThreadPool *pool) const
+{
+    parallelFor(pool, 0, count, QueryGrain, [&](size_t begin, size_t end)
+        {
+            for(size_t i=begin; i<end; ++i)
+                queries[i]=nearest2(positions[i]);
+        });
+}
+
+void PlateIndex::nearest2(const float *x, const float *y, const float *z, size_t count, uint32_t *plates, uint32_t *borderPlates, ThreadPool *pool) const
+{
+    parallelFor(pool, 0, count, QueryGrain, [&](size_t begin, size_t end)
+        {
+            for(size_t i=begin; i<end; ++i)
+            {
+                PlateQuery query=nearest2(glm::vec3(x[i], y[i], z[i]));
+
+                plates[i]=query.plate;
+                borderPlates[i]=query.borderPlate;
+            }
+        });
+}
+
+}//namespace worldgen
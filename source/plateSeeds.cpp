@@ -0,0 +1,306 @@
+#include "worldgen/plateSeeds.h"
+#include "worldgen/maths/coords.h"
+#include "worldgen/maths/coordsSoA.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/trace.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <cmath>
+
+namespace worldgen
+{
+
+namespace
+{
+
+constexpr float Pi=3.14159265358979f;
+constexpr float TwoPi=6.28318530717959f;
+
+//fraction of the fibonacci spacing seeds are moved by, enough to break up the spiral pattern
+constexpr float SeedJitter=0.25f;
+//grid cells per seed, keeps a couple of grid cells across the smallest plates
+constexpr size_t CellsPerSeed=16;
+constexpr int MinGridRows=32;
+
+constexpr size_t RowGrain=4;
+constexpr size_t AssignGrain=4096;
+//points projected to the grid at a time
+constexpr size_t AssignBlock=256;
+
+//closest distinct seeds sorted by distance, ties go to the one seen first
+template<int _Count>
+struct ClosestSeeds
+{
+    ClosestSeeds()
+    {
+        for(int i=0; i<_Count; ++i)
+        {
+            seeds[i]=-1;
+            distances[i]=std::numeric_limits<float>::infinity();
+        }
+    }
+
+    void insert(int seed, float distance)
+    {
+        if(!(distance<distances[_Count-1]))
+            return;
+
+        for(int i=0; i<_Count; ++i)
+        {
+            if(seeds[i]==seed)
+                return;
+        }
+
+        int i=_Count-1;
+
+        for(; (i>0)&&(distance<distances[i-1]); --i)
+        {
+            seeds[i]=seeds[i-1];
+            distances[i]=distances[i-1];
+        }
+        seeds[i]=seed;
+        distances[i]=distance;
+    }
+
+    int seeds[_Count];
+    float distances[_Count];
+};
+
+inline float distance2(const glm::vec3 &a, const glm::vec3 &b)
+{
+    float dx=a.x-b.x;
+    float dy=a.y-b.y;
+    float dz=a.z-b.z;
+
+    return dx*dx+dy*dy+dz*dz;
+}
+
+}//namespace
+
+PlateSeeds::PlateSeeds():
+    m_spacing(0.0f),
+    m_gridWidth(0),
+    m_gridHeight(0)
+{
+}
+
+void PlateSeeds::build(size_t count, int seed, ThreadPool *pool)
+{
+    WORLDGEN_TRACE_ZONE("plateSeeds");
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> jitterDistribution(-SeedJitter, SeedJitter);
+    std::vector<float> jitter(count);
+
+    for(float &value:jitter)
+        value=jitterDistribution(generator);
+
+    //(radius, theta, phi) to unit cartesian
+    std::vector<glm::vec3> points=generateFibonacciSphere(count, jitter);
+
+    m_positions.resize(count);
+    for(size_t i=0; i<count; ++i)
+    {
+        float theta=points[i].y;
+        float phi=points[i].z;
+
+        m_positions[i]=glm::vec3(std::cos(phi)*std::cos(theta), std::cos(phi)*std::sin(theta), std::sin(phi));
+    }
+
+    //evenly spaced and shuffled, distinct values keep plates apart in the plate statistics
+    std::vector<size_t> order(count);
+
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), generator);
+
+    m_values.resize(count);
+    for(size_t i=0; i<count; ++i)
+        m_values[i]=-1.0f+2.0f*((float)order[i]+0.5f)/count;
+
+    m_spacing=(count>0)?std::sqrt(4.0f*Pi/count):Pi;
+
+    m_gridHeight=std::max(MinGridRows, (int)std::ceil(std::sqrt((float)(CellsPerSeed*count)/2.0f)));
+    m_gridWidth=2*m_gridHeight;
+
+    m_cellCenters.resize((size_t)m_gridWidth*m_gridHeight);
+    for(int y=0; y<m_gridHeight; ++y)
+    {
+        float phi=0.5f*Pi-Pi*((float)y+0.5f)/m_gridHeight;
+
+        for(int x=0; x<m_gridWidth; ++x)
+        {
+            float theta=TwoPi*((float)x+0.5f)/m_gridWidth;
+
+            m_cellCenters[(size_t)y*m_gridWidth+x]=glm::vec3(std::cos(phi)*std::cos(theta), std::cos(phi)*std::sin(theta), std::sin(phi));
+        }
+    }
+
+    flood(pool);
+    gatherCandidates();
+}
+
+size_t PlateSeeds::cellIndex(float u, float v) const
+{
+    int x=std::min((int)(u*m_gridWidth), m_gridWidth-1);
+    int y=std::min((int)(v*m_gridHeight), m_gridHeight-1);
+
+    return (size_t)std::max(y, 0)*m_gridWidth+std::max(x, 0);
+}
+
+void PlateSeeds::flood(ThreadPool *pool)
+{
+    typedef ClosestSeeds<SeedsPerCell> CellSeeds;
+
+    size_t cellCount=(size_t)m_gridWidth*m_gridHeight;
+    std::vector<int> next(cellCount*SeedsPerCell);
+
+    size_t seedCount=m_positions.size();
+    std::vector<float> x(seedCount), y(seedCount), z(seedCount);
+    std::vector<float> u(seedCount), v(seedCount);
+
+    for(size_t i=0; i<seedCount; ++i)
+    {
+        x[i]=m_positions[i].x;
+        y[i]=m_positions[i].y;
+        z[i]=m_positions[i].z;
+    }
+    cartesianToEquirectangular(x.data(), y.data(), z.data(), u.data(), v.data(), seedCount);
+
+    m_closest.assign(cellCount*SeedsPerCell, -1);
+
+    //every seed starts in the cell it falls in
+    for(size_t i=0; i<seedCount; ++i)
+    {
+        size_t index=cellIndex(u[i], v[i]);
+        int *closest=&m_closest[index*SeedsPerCell];
+        CellSeeds cell;
+
+        for(int j=0; (j<SeedsPerCell)&&(closest[j]>=0); ++j)
+            cell.insert(closest[j], distance2(m_cellCenters[index], m_positions[closest[j]]));
+        cell.insert((int)i, distance2(m_cellCenters[index], m_positions[i]));
+        std::copy(cell.seeds, cell.seeds+SeedsPerCell, closest);
+    }
+
+    //jumps halve from half the width (the furthest anything is in longitude) down to 1, then 1 again which
+    //fixes most of the cells jump flooding gets wrong
+    std::vector<int> steps;
+
+    for(int step=1; step<m_gridWidth/2; step*=2)
+        steps.insert(steps.begin(), step);
+    steps.insert(steps.begin(), m_gridWidth/2);
+    steps.push_back(1);
+
+    for(int step:steps)
+    {
+        parallelFor(pool, 0, m_gridHeight, RowGrain, [&](size_t begin, size_t end)
+            {
+                for(int y=(int)begin; y<(int)end; ++y)
+                {
+                    for(int x=0; x<m_gridWidth; ++x)
+                    {
+                        size_t index=(size_t)y*m_gridWidth+x;
+                        const glm::vec3 &center=m_cellCenters[index];
+                        CellSeeds cell;
+
+                        for(int dy=-step; dy<=step; dy+=step)
+                        {
+                            int sampleY=y+dy;
+
+                            //the grid does not continue over the poles, the jumps in x cover those cells
+                            if((sampleY<0)||(sampleY>=m_gridHeight))
+                                continue;
+
+                            for(int dx=-step; dx<=step; dx+=step)
+                            {
+                                int sampleX=((x+dx)%m_gridWidth+m_gridWidth)%m_gridWidth;
+                                const int *sample=&m_closest[((size_t)sampleY*m_gridWidth+sampleX)*SeedsPerCell];
+
+                                for(int j=0; (j<SeedsPerCell)&&(sample[j]>=0); ++j)
+                                    cell.insert(sample[j], distance2(center, m_positions[sample[j]]));
+                            }
+                        }
+                        std::copy(cell.seeds, cell.seeds+SeedsPerCell, &next[index*SeedsPerCell]);
+                    }
+                }
+            });
+        m_closest.swap(next);
+    }
+}
+
+void PlateSeeds::gatherCandidates()
+{
+    size_t cellCount=(size_t)m_gridWidth*m_gridHeight;
+
+    m_candidateOffsets.resize(cellCount+1);
+    m_candidates.clear();
+
+    for(int y=0; y<m_gridHeight; ++y)
+    {
+        for(int x=0; x<m_gridWidth; ++x)
+        {
+            size_t begin=m_candidates.size();
+
+            m_candidateOffsets[(size_t)y*m_gridWidth+x]=begin;
+
+            for(int sampleY=std::max(y-1, 0); sampleY<=std::min(y+1, m_gridHeight-1); ++sampleY)
+            {
+                for(int dx=-1; dx<=1; ++dx)
+                {
+                    int sampleX=(x+dx+m_gridWidth)%m_gridWidth;
+                    const int *sample=&m_closest[((size_t)sampleY*m_gridWidth+sampleX)*SeedsPerCell];
+
+                    for(int j=0; (j<SeedsPerCell)&&(sample[j]>=0); ++j)
+                    {
+                        if(std::find(m_candidates.begin()+begin, m_candidates.end(), sample[j])==m_candidates.end())
+                            m_candidates.push_back(sample[j]);
+                    }
+                }
+            }
+        }
+    }
+    m_candidateOffsets[cellCount]=m_candidates.size();
+}
+
+void PlateSeeds::assign(const float *x, const float *y, const float *z, size_t count, float *plate, float *plate2, ThreadPool *pool) const
+{
+    WORLDGEN_TRACE_ZONE("assignPlates");
+
+    parallelFor(pool, 0, count, AssignGrain, [&](size_t begin, size_t end)
+        {
+            float u[AssignBlock];
+            float v[AssignBlock];
+
+            for(size_t blockBegin=begin; blockBegin<end; blockBegin+=AssignBlock)
+            {
+                size_t blockSize=std::min(AssignBlock, end-blockBegin);
+
+                //the batch projection vectorizes, the seed search after it does not
+                cartesianToEquirectangular(x+blockBegin, y+blockBegin, z+blockBegin, u, v, blockSize);
+
+                for(size_t i=0; i<blockSize; ++i)
+                {
+                    size_t index=cellIndex(u[i], v[i]);
+                    glm::vec3 position(x[blockBegin+i], y[blockBegin+i], z[blockBegin+i]);
+                    ClosestSeeds<2> closest;
+
+                    //closest on the sphere is the largest dot product, no need to normalize the position.
+                    //Candidates are distinct, ties go to the first in the list.
+                    for(size_t j=m_candidateOffsets[index]; j<m_candidateOffsets[index+1]; ++j)
+                    {
+                        const glm::vec3 &seed=m_positions[m_candidates[j]];
+
+                        closest.insert(m_candidates[j], -(position.x*seed.x+position.y*seed.y+position.z*seed.z));
+                    }
+
+                    //a single seed has no second, the plate borders itself like a cellular plate would
+                    plate[blockBegin+i]=(closest.seeds[0]>=0)?m_values[closest.seeds[0]]:0.0f;
+                    plate2[blockBegin+i]=(closest.seeds[1]>=0)?m_values[closest.seeds[1]]:plate[blockBegin+i];
+                }
+            }
+        });
+}
+
+}//namespace worldgen
@@ -0,0 +1,96 @@
+#include "worldgen/render/layerKernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace worldgen
+{
+namespace render
+{
+
+#if defined(__AVX2__)
+
+bool avx2KernelsBuilt()
+{
+    return true;
+}
+
+int lutIndicesAvx2(const float *values, int count, float scale, float offset, int32_t size, int32_t *indices)
+{
+    const __m256 scaleV=_mm256_set1_ps(scale);
+    const __m256 offsetV=_mm256_set1_ps(offset);
+    const __m256 zeroV=_mm256_setzero_ps();
+    const __m256 maxV=_mm256_set1_ps((float)(size-1));
+    int i=0;
+
+    for(; i+8<=count; i+=8)
+    {
+        __m256 value=_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(values+i), scaleV), offsetV);
+
+        //max returns its second operand when either is NaN, zero second sends NaN to 0 like the scalar tail
+        value=_mm256_min_ps(_mm256_max_ps(value, zeroV), maxV);
+        _mm256_storeu_si256((__m256i *)(indices+i), _mm256_cvttps_epi32(value));
+    }
+    return i;
+}
+
+int clampIndicesAvx2(const int32_t *values, int count, int32_t size, int32_t *indices)
+{
+    const __m256i zeroV=_mm256_setzero_si256();
+    const __m256i maxV=_mm256_set1_epi32(size-1);
+    int i=0;
+
+    for(; i+8<=count; i+=8)
+    {
+        __m256i value=_mm256_loadu_si256((const __m256i *)(values+i));
+
+        _mm256_storeu_si256((__m256i *)(indices+i), _mm256_min_epi32(_mm256_max_epi32(value, zeroV), maxV));
+    }
+    return i;
+}
+
+int gatherAvx2(const uint32_t *lut, const int32_t *indices, int count, uint32_t *output)
+{
+    int i=0;
+
+    for(; i+8<=count; i+=8)
+    {
+        __m256i index=_mm256_loadu_si256((const __m256i *)(indices+i));
+
+        _mm256_storeu_si256((__m256i *)(output+i), _mm256_i32gather_epi32((const int *)lut, index, 4));
+    }
+    return i;
+}
+
+int addSaturateAvx2(const uint32_t *overlay, int count, uint32_t *output)
+{
+    int i=0;
+
+    for(; i+8<=count; i+=8)
+    {
+        __m256i color=_mm256_loadu_si256((const __m256i *)(output+i));
+        __m256i add=_mm256_loadu_si256((const __m256i *)(overlay+i));
+
+        _mm256_storeu_si256((__m256i *)(output+i), _mm256_adds_epu8(color, add));
+    }
+    return i;
+}
+
+#else
+
+//built without AVX2 (not x86 or a compiler CMakeLists.txt has no flag for), the renderer stays scalar
+bool avx2KernelsBuilt()
+{
+    return false;
+}
+
+int lutIndicesAvx2(const float *, int, float, float, int32_t, int32_t *) { return 0; }
+int clampIndicesAvx2(const int32_t *, int, int32_t, int32_t *) { return 0; }
+int gatherAvx2(const uint32_t *, const int32_t *, int, uint32_t *) { return 0; }
+int addSaturateAvx2(const uint32_t *, int, uint32_t *) { return 0; }
+
+#endif
+
+}//namespace render
+}//namespace worldgen
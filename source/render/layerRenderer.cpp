@@ -0,0 +1,452 @@
+#include "worldgen/render/layerRenderer.h"
+#include "worldgen/render/layerKernels.h"
+#include "worldgen/utils/randomcolor.h"
+#include "worldgen/utils/simdLevel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace worldgen
+{
+namespace render
+{
+
+ColorLut makeLut(const ColorMap &colorMap)
+{
+    ColorLut lut;
+
+    lut.colors.resize(colorMap.colors.size());
+    for(size_t i=0; i<colorMap.colors.size(); ++i)
+        lut.colors[i]=packColor(colorMap.colors[i]);
+    return lut;
+}
+
+
+ColorLut2D makeLut(const ColorMap2D &colorMap)
+{
+    ColorLut2D lut;
+
+    lut.width=(int)colorMap.width;
+    lut.height=(int)colorMap.height;
+    lut.colors.resize(colorMap.width*colorMap.height);
+
+    for(size_t i=0; i<lut.colors.size(); ++i)
+        lut.colors[i]=packColor(colorMap.colors[i]);
+    return lut;
+}
+
+
+ColorLut makeLut(const std::vector<std::tuple<int, int, int>> &colors)
+{
+    ColorLut lut;
+
+    lut.colors.resize(colors.size());
+    for(size_t i=0; i<colors.size(); ++i)
+        lut.colors[i]=packColor(std::get<0>(colors[i]), std::get<1>(colors[i]), std::get<2>(colors[i]));
+    return lut;
+}
+
+
+Palette defaultPalette(int plateCount)
+{
+    Palette palette;
+    ColorScale tempColorScale;
+
+    tempColorScale.addColorPosition(glm::ivec4(255, 255, 255, 255), 0.0f);
+    tempColorScale.addColorPosition(glm::ivec4(255, 0, 255, 255), 0.2f);
+    tempColorScale.addColorPosition(glm::ivec4(0, 0, 255, 255), 0.4f);
+    tempColorScale.addColorPosition(glm::ivec4(0, 255, 0, 255), 0.6f);
+    tempColorScale.addColorPosition(glm::ivec4(255, 0, 0, 255), 0.8f);
+    tempColorScale.addColorPosition(glm::ivec4(0, 0, 0, 255), 1.0f);
+
+    ColorScale moistureColorScale;
+
+    moistureColorScale.addColorPosition(glm::ivec4(255, 0, 0, 255), 0.0f);
+    moistureColorScale.addColorPosition(glm::ivec4(0, 255, 0, 255), 0.5f);
+    moistureColorScale.addColorPosition(glm::ivec4(0, 0, 255, 255), 1.0f);
+
+    palette.biome=makeLut(generateHieghtMoistureColorMap(64, 64));
+    palette.temperature=makeLut(generateColorMap(tempColorScale, 64));
+    palette.moisture=makeLut(generateColorMap(moistureColorScale, 64));
+
+    RandomColorGenerator colorGenerator;
+
+    palette.plates=makeLut(colorGenerator.randomColors(std::max(plateCount, 1)));
+    return palette;
+}
+
+
+void Fields::build(const std::vector<InfluenceCell> &influenceMap, const glm::ivec2 &mapSize, ThreadPool *pool)
+{
+    size_t count=(size_t)mapSize.x*mapSize.y;
+
+    size=mapSize;
+
+    heightBase.resize(count);
+    plateHeight.resize(count);
+    plateDistanceValue.resize(count);
+    collision.resize(count);
+    terrainScale.resize(count);
+    temperature.resize(count);
+    moisture.resize(count);
+    tectonicPlate.resize(count);
+    weatherCell.resize(count);
+    weatherBand.resize(count);
+
+    parallelFor(pool, 0, mapSize.y, 64, [&](size_t begin, size_t end)
+    {
+        for(size_t i=begin*mapSize.x; i<end*mapSize.x; ++i)
+        {
+            const InfluenceCell &cell=influenceMap[i];
+
+            heightBase[i]=cell.heightBase;
+            plateHeight[i]=cell.plateHeight;
+            plateDistanceValue[i]=cell.plateDistanceValue;
+            collision[i]=cell.collision;
+            terrainScale[i]=cell.terrainScale;
+            temperature[i]=cell.temperature;
+            moisture[i]=cell.moisture;
+            tectonicPlate[i]=(int32_t)cell.tectonicPlate;
+            weatherCell[i]=(int32_t)cell.weatherCell;
+            weatherBand[i]=(int32_t)cell.weatherBand;
+        }
+    });
+}
+
+
+void fieldRange(const float *field, size_t size, float &min, float &max)
+{
+    min=std::numeric_limits<float>::max();
+    max=std::numeric_limits<float>::lowest();
+
+    for(size_t i=0; i<size; ++i)
+    {
+        min=std::min(min, field[i]);
+        max=std::max(max, field[i]);
+    }
+}
+
+namespace
+{
+
+//rows per parallelFor chunk, keeps a chunk of scratch rows in L1/L2
+constexpr size_t RowGrain=16;
+
+const ColorLut &greyLut()
+{
+    static const ColorLut lut=[]()
+    {
+        ColorLut grey;
+
+        grey.colors.resize(256);
+        for(int i=0; i<256; ++i)
+            grey.colors[i]=packColor(i, i, i);
+        return grey;
+    }();
+
+    return lut;
+}
+
+//per thread scratch for one output row
+struct RowBuffers
+{
+    void resize(size_t width)
+    {
+        values.resize(width);
+        values2.resize(width);
+        values3.resize(width);
+        ints.resize(width);
+        indices.resize(width);
+        indices2.resize(width);
+        overlay.resize(width);
+    }
+
+    std::vector<float> values;
+    std::vector<float> values2;
+    std::vector<float> values3;
+    std::vector<int32_t> ints;
+    std::vector<int32_t> indices;
+    std::vector<int32_t> indices2;
+    std::vector<uint32_t> overlay;
+};
+
+//row of a field as a contiguous span, points straight into the field at stride 1
+template<typename _Type>
+const _Type *rowSpan(const _Type *field, int fieldWidth, const Region &region, int row, int width, std::vector<_Type> &scratch)
+{
+    const _Type *start=field+(size_t)(region.y+row*region.stride)*fieldWidth+region.x;
+
+    if(region.stride==1)
+        return start;
+
+    for(int i=0; i<width; ++i)
+        scratch[i]=start[(size_t)i*region.stride];
+    return scratch.data();
+}
+
+//whether the AVX2 kernels are built in and this cpu runs them, checked once
+bool avx2Kernels()
+{
+    static const bool available=avx2KernelsBuilt()&&(resolveSimdLevel(SimdLevel::AVX2)==SimdLevel::AVX2);
+
+    return available;
+}
+
+//indices[i]=clamp((int)(values[i]*scale+offset), 0, size-1), NaN maps to 0
+void lutIndices(const float *values, int count, float scale, float offset, int32_t size, int32_t *indices)
+{
+    int i=avx2Kernels()?lutIndicesAvx2(values, count, scale, offset, size, indices):0;
+    const float maxIndex=(float)(size-1);
+
+    for(; i<count; ++i)
+    {
+        float value=values[i]*scale+offset;
+
+        indices[i]=(value>0.0f)?(int32_t)std::min(value, maxIndex):0;
+    }
+}
+
+void clampIndices(const int32_t *values, int count, int32_t size, int32_t *indices)
+{
+    int i=avx2Kernels()?clampIndicesAvx2(values, count, size, indices):0;
+
+    for(; i<count; ++i)
+        indices[i]=std::min(std::max(values[i], 0), size-1);
+}
+
+void gather(const uint32_t *lut, const int32_t *indices, int count, uint32_t *output)
+{
+    int i=avx2Kernels()?gatherAvx2(lut, indices, count, output):0;
+
+    for(; i<count; ++i)
+        output[i]=lut[indices[i]];
+}
+
+//per channel saturating add, matches adding the ivec4 colors and clamping to 255
+void addSaturate(const uint32_t *overlay, int count, uint32_t *output)
+{
+    int i=avx2Kernels()?addSaturateAvx2(overlay, count, output):0;
+
+    for(; i<count; ++i)
+    {
+        uint32_t color=output[i];
+        uint32_t add=overlay[i];
+        uint32_t result=0;
+
+        for(int shift=0; shift<32; shift+=8)
+        {
+            uint32_t channel=((color>>shift)&0xff)+((add>>shift)&0xff);
+
+            result|=std::min(channel, 255u)<<shift;
+        }
+        output[i]=result;
+    }
+}
+
+//red for negative values, green for positive
+void signedOverlay(const float *values, const float *weights, int count, uint32_t *overlay)
+{
+    for(int i=0; i<count; ++i)
+    {
+        float value=weights?values[i]*weights[i]:values[i];
+        int channel=(int)(255.0f*std::abs(value));
+
+        overlay[i]=(value<0.0f)?packColor(channel, 0, 0, 0):packColor(0, channel, 0, 0);
+    }
+}
+
+void renderRow(const Fields &fields, const Palette &palette, const LayerSettings &settings, const Region &region, int row,
+    uint32_t *output, RowBuffers &buffers)
+{
+    const int fieldWidth=fields.size.x;
+    const int width=region.outputWidth();
+
+    auto floatRow=[&](const std::vector<float> &field, std::vector<float> &scratch) { return rowSpan(field.data(), fieldWidth, region, row, width, scratch); };
+    auto intRow=[&](const std::vector<int32_t> &field) { return rowSpan(field.data(), fieldWidth, region, row, width, buffers.ints); };
+
+    int32_t *indices=buffers.indices.data();
+
+    switch(settings.layer)
+    {
+    case Layer::Biome:
+    {
+        const ColorLut2D &lut=palette.biome;
+        const float *height=floatRow(fields.heightBase, buffers.values);
+        const float *moisture=floatRow(fields.moisture, buffers.values2);
+        const float *temperature=floatRow(fields.temperature, buffers.values3);
+        int32_t *moistureIndices=buffers.indices2.data();
+
+        lutIndices(height, width, (float)lut.width, 0.0f, lut.width, indices);
+        lutIndices(moisture, width, (float)lut.height, 0.0f, lut.height, moistureIndices);
+
+        for(int i=0; i<width; ++i)
+            indices[i]+=moistureIndices[i]*lut.width;
+
+        gather(lut.colors.data(), indices, width, output);
+
+        //polar caps
+        for(int i=0; i<width; ++i)
+        {
+            float value=(temperature[i]+90.0f)/160.0f;
+
+            if((value>=0.4f)||(height[i]<=0.5f))
+                continue;
+
+            if(value<0.2f)
+                output[i]=packColor(255, 255, 255);
+            else
+            {
+                uint32_t color=output[i];
+
+                value=5.0f*(0.4f-value);
+                output[i]=packColor(
+                    (int)((255*value)+((color&0xff)*(1.0f-value))),
+                    (int)((255*value)+(((color>>8)&0xff)*(1.0f-value))),
+                    (int)((255*value)+(((color>>16)&0xff)*(1.0f-value))),
+                    (int)(color>>24));
+            }
+        }
+        break;
+    }
+    case Layer::Height:
+        lutIndices(floatRow(fields.heightBase, buffers.values), width, 255.0f, 0.0f, 256, indices);
+        gather(greyLut().colors.data(), indices, width, output);
+        break;
+    case Layer::PlateHeight:
+    {
+        const ColorLut2D &lut=palette.biome;
+        const uint32_t *lutRow=lut.colors.data()+(size_t)std::min(lut.height/2, lut.height-1)*lut.width;
+
+        lutIndices(floatRow(fields.plateHeight, buffers.values), width, (float)lut.width, 0.0f, lut.width, indices);
+        gather(lutRow, indices, width, output);
+        break;
+    }
+    case Layer::Plates:
+        clampIndices(intRow(fields.tectonicPlate), width, (int32_t)palette.plates.colors.size(), indices);
+        gather(palette.plates.colors.data(), indices, width, output);
+        break;
+    case Layer::Grey:
+    {
+        float range=settings.greyMax-settings.greyMin;
+        float scale=(range>0.0f)?255.0f/range:0.0f;
+
+        lutIndices(rowSpan(settings.grey, fieldWidth, region, row, width, buffers.values), width, scale, -settings.greyMin*scale, 256, indices);
+        gather(greyLut().colors.data(), indices, width, output);
+        break;
+    }
+    case Layer::RedGreen:
+    {
+        const float *red=rowSpan(settings.red, fieldWidth, region, row, width, buffers.values);
+        const float *green=rowSpan(settings.green, fieldWidth, region, row, width, buffers.values2);
+
+        for(int i=0; i<width; ++i)
+            output[i]=packColor((int)(255*red[i]), (int)(255*green[i]), 0);
+        break;
+    }
+    case Layer::Black:
+    default:
+        std::fill(output, output+width, packColor(0, 0, 0));
+        break;
+    }
+
+    uint32_t *overlay=buffers.overlay.data();
+
+    switch(settings.overlay)
+    {
+    case Overlay::Collision:
+        signedOverlay(floatRow(fields.collision, buffers.values), nullptr, width, overlay);
+        addSaturate(overlay, width, output);
+        break;
+    case Overlay::CollisionDistance:
+        signedOverlay(floatRow(fields.collision, buffers.values), floatRow(fields.plateDistanceValue, buffers.values2), width, overlay);
+        addSaturate(overlay, width, output);
+        break;
+    case Overlay::TerrainScale:
+        signedOverlay(floatRow(fields.terrainScale, buffers.values), nullptr, width, overlay);
+        addSaturate(overlay, width, output);
+        break;
+    case Overlay::Temperature:
+    {
+        //color scale intended for -50 to 60, temp runs -90 to 60
+        int32_t size=(int32_t)palette.temperature.colors.size();
+        float scale=(float)(size-1)/110.0f;
+
+        lutIndices(floatRow(fields.temperature, buffers.values), width, scale, 50.0f*scale, size, indices);
+        gather(palette.temperature.colors.data(), indices, width, overlay);
+        addSaturate(overlay, width, output);
+        break;
+    }
+    case Overlay::Moisture:
+    {
+        int32_t size=(int32_t)palette.moisture.colors.size();
+
+        lutIndices(floatRow(fields.moisture, buffers.values), width, (float)(size-1), 0.0f, size, indices);
+        gather(palette.moisture.colors.data(), indices, width, overlay);
+        addSaturate(overlay, width, output);
+        break;
+    }
+    case Overlay::LandMoisture:
+    {
+        const float *moisture=floatRow(fields.moisture, buffers.values);
+        const float *height=floatRow(fields.heightBase, buffers.values2);
+
+        for(int i=0; i<width; ++i)
+        {
+            int value=(int)(255*moisture[i]);
+
+            overlay[i]=(height[i]>0.5f)?packColor(value, value, value):0;
+        }
+        addSaturate(overlay, width, output);
+        break;
+    }
+    case Overlay::WeatherCell:
+        clampIndices(intRow(fields.weatherCell), width, (int32_t)palette.plates.colors.size(), indices);
+        gather(palette.plates.colors.data(), indices, width, output);
+        break;
+    case Overlay::WeatherBand:
+        clampIndices(intRow(fields.weatherBand), width, (int32_t)palette.plates.colors.size(), indices);
+        gather(palette.plates.colors.data(), indices, width, output);
+        break;
+    case Overlay::None:
+    default:
+        break;
+    }
+
+    for(int i=0; i<width; ++i)
+        output[i]|=0xff000000u;
+}
+
+}//namespace
+
+
+void renderLayer(const Fields &fields, const Palette &palette, const LayerSettings &settings, const Region &region,
+    uint32_t *output, size_t outputPitch, ThreadPool *pool)
+{
+    const int width=region.outputWidth();
+    const int height=region.outputHeight();
+
+    if((width<=0)||(height<=0))
+        return;
+
+    parallelFor(pool, 0, height, RowGrain, [&](size_t begin, size_t end)
+    {
+        RowBuffers buffers;
+
+        buffers.resize(width);
+        for(size_t row=begin; row<end; ++row)
+            renderRow(fields, palette, settings, region, (int)row, output+row*outputPitch, buffers);
+    });
+}
+
+
+void renderLayer(const Fields &fields, const Palette &palette, const LayerSettings &settings, std::vector<uint32_t> &output,
+    ThreadPool *pool)
+{
+    Region region(0, 0, fields.size.x, fields.size.y);
+
+    output.resize((size_t)fields.size.x*fields.size.y);
+    renderLayer(fields, palette, settings, region, output.data(), fields.size.x, pool);
+}
+
+}//namespace render
+}//namespace worldgen
@@ -0,0 +1,20 @@
+#include "worldgen/tectonicCurves.h"
+
+namespace worldgen
+{
+
+namespace
+{
+
+//const rather than constexpr, compilers with a low constant evaluation step limit (msvc) fall back to
+//initializing it at load instead of failing the build
+const TectonicCurveTable<TectonicCurveResolution> g_tectonicCurveTable;
+
+}//namespace
+
+const TectonicCurveTable<TectonicCurveResolution> &tectonicCurveTable()
+{
+    return g_tectonicCurveTable;
+}
+
+}//namespace worldgen
@@ -0,0 +1,63 @@
+#include "worldgen/tectonics.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/projection.hpp>
+
+#include <random>
+#include <algorithm>
+#include <cassert>
+
+namespace worldgen
+{
+
+void initPlateMotion(std::vector<PlateInfo> &plates, int seed)
+{
+    std::default_random_engine generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    for(size_t i=0; i<plates.size(); i++)
+    {
+        PlateInfo &details=plates[i];
+        glm::vec2 tangentPlaneCoords;
+
+        //generate drift vector, building on x/y plane that will be rotate to the point
+        //tanget to the sphere
+        tangentPlaneCoords.x=distribution(generator);
+        tangentPlaneCoords.y=distribution(generator);
+        tangentPlaneCoords=glm::normalize(tangentPlaneCoords);
+
+        details.driftDirection=tangentPlaneCoords;
+        rotateTangetVectorToPoint(details.point3d, tangentPlaneCoords, details.direction);
+    }
+
+    const float invsqrt2=0.5f/sqrt(2.0f);
+
+    for(size_t i=0; i<plates.size(); i++)
+    {
+        PlateInfo &details=plates[i];
+
+        details.neighborCollisions.clear();
+        for(size_t j=0; j<details.neighbors.size(); j++)
+        {
+            //this is working on the vector in between the center points, it is actually be better to rotate the 
+            //vector to the point being worked on and solve from there. Skipping shear for the moment.
+            PlateInfo &details2=plates[details.neighbors[j]];
+
+            glm::vec3 collisionVector=details2.point3d-details.point3d;
+
+            glm::vec3 direction=glm::proj(details.direction, collisionVector);
+            glm::vec3 direction2=glm::proj(details2.direction, collisionVector);
+
+            float pointDistance=glm::distance(details2.point3d, details.point3d);
+            float directionDistance=glm::distance((details2.point3d+direction2), (details.point3d+direction));
+
+            float collision=(pointDistance-directionDistance)*invsqrt2; //scale to 0.0 to 1.0
+
+            assert(collision<=1.0f);
+            collision=std::min(collision, 1.0f);//make sure between 0.0 and 1.0
+            details.neighborCollisions.push_back(collision);
+        }
+    }
+}
+
+}//namespace worldgen
@@ -0,0 +1,56 @@
+#include "worldgen/utils/generationArena.h"
+#include "worldgen/utils/layerAllocator.h"
+
+#include <cassert>
+
+namespace worldgen
+{
+
+GenerationArena::GenerationArena(size_t slotCount):
+    m_slabs(slotCount),
+    m_allocations(0)
+{
+}
+
+GenerationArena::~GenerationArena()
+{
+    release();
+}
+
+void *GenerationArena::slab(size_t slot, size_t bytes)
+{
+    assert(slot<m_slabs.size());
+
+    Slab &slab=m_slabs[slot];
+
+    if(bytes<=slab.capacity)
+        return slab.data;
+
+    //old contents are not kept, no reason to copy them
+    freeLayerMemory(slab.data, slab.capacity);
+    slab.data=allocateLayerMemory(bytes);
+    slab.capacity=slab.data?bytes:0;
+    ++m_allocations;
+    return slab.data;
+}
+
+void GenerationArena::release()
+{
+    for(Slab &slab:m_slabs)
+    {
+        freeLayerMemory(slab.data, slab.capacity);
+        slab.data=nullptr;
+        slab.capacity=0;
+    }
+}
+
+size_t GenerationArena::reservedBytes() const
+{
+    size_t bytes=0;
+
+    for(const Slab &slab:m_slabs)
+        bytes+=slab.capacity;
+    return bytes;
+}
+
+}//namespace worldgen
@@ -0,0 +1,150 @@
+#include "worldgen/utils/layerAllocator.h"
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/trace.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace worldgen
+{
+
+namespace
+{
+
+constexpr size_t Alignment=64;
+constexpr size_t HugePageSize=2*1024*1024;
+
+std::atomic<int> g_hugePages((int)HugePages::Off);
+std::atomic<bool> g_parallelFirstTouch(false);
+std::atomic<size_t> g_layerAllocations(0);
+
+size_t roundUp(size_t value, size_t multiple)
+{
+    return (value+multiple-1)/multiple*multiple;
+}
+
+size_t pageSize()
+{
+#ifdef _WIN32
+    return 4096;
+#else
+    static const size_t size=(size_t)sysconf(_SC_PAGESIZE);
+
+    return size;
+#endif
+}
+
+//one write per page is enough to fault it in, chunks are a huge page so a huge page is only ever raced for
+//by neighboring chunks
+void firstTouch(void *data, size_t bytes)
+{
+    const size_t page=pageSize();
+    const size_t pages=(bytes+page-1)/page;
+    volatile char *base=(volatile char *)data;
+
+    ThreadPool::global().parallelFor(0, pages, HugePageSize/page, [base, page](size_t begin, size_t end)
+        {
+            for(size_t i=begin; i<end; ++i)
+                base[i*page]=0;
+        });
+}
+
+#ifndef _WIN32
+void *mapLayer(size_t size, HugePages hugePages)
+{
+    void *data=MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if(hugePages==HugePages::Explicit)
+        data=mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+#endif
+
+    if(data==MAP_FAILED)
+    {
+        data=mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+        if(data==MAP_FAILED)
+            return nullptr;
+
+#ifdef MADV_HUGEPAGE
+        if(hugePages!=HugePages::Off)
+            madvise(data, size, MADV_HUGEPAGE);
+#endif
+    }
+    return data;
+}
+#endif
+
+}//namespace
+
+void setLayerMemoryPolicy(const LayerMemoryPolicy &policy)
+{
+    g_hugePages.store((int)policy.hugePages);
+    g_parallelFirstTouch.store(policy.parallelFirstTouch);
+}
+
+LayerMemoryPolicy getLayerMemoryPolicy()
+{
+    LayerMemoryPolicy policy;
+
+    policy.hugePages=(HugePages)g_hugePages.load();
+    policy.parallelFirstTouch=g_parallelFirstTouch.load();
+    return policy;
+}
+
+void *allocateLayerMemory(size_t bytes)
+{
+    bool large=(bytes>=LargeLayerBytes);
+    void *data;
+
+    g_layerAllocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef _WIN32
+    data=_aligned_malloc(roundUp(std::max(bytes, (size_t)1), Alignment), Alignment);
+#else
+    //large layers are mapped whole huge pages at a time, pages past bytes are never touched so they cost
+    //address space only
+    if(large)
+        data=mapLayer(roundUp(bytes, HugePageSize), (HugePages)g_hugePages.load());
+    else
+        data=std::aligned_alloc(Alignment, roundUp(std::max(bytes, (size_t)1), Alignment));
+#endif
+
+    if(!data)
+        return nullptr;
+
+    traceLayerBytes().add((int64_t)bytes);
+    if(large && g_parallelFirstTouch.load())
+        firstTouch(data, bytes);
+    return data;
+}
+
+void freeLayerMemory(void *data, size_t bytes)
+{
+    if(!data)
+        return;
+
+    traceLayerBytes().add(-(int64_t)bytes);
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    if(bytes>=LargeLayerBytes)
+        munmap(data, roundUp(bytes, HugePageSize));
+    else
+        std::free(data);
+#endif
+}
+
+size_t getLayerAllocationCount()
+{
+    return g_layerAllocations.load(std::memory_order_relaxed);
+}
+
+}//namespace worldgen
@@ -0,0 +1,118 @@
+#include "worldgen/utils/simdLevel.h"
+
+#include <FastSIMD/FastSIMD.h>
+
+namespace worldgen
+{
+
+namespace
+{
+
+struct SimdLevelInfo
+{
+    SimdLevel level;
+    const char *name;
+    FastSIMD::eLevel fastSimd;
+};
+
+//in increasing order within an architecture
+const SimdLevelInfo g_simdLevels[]=
+{
+    {SimdLevel::Auto, "auto", FastSIMD::Level_Null},
+    {SimdLevel::Scalar, "scalar", FastSIMD::Level_Scalar},
+    {SimdLevel::SSE2, "sse2", FastSIMD::Level_SSE2},
+    {SimdLevel::SSE41, "sse41", FastSIMD::Level_SSE41},
+    {SimdLevel::AVX2, "avx2", FastSIMD::Level_AVX2},
+    {SimdLevel::AVX512, "avx512", FastSIMD::Level_AVX512},
+    {SimdLevel::NEON, "neon", FastSIMD::Level_NEON}
+};
+
+bool isArm(FastSIMD::eLevel level)
+{
+    return level>=FastSIMD::Level_NEON;
+}
+
+}//namespace
+
+const char *simdLevelName(SimdLevel level)
+{
+    for(const SimdLevelInfo &info:g_simdLevels)
+    {
+        if(info.level==level)
+            return info.name;
+    }
+    return "unknown";
+}
+
+bool parseSimdLevel(const std::string &name, SimdLevel &level)
+{
+    for(const SimdLevelInfo &info:g_simdLevels)
+    {
+        if(name==info.name)
+        {
+            level=info.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<SimdLevel> supportedSimdLevels()
+{
+    FastSIMD::eLevel maxLevel=FastSIMD::CPUMaxSIMDLevel();
+    std::vector<SimdLevel> levels;
+
+    for(const SimdLevelInfo &info:g_simdLevels)
+    {
+        if(info.level==SimdLevel::Auto)
+            continue;
+
+        //scalar runs everywhere, the rest only on their own architecture up to the cpu maximum
+        if((info.level==SimdLevel::Scalar)||((isArm(info.fastSimd)==isArm(maxLevel))&&(info.fastSimd<=maxLevel)))
+            levels.push_back(info.level);
+    }
+    return levels;
+}
+
+SimdLevel resolveSimdLevel(SimdLevel level)
+{
+    std::vector<SimdLevel> levels=supportedSimdLevels();
+
+    if(level==SimdLevel::Auto)
+        return levels.back();
+
+    SimdLevel resolved=SimdLevel::Scalar;
+    uint32_t requested=toFastSimdLevel(level);
+
+    for(SimdLevel supported:levels)
+    {
+        if(toFastSimdLevel(supported)<=requested)
+            resolved=supported;
+    }
+    return resolved;
+}
+
+uint32_t toFastSimdLevel(SimdLevel level)
+{
+    for(const SimdLevelInfo &info:g_simdLevels)
+    {
+        if(info.level==level)
+            return info.fastSimd;
+    }
+    return FastSIMD::Level_Null;
+}
+
+SimdLevel fromFastSimdLevel(uint32_t level)
+{
+    //FastSIMD levels between ours (sse3, ssse3, sse42, avx) report as the closest one below
+    SimdLevel result=SimdLevel::Auto;
+
+    for(const SimdLevelInfo &info:g_simdLevels)
+    {
+        if((info.level!=SimdLevel::Auto)&&(info.fastSimd<=level))
+            result=info.level;
+    }
+    return result;
+}
+
+}//namespace worldgen
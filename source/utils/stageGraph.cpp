@@ -0,0 +1,199 @@
+#include "worldgen/utils/stageGraph.h"
+#include "worldgen/utils/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <cassert>
+
+namespace worldgen
+{
+
+namespace chrono=std::chrono;
+
+void StageGraph::add(const char *name, std::vector<LayerId> inputs, std::vector<LayerId> outputs, StageTask task)
+{
+    size_t index=m_stages.size();
+    Stage stage;
+
+    stage.name=name;
+    stage.traceName=worldgen::traceName(stage.name);
+    stage.inputs=std::move(inputs);
+    stage.outputs=std::move(outputs);
+    stage.task=std::move(task);
+    stage.dependencyCount=0;
+
+    for(size_t i=0; i<index; ++i)
+    {
+        Stage &writer=m_stages[i];
+        bool dependent=false;
+
+        for(LayerId input:stage.inputs)
+        {
+            if(std::find(writer.outputs.begin(), writer.outputs.end(), input)!=writer.outputs.end())
+                dependent=true;
+        }
+
+#ifndef NDEBUG
+        for(LayerId output:stage.outputs)
+            assert(std::find(writer.outputs.begin(), writer.outputs.end(), output)==writer.outputs.end());
+#endif
+
+        if(dependent)
+        {
+            writer.dependents.push_back(index);
+            stage.dependencyCount++;
+        }
+    }
+
+    m_stages.push_back(std::move(stage));
+}
+
+//shared between the caller and the helper tasks. Helpers never wait, they take ready stages until there
+//are none and leave, a finishing stage submits a helper for each stage it made ready. Helpers scheduled
+//after the graph finished only look at the queue, stages/timings belong to the graph and are only touched
+//for a taken stage.
+struct StageGraph::RunState
+{
+    RunState(std::vector<Stage> &stages, std::vector<StageTiming> &timings, ThreadPool *pool):
+        stages(stages), timings(timings), pool(pool), stageCount(stages.size()), remaining(stages.size()), running(0), finished(0),
+        failed(false), start(chrono::steady_clock::now())
+    {
+        for(size_t i=0; i<stages.size(); ++i)
+        {
+            remaining[i]=stages[i].dependencyCount;
+            if(remaining[i]==0)
+                ready.push_back(i);
+        }
+    }
+
+    bool done() const
+    {
+        return (finished==stageCount)||(failed&&(running==0));
+    }
+
+    static void submitHelpers(const std::shared_ptr<RunState> &state, size_t count)
+    {
+        for(size_t i=0; i<count; ++i)
+            state->pool->submit([state]() { while(runStage(state)); });
+    }
+
+    //runs one ready stage, returns false if none is ready
+    static bool runStage(const std::shared_ptr<RunState> &state)
+    {
+        size_t index;
+
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+
+            if(state->ready.empty())
+                return false;
+
+            index=state->ready.front();
+            state->ready.pop_front();
+            state->running++;
+        }
+
+        Stage &stage=state->stages[index];
+        chrono::steady_clock::time_point stageStart=chrono::steady_clock::now();
+
+        bool success;
+
+        {
+            TraceZone zone(stage.traceName);
+
+            success=stage.task();
+        }
+
+        StageTiming &timing=state->timings[index];
+
+        timing.name=stage.name;
+        timing.startMs=chrono::duration<double, std::milli>(stageStart-state->start).count();
+        timing.ms=chrono::duration<double, std::milli>(chrono::steady_clock::now()-stageStart).count();
+
+        size_t madeReady=0;
+
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+
+            state->running--;
+            state->finished++;
+
+            if(!success)
+            {
+                state->failed=true;
+                state->ready.clear();
+            }
+            else if(!state->failed)
+            {
+                for(size_t dependent:stage.dependents)
+                {
+                    if(--state->remaining[dependent]==0)
+                    {
+                        state->ready.push_back(dependent);
+                        madeReady++;
+                    }
+                }
+            }
+        }
+        state->event.notify_all();
+
+        if(state->pool)
+            submitHelpers(state, madeReady);
+        return true;
+    }
+
+    std::vector<Stage> &stages;
+    std::vector<StageTiming> &timings;
+    ThreadPool *pool;
+    size_t stageCount;
+
+    std::mutex mutex;
+    //only the caller of run waits on this
+    std::condition_variable event;
+    std::deque<size_t> ready;
+    std::vector<size_t> remaining;
+    size_t running;
+    size_t finished;
+    bool failed;
+
+    chrono::steady_clock::time_point start;
+};
+
+bool StageGraph::run(ThreadPool *pool)
+{
+    m_timings.assign(m_stages.size(), StageTiming{std::string(), 0.0, -1.0});
+
+    std::shared_ptr<RunState> state=std::make_shared<RunState>(m_stages, m_timings, pool);
+
+    //the calling thread takes the first ready stage itself
+    if(pool && (state->ready.size()>1))
+        RunState::submitHelpers(state, std::min(state->ready.size()-1, pool->size()));
+
+    //without a pool the caller runs the whole graph. With one it takes ready stages too and only waits
+    //while stages are running elsewhere, like parallelFor waiting on its last chunks
+    bool failed;
+
+    while(true)
+    {
+        while(RunState::runStage(state));
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+
+        state->event.wait(lock, [&state]() { return !state->ready.empty()||state->done(); });
+
+        if(state->done())
+        {
+            failed=state->failed;
+            break;
+        }
+    }
+
+    //drop stages that never ran
+    m_timings.erase(std::remove_if(m_timings.begin(), m_timings.end(), [](const StageTiming &timing) { return timing.ms<0.0; }), m_timings.end());
+    return !failed;
+}
+
+}//namespace worldgen
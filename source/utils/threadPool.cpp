@@ -0,0 +1,161 @@
+#include "worldgen/utils/threadPool.h"
+#include "worldgen/utils/trace.h"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace worldgen
+{
+
+ThreadPool::ThreadPool(size_t threads):
+    m_shutdown(false)
+{
+    if(threads==0)
+        threads=std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_threads.reserve(threads);
+    for(size_t i=0; i<threads; ++i)
+        m_threads.emplace_back(&ThreadPool::worker, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_shutdown=true;
+    }
+    m_event.notify_all();
+
+    for(std::thread &thread:m_threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Task task)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_tasks.push_back(std::move(task));
+    }
+    m_event.notify_one();
+}
+
+void ThreadPool::worker()
+{
+    setTraceThreadName("worldgen worker");
+
+    while(true)
+    {
+        Task task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_event.wait(lock, [this]() { return m_shutdown||!m_tasks.empty(); });
+
+            if(m_tasks.empty())
+                return;
+
+            task=std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+namespace
+{
+
+//shared between the caller and the helper tasks, helpers can outlive the parallelFor call if they
+//only get scheduled after the caller has finished all the chunks itself
+struct ParallelForState
+{
+    ParallelForState(size_t begin, size_t end, size_t grain, const ThreadPool::RangeTask &task):
+        begin(begin), end(end), grain(grain), chunks((end-begin+grain-1)/grain), task(task), next(0), done(0)
+    {}
+
+    //returns false once no chunks are left to take
+    bool runChunk()
+    {
+        size_t chunk=next.fetch_add(1, std::memory_order_relaxed);
+
+        if(chunk>=chunks)
+            return false;
+
+        size_t chunkBegin=begin+chunk*grain;
+        size_t chunkEnd=std::min(chunkBegin+grain, end);
+
+        task(chunkBegin, chunkEnd);
+
+        if(done.fetch_add(1, std::memory_order_acq_rel)+1==chunks)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            event.notify_all();
+        }
+        return true;
+    }
+
+    size_t begin;
+    size_t end;
+    size_t grain;
+    size_t chunks;
+    ThreadPool::RangeTask task;
+
+    std::atomic<size_t> next;
+    std::atomic<size_t> done;
+    std::mutex mutex;
+    std::condition_variable event;
+};
+
+}//namespace
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const RangeTask &task)
+{
+    if(begin>=end)
+        return;
+
+    grain=std::max(grain, (size_t)1);
+
+    size_t chunks=(end-begin+grain-1)/grain;
+
+    if((chunks==1)||m_threads.empty())
+    {
+        task(begin, end);
+        return;
+    }
+
+    std::shared_ptr<ParallelForState> state=std::make_shared<ParallelForState>(begin, end, grain, task);
+    size_t helpers=std::min(chunks-1, m_threads.size());
+
+    for(size_t i=0; i<helpers; ++i)
+        submit([state]() { while(state->runChunk()); });
+
+    while(state->runChunk());
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+
+    state->event.wait(lock, [&state]() { return state->done.load(std::memory_order_acquire)==state->chunks; });
+}
+
+namespace
+{
+std::atomic<size_t> g_globalThreads(0);
+}
+
+ThreadPool &ThreadPool::global()
+{
+    static ThreadPool pool(g_globalThreads.load());
+
+    return pool;
+}
+
+void ThreadPool::setGlobalThreads(size_t threads)
+{
+    g_globalThreads.store(threads);
+}
+
+}//namespace worldgen
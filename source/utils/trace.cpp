@@ -0,0 +1,275 @@
+#include "worldgen/utils/trace.h"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_set>
+#include <cstdio>
+
+namespace worldgen
+{
+
+std::atomic<bool> g_traceEnabled(false);
+
+namespace
+{
+
+namespace chrono=std::chrono;
+
+enum class TraceType:uint8_t
+{
+    Complete,
+    Counter
+};
+
+struct TraceEvent
+{
+    const char *name;
+    uint64_t start;
+    //duration for zones, value for counters
+    int64_t value;
+    TraceType type;
+};
+
+//Only the owning thread writes, the export reads up to count. A buffer outlives its thread and is handed
+//to the next new thread, so short lived threads (async loads) do not grow the trace without bound.
+struct ThreadBuffer
+{
+    uint32_t threadId;
+    const char *threadName=nullptr;
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> count{0};
+};
+
+struct TraceState
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::vector<ThreadBuffer *> freeBuffers;
+    std::unordered_set<std::string> names;
+    chrono::steady_clock::time_point epoch=chrono::steady_clock::now();
+};
+
+TraceState &state()
+{
+    static TraceState *traceState=new TraceState();
+
+    return *traceState;
+}
+
+//returns the buffer to the free list when the thread exits
+struct ThreadBufferHandle
+{
+    ~ThreadBufferHandle()
+    {
+        if(!buffer)
+            return;
+
+        TraceState &traceState=state();
+        std::unique_lock<std::mutex> lock(traceState.mutex);
+
+        traceState.freeBuffers.push_back(buffer);
+    }
+
+    ThreadBuffer *buffer=nullptr;
+};
+
+thread_local ThreadBufferHandle t_buffer;
+//kept apart from the buffer so naming a thread does not allocate one
+thread_local const char *t_threadName=nullptr;
+
+ThreadBuffer &threadBuffer()
+{
+    if(t_buffer.buffer)
+        return *t_buffer.buffer;
+
+    TraceState &traceState=state();
+    std::unique_lock<std::mutex> lock(traceState.mutex);
+
+    if(!traceState.freeBuffers.empty())
+    {
+        t_buffer.buffer=traceState.freeBuffers.back();
+        traceState.freeBuffers.pop_back();
+    }
+    else
+    {
+        traceState.buffers.emplace_back(new ThreadBuffer());
+        t_buffer.buffer=traceState.buffers.back().get();
+        t_buffer.buffer->threadId=(uint32_t)traceState.buffers.size();
+        t_buffer.buffer->events.resize(TraceBufferEvents);
+    }
+    t_buffer.buffer->threadName=t_threadName;
+    return *t_buffer.buffer;
+}
+
+void record(const TraceEvent &event)
+{
+    ThreadBuffer &buffer=threadBuffer();
+    size_t count=buffer.count.load(std::memory_order_relaxed);
+
+    buffer.events[count%TraceBufferEvents]=event;
+    buffer.count.store(count+1, std::memory_order_release);
+}
+
+}//namespace
+
+void setTraceEnabled(bool enabled)
+{
+    //sets the epoch before the first event
+    state();
+    g_traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+const char *traceName(const std::string &name)
+{
+    TraceState &traceState=state();
+    std::unique_lock<std::mutex> lock(traceState.mutex);
+
+    return traceState.names.insert(name).first->c_str();
+}
+
+void setTraceThreadName(const char *name)
+{
+    t_threadName=name;
+    if(t_buffer.buffer)
+        t_buffer.buffer->threadName=name;
+}
+
+uint64_t traceNow()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-state().epoch).count();
+}
+
+void traceComplete(const char *name, uint64_t startNs, uint64_t endNs)
+{
+    record({name, startNs, (int64_t)(endNs-startNs), TraceType::Complete});
+}
+
+void TraceCounter::record(int64_t value)
+{
+    worldgen::record({m_name, traceNow(), value, TraceType::Counter});
+}
+
+TraceCounter &traceCellsProcessed()
+{
+    static TraceCounter counter("cellsProcessed");
+
+    return counter;
+}
+
+TraceCounter &traceLayerBytes()
+{
+    static TraceCounter counter("layerBytes");
+
+    return counter;
+}
+
+void clearTrace()
+{
+    TraceState &traceState=state();
+    std::unique_lock<std::mutex> lock(traceState.mutex);
+
+    for(std::unique_ptr<ThreadBuffer> &buffer:traceState.buffers)
+        buffer->count.store(0, std::memory_order_relaxed);
+}
+
+std::string exportChromeTrace()
+{
+    TraceState &traceState=state();
+    std::unique_lock<std::mutex> lock(traceState.mutex);
+
+    rapidjson::StringBuffer stringBuffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(stringBuffer);
+
+    writer.StartObject();
+    writer.Key("displayTimeUnit");
+    writer.String("ms");
+    writer.Key("traceEvents");
+    writer.StartArray();
+
+    for(std::unique_ptr<ThreadBuffer> &buffer:traceState.buffers)
+    {
+        size_t count=buffer->count.load(std::memory_order_acquire);
+
+        if(count==0)
+            continue;
+
+        if(buffer->threadName)
+        {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String("thread_name");
+            writer.Key("ph");
+            writer.String("M");
+            writer.Key("pid");
+            writer.Int(1);
+            writer.Key("tid");
+            writer.Uint(buffer->threadId);
+            writer.Key("args");
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(buffer->threadName);
+            writer.EndObject();
+            writer.EndObject();
+        }
+
+        //oldest first, once wrapped the first count-TraceBufferEvents events are gone
+        size_t first=(count>TraceBufferEvents)?count-TraceBufferEvents:0;
+
+        for(size_t i=first; i<count; ++i)
+        {
+            const TraceEvent &event=buffer->events[i%TraceBufferEvents];
+
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(event.name);
+            writer.Key("ph");
+            writer.String((event.type==TraceType::Complete)?"X":"C");
+            writer.Key("pid");
+            writer.Int(1);
+            writer.Key("tid");
+            writer.Uint(buffer->threadId);
+            //chrome wants microseconds
+            writer.Key("ts");
+            writer.Double(event.start/1000.0);
+            if(event.type==TraceType::Complete)
+            {
+                writer.Key("dur");
+                writer.Double(event.value/1000.0);
+            }
+            else
+            {
+                writer.Key("args");
+                writer.StartObject();
+                writer.Key("value");
+                writer.Int64(event.value);
+                writer.EndObject();
+            }
+            writer.EndObject();
+        }
+    }
+
+    writer.EndArray();
+    writer.EndObject();
+    return std::string(stringBuffer.GetString(), stringBuffer.GetSize());
+}
+
+bool writeChromeTrace(const std::string &fileName)
+{
+    std::string json=exportChromeTrace();
+    FILE *file=fopen(fileName.c_str(), "w");
+
+    if(!file)
+        return false;
+
+    size_t written=fwrite(json.data(), 1, json.size(), file);
+
+    fclose(file);
+    return (written==json.size());
+}
+
+}//namespace worldgen
@@ -0,0 +1,95 @@
+//Several worlds with different seeds generated at the same time, one thread each, all sharing the global
+//pool for their stages. Each world's layers and influence map have to be byte identical to the same seed
+//generated on its own.
+#include "worldgen/generators/equiRectWorldGenerator.h"
+#include "testWorlds.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <thread>
+
+typedef std::vector<unsigned char> Snapshot;
+
+template<typename _Type>
+void append(Snapshot &snapshot, const _Type *data, size_t count)
+{
+    size_t offset=snapshot.size();
+
+    snapshot.resize(offset+count*sizeof(_Type));
+    if(count>0)
+        memcpy(snapshot.data()+offset, data, count*sizeof(_Type));
+}
+
+//field by field, InfluenceCell has padding
+void appendCell(Snapshot &snapshot, const worldgen::InfluenceCell &cell)
+{
+    float values[]={cell.heightBase, cell.plateValue, cell.plateDistanceValue, cell.continentValue, cell.collision, cell.terrainScale,
+        cell.temperature, cell.moisture, cell.moistureCapacity, cell.direction.x, cell.direction.y, cell.airDirection.x, cell.airDirection.y};
+    size_t indices[]={cell.tectonicPlate, cell.borderPlate, cell.weatherCell, cell.weatherBand};
+
+    append(snapshot, values, sizeof(values)/sizeof(float));
+    append(snapshot, indices, sizeof(indices)/sizeof(size_t));
+}
+
+bool generate(int seed, Snapshot &snapshot)
+{
+    worldgen::WorldDescriptors descriptors=worldgen::makeDescriptors(256, seed);
+    worldgen::EquiRectWorldGenerator generator;
+    worldgen::Progress progress;
+
+    generator.loadDescriptors(&descriptors);
+    generator.setLayerRetention(worldgen::LayerRetention::All);
+
+    if(!generator.generateWorldOverview(progress))
+        return false;
+
+    const worldgen::GenerationLayers &layers=generator.getLayers();
+    const worldgen::LayerBuffer *buffers[]={&layers.heightMap, &layers.terrainScale, &layers.nsAirCurrent, &layers.ewAirCurrent,
+        &layers.plateMap, &layers.plate2Map, &layers.plateDistance, &layers.continentMap, &layers.plateScaleMap, &layers.plate2ScaleMap};
+
+    snapshot.clear();
+    for(const worldgen::LayerBuffer *buffer:buffers)
+        append(snapshot, buffer->data(), buffer->size());
+
+    for(const worldgen::InfluenceCell &cell:generator.getInfluenceMap())
+        appendCell(snapshot, cell);
+    return true;
+}
+
+int main()
+{
+    const std::vector<int> seeds={1, 7, 42, 1234};
+    std::vector<Snapshot> expected(seeds.size());
+
+    for(size_t i=0; i<seeds.size(); ++i)
+    {
+        if(!generate(seeds[i], expected[i]))
+        {
+            printf("seed %d: serial generation failed\n", seeds[i]);
+            return 1;
+        }
+    }
+
+    std::vector<Snapshot> concurrent(seeds.size());
+    std::vector<char> generated(seeds.size(), 0);
+    std::vector<std::thread> threads;
+
+    for(size_t i=0; i<seeds.size(); ++i)
+        threads.emplace_back([&, i]() { generated[i]=generate(seeds[i], concurrent[i]); });
+
+    for(std::thread &thread:threads)
+        thread.join();
+
+    bool passed=true;
+
+    for(size_t i=0; i<seeds.size(); ++i)
+    {
+        bool identical=generated[i]&&(concurrent[i]==expected[i]);
+
+        printf("seed %d: %zu bytes %s\n", seeds[i], expected[i].size(), identical?"identical":(generated[i]?"DIFFERENT":"FAILED"));
+        passed=passed&&identical;
+    }
+
+    return passed?0:1;
+}
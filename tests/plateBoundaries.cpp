@@ -0,0 +1,187 @@
+//Plate boundaries and their distance transform against brute force on small plate maps. The boundaries are
+//added whole and in bands of several sizes, with one instance reused through reset for every case, and the
+//distances are checked over the whole map and over bands of it.
+#include "worldgen/plateBoundaries.h"
+#include "worldgen/utils/threadPool.h"
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+const double Pi=3.14159265358979323846;
+
+//nearest of a few random sites, wrapping in x, so plates are blobs with boundaries of any direction
+std::vector<float> makePlateMap(int width, int height, int plates, unsigned int seed)
+{
+    std::vector<int> sitesX(plates);
+    std::vector<int> sitesY(plates);
+    std::vector<float> plateMap((size_t)width*height);
+
+    for(int i=0; i<plates; ++i)
+    {
+        seed=seed*1664525u+1013904223u;
+        sitesX[i]=(int)((seed>>8)%(unsigned int)width);
+        seed=seed*1664525u+1013904223u;
+        sitesY[i]=(int)((seed>>8)%(unsigned int)height);
+    }
+
+    for(int y=0; y<height; ++y)
+    {
+        for(int x=0; x<width; ++x)
+        {
+            int closest=0;
+            int closestDistance=std::numeric_limits<int>::max();
+
+            for(int i=0; i<plates; ++i)
+            {
+                int dx=std::abs(x-sitesX[i]);
+                int dy=y-sitesY[i];
+
+                dx=std::min(dx, width-dx);
+                if(dx*dx+dy*dy<closestDistance)
+                {
+                    closestDistance=dx*dx+dy*dy;
+                    closest=i;
+                }
+            }
+            plateMap[(size_t)y*width+x]=(float)closest;
+        }
+    }
+    return plateMap;
+}
+
+bool bruteBoundary(const std::vector<float> &plateMap, int width, int height, int x, int y)
+{
+    float plate=plateMap[(size_t)y*width+x];
+
+    if((plate!=plateMap[(size_t)y*width+(x+1)%width])||(plate!=plateMap[(size_t)y*width+(x+width-1)%width]))
+        return true;
+    if((y>0)&&(plate!=plateMap[(size_t)(y-1)*width+x]))
+        return true;
+    if((y+1<height)&&(plate!=plateMap[(size_t)(y+1)*width+x]))
+        return true;
+    return false;
+}
+
+//same metric as boundaryDistance, x scaled by the cosine of the latitude of the cell measured from
+float bruteDistance(const worldgen::PlateBoundaries &boundaries, int x, int y)
+{
+    int width=boundaries.width();
+    int height=boundaries.height();
+    double scale=std::sin(Pi*((double)y+0.5)/height);
+    double closest=std::numeric_limits<double>::infinity();
+
+    for(int by=0; by<height; ++by)
+    {
+        for(int bx=0; bx<width; ++bx)
+        {
+            if(!boundaries.boundary(bx, by))
+                continue;
+
+            int dx=std::abs(x-bx);
+
+            dx=std::min(dx, width-dx);
+
+            double distance=scale*scale*dx*dx+(double)(y-by)*(y-by);
+
+            closest=std::min(closest, distance);
+        }
+    }
+    return (float)std::sqrt(closest);
+}
+
+bool check(worldgen::PlateBoundaries &boundaries, const std::vector<float> &plateMap, int width, int height, int bandRows,
+    worldgen::ThreadPool *pool)
+{
+    boundaries.reset(width, height);
+    for(int row=0; row<height; row+=bandRows)
+    {
+        int rowEnd=std::min(row+bandRows, height);
+
+        boundaries.addRows(plateMap.data()+(size_t)row*width, row, rowEnd);
+    }
+
+    size_t wrongBoundaries=0;
+
+    for(int y=0; y<height; ++y)
+    {
+        for(int x=0; x<width; ++x)
+        {
+            if(boundaries.boundary(x, y)!=bruteBoundary(plateMap, width, height, x, y))
+                wrongBoundaries++;
+        }
+    }
+
+    size_t wrongDistances=0;
+    float worstError=0.0f;
+
+    //the whole map, then the same map a band at a time
+    for(int distanceRows:{height, 7})
+    {
+        for(int row=0; row<height; row+=distanceRows)
+        {
+            int rowEnd=std::min(row+distanceRows, height);
+            std::vector<float> distance((size_t)width*(rowEnd-row));
+
+            worldgen::boundaryDistance(boundaries, row, rowEnd, distance.data(), pool);
+
+            for(int y=row; y<rowEnd; ++y)
+            {
+                for(int x=0; x<width; ++x)
+                {
+                    float expected=bruteDistance(boundaries, x, y);
+                    float actual=distance[(size_t)(y-row)*width+x];
+
+                    if(std::isinf(expected)||std::isinf(actual))
+                    {
+                        if(expected!=actual)
+                            wrongDistances++;
+                        continue;
+                    }
+
+                    float error=std::abs(actual-expected);
+
+                    worstError=std::max(worstError, error);
+                    if(error>1e-3f*std::max(1.0f, expected))
+                        wrongDistances++;
+                }
+            }
+        }
+    }
+
+    bool passed=(wrongBoundaries==0)&&(wrongDistances==0);
+
+    printf("%dx%d band rows %d: %zu wrong boundaries, %zu wrong distances (worst error %g) %s\n", width, height, bandRows,
+        wrongBoundaries, wrongDistances, worstError, passed?"ok":"FAILED");
+    return passed;
+}
+
+int main()
+{
+    worldgen::ThreadPool pool(4);
+    //one instance for every case, each reset has to forget the rows of the case before
+    worldgen::PlateBoundaries boundaries;
+    bool passed=true;
+
+    struct Case
+    {
+        int width;
+        int height;
+        int plates;
+    };
+
+    for(const Case &test:{Case{64, 32, 12}, Case{37, 70, 5}, Case{128, 64, 30}, Case{16, 8, 1}})
+    {
+        std::vector<float> plateMap=makePlateMap(test.width, test.height, test.plates, (unsigned int)(test.width*31+test.height));
+
+        for(int bandRows:{test.height, 1, 5, 13})
+        {
+            passed=check(boundaries, plateMap, test.width, test.height, bandRows, &pool)&&passed;
+            passed=check(boundaries, plateMap, test.width, test.height, bandRows, nullptr)&&passed;
+        }
+    }
+
+    return passed?0:1;
+}
@@ -0,0 +1,89 @@
+//Streamed generation against a whole map generation of the same world. Everything but moisture has to match
+//exactly, moisture to within what the halo cuts off (see StreamHaloRows). Band sizes below the halo have
+//halos spanning several bands, the first and last bands check the halos wrapping around the map.
+#include "worldgen/generators/equiRectWorldGenerator.h"
+#include "testWorlds.h"
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+bool generate(worldgen::EquiRectWorldGenerator &generator, worldgen::WorldDescriptors &descriptors, int bandRows)
+{
+    worldgen::Progress progress;
+
+    generator.loadDescriptors(&descriptors);
+    generator.setStreamingBandRows(bandRows);
+    return generator.generateWorldOverview(progress);
+}
+
+bool sameCell(const worldgen::InfluenceCell &lhs, const worldgen::InfluenceCell &rhs)
+{
+    return (lhs.heightBase==rhs.heightBase)&&(lhs.tectonicPlate==rhs.tectonicPlate)&&(lhs.borderPlate==rhs.borderPlate)&&
+        (lhs.plateDistanceValue==rhs.plateDistanceValue)&&(lhs.collision==rhs.collision)&&(lhs.terrainScale==rhs.terrainScale)&&
+        (lhs.temperature==rhs.temperature)&&(lhs.weatherCell==rhs.weatherCell)&&(lhs.moistureCapacity==rhs.moistureCapacity);
+}
+
+int main()
+{
+    const float moistureBound=std::pow(0.5f, 16);
+    worldgen::WorldDescriptors descriptors=worldgen::makeDescriptors(256, 7);
+    worldgen::EquiRectWorldGenerator whole;
+
+    if(!generate(whole, descriptors, 0))
+    {
+        printf("whole map generation failed\n");
+        return 1;
+    }
+
+    const worldgen::EquiRectWorldGenerator::InfluenceMap &expected=whole.getInfluenceMap();
+    int width=whole.getInfluenceMapSize().x;
+    bool passed=true;
+
+    for(int bandRows:{8, 20, 50})
+    {
+        worldgen::EquiRectWorldGenerator streamed;
+
+        if(!generate(streamed, descriptors, bandRows))
+        {
+            printf("band rows %d: generation failed\n", bandRows);
+            passed=false;
+            continue;
+        }
+
+        const worldgen::EquiRectWorldGenerator::InfluenceMap &cells=streamed.getInfluenceMap();
+
+        if(cells.size()!=expected.size())
+        {
+            printf("band rows %d: %zu cells, expected %zu\n", bandRows, cells.size(), expected.size());
+            passed=false;
+            continue;
+        }
+
+        size_t mismatched=0;
+        float moistureError=0.0f;
+        size_t worstCell=0;
+
+        for(size_t i=0; i<cells.size(); ++i)
+        {
+            if(!sameCell(cells[i], expected[i]))
+                mismatched++;
+
+            float error=std::abs(cells[i].moisture-expected[i].moisture);
+
+            if(error>moistureError)
+            {
+                moistureError=error;
+                worstCell=i;
+            }
+        }
+
+        bool bandPassed=(mismatched==0)&&(moistureError<=moistureBound);
+
+        printf("band rows %d: %zu mismatched cells, moisture error %g (row %zu, bound %g) %s\n", bandRows, mismatched, moistureError,
+            worstCell/width, moistureBound, bandPassed?"ok":"FAILED");
+        passed=passed&&bandPassed;
+    }
+
+    return passed?0:1;
+}
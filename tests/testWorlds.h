@@ -0,0 +1,35 @@
+#ifndef _worldgen_testWorlds_h_
+#define _worldgen_testWorlds_h_
+
+#include "worldgen/worldDescriptors.h"
+
+#include <string>
+
+namespace worldgen
+{
+
+//same world layout the cli and viewer use, scaled so the influence map is influenceWidth wide, generator
+//args left to the generator's defaults
+inline WorldDescriptors makeDescriptors(int influenceWidth)
+{
+    WorldDescriptors descriptors;
+    int gridSize=4096;
+
+    descriptors.setSize(glm::ivec3(influenceWidth*gridSize, influenceWidth/2*gridSize, 2560));
+    descriptors.setRegionSize(glm::ivec3(16, 16, 16));
+    descriptors.setChunkSize(glm::ivec3(64, 64, 16));
+    return descriptors;
+}
+
+//the same world with its seed set
+inline WorldDescriptors makeDescriptors(int influenceWidth, int seed)
+{
+    WorldDescriptors descriptors=makeDescriptors(influenceWidth);
+
+    descriptors.getGeneratorArgs()="{\"seed\": "+std::to_string(seed)+"}";
+    return descriptors;
+}
+
+}//namespace worldgen
+
+#endif //_worldgen_testWorlds_h_